@@ -0,0 +1,170 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_AttackChainAsset.h"
+#include "Animation/AnimSequence.h"
+#include "UObject/ObjectSaveContext.h"
+#include "HLtC_CombatSystemCharacter.h"
+
+const FHLtC_DodgeMoveDefinition& UHLtC_AttackChainAsset::GetDodge(EHLtC_DodgeDirection Direction) const
+{
+	switch (Direction)
+	{
+	case EHLtC_DodgeDirection::Backward: return DodgeBackward;
+	case EHLtC_DodgeDirection::Left: return DodgeLeft;
+	case EHLtC_DodgeDirection::Right: return DodgeRight;
+	default: return DodgeForward;
+	}
+}
+
+#if WITH_EDITOR
+void UHLtC_AttackChainAsset::PreSave(FObjectPreSaveContext SaveContext)
+{
+	BakeRootMotion(); // Saving and cooking both pass through here, so the samples always match the animations
+	Super::PreSave(SaveContext);
+}
+
+void UHLtC_AttackChainAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeRootMotion();
+	FHLtC_AttackChainRegistry::Get().InvalidateWeapon(this); // Characters spawned after the edit pick up the recompiled moves
+}
+
+void UHLtC_AttackChainAsset::BakeRootMotion()
+{
+	const FRotator MeshRotation(0.0f, MeshYaw, 0.0f);
+
+	for (FHLtC_DodgeMoveDefinition* Dodge : { &DodgeForward, &DodgeBackward, &DodgeLeft, &DodgeRight })
+	{
+		Dodge->RootMotionSamples.Reset();
+		if (Dodge->Animation == nullptr)
+		{
+			continue;
+		}
+
+		const float PlayLength = Dodge->Animation->GetPlayLength();
+		const int32 NumSamples = FMath::Max(FMath::CeilToInt(PlayLength * Dodge->SampleRate), 1) + 1;
+		Dodge->Duration = FMath::Max(PlayLength, 0.01f);
+
+		Dodge->RootMotionSamples.Reserve(NumSamples);
+		for (int32 Sample = 0; Sample < NumSamples; Sample++)
+		{
+			const float Time = PlayLength * Sample / (NumSamples - 1);
+			const FVector Translation = MeshRotation.RotateVector(Dodge->Animation->ExtractRootMotionFromRange(0.0f, Time).GetTranslation()); // From the meshes space into the actors
+			Dodge->RootMotionSamples.Emplace(static_cast<float>(Translation.X), static_cast<float>(Translation.Y));
+		}
+	}
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_AttackChainRegistry
+
+FHLtC_AttackChainRegistry& FHLtC_AttackChainRegistry::Get()
+{
+	static FHLtC_AttackChainRegistry Registry;
+	return Registry;
+}
+
+uint8 FHLtC_AttackChainRegistry::RegisterWeapon(const UHLtC_AttackChainAsset* Asset)
+{
+	check(IsInGameThread());
+
+	if (Asset == nullptr)
+	{
+		return 0;
+	}
+
+	if (const uint8* Weapon = RegisteredAssets.Find(Asset))
+	{
+		return *Weapon;
+	}
+
+	const FString DebugName = Asset->GetPathName();
+
+	// The core links moves by index, so resolve the designers move names first
+	TMap<FName, uint16> MoveIndices;
+	MoveIndices.Reserve(Asset->Moves.Num());
+	for (int32 Index = 0; Index < Asset->Moves.Num(); Index++)
+	{
+		if (MoveIndices.Contains(Asset->Moves[Index].MoveName))
+		{
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("'%s' Move '%s' is defined more than once, only the first definition can be linked to."), *DebugName, *Asset->Moves[Index].MoveName.ToString());
+			continue;
+		}
+		MoveIndices.Add(Asset->Moves[Index].MoveName, static_cast<uint16>(Index));
+	}
+
+	auto ResolveLink = [&MoveIndices, &DebugName](FName MoveName) -> uint16
+	{
+		if (MoveName.IsNone())
+		{
+			return HLtC::InvalidMove;
+		}
+
+		if (const uint16* MoveIndex = MoveIndices.Find(MoveName))
+		{
+			return *MoveIndex;
+		}
+
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("'%s' Link to unknown move '%s' ends the chain instead."), *DebugName, *MoveName.ToString());
+		return HLtC::InvalidMove;
+	};
+
+	TArray<FHLtC_MoveDefinition> Definitions;
+	Definitions.Reserve(Asset->Moves.Num());
+	for (const FHLtC_AttackMoveDefinition& Move : Asset->Moves)
+	{
+		FHLtC_MoveDefinition& Definition = Definitions.AddDefaulted_GetRef();
+		Definition.Duration = Move.Duration;
+		Definition.BufferWindow = Move.BufferWindow;
+		Definition.NextOnLight = ResolveLink(Move.NextOnLight);
+		Definition.NextOnHeavy = ResolveLink(Move.NextOnHeavy);
+		Definition.bHeavy = Move.bHeavy;
+		Definition.Damage = Move.HitData.Damage;
+		Definition.Range = Move.HitData.Range;
+		Definition.Radius = Move.HitData.Radius;
+		Definition.ArcDegrees = Move.HitData.ArcDegrees;
+	}
+
+	// Dodges take their root motion from the baked samples, the animations aren't touched
+	FHLtC_DodgeDefinition Dodges[HLtC::NumDodgeDirections];
+	TArray<FHLtC_RootMotionSample> DodgeSamples[HLtC::NumDodgeDirections];
+	for (int32 Direction = 0; Direction < HLtC::NumDodgeDirections; Direction++)
+	{
+		const FHLtC_DodgeMoveDefinition& Dodge = Asset->GetDodge(static_cast<EHLtC_DodgeDirection>(Direction));
+		for (const FVector2f& Sample : Dodge.RootMotionSamples)
+		{
+			DodgeSamples[Direction].Add({ Sample.X, Sample.Y });
+		}
+
+		if (Dodge.Animation && DodgeSamples[Direction].Num() < 2)
+		{
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("'%s' Dodge animation '%s' has no baked root motion, resave the asset. Easing out over Distance instead."), *DebugName, *Dodge.Animation->GetName());
+		}
+
+		Dodges[Direction].Duration = Dodge.Duration;
+		Dodges[Direction].BufferWindow = Dodge.BufferWindow;
+		Dodges[Direction].InvulnerableStart = Dodge.InvulnerableStart;
+		Dodges[Direction].InvulnerableEnd = Dodge.InvulnerableEnd;
+		Dodges[Direction].Samples = DodgeSamples[Direction].GetData();
+		Dodges[Direction].NumSamples = DodgeSamples[Direction].Num();
+		Dodges[Direction].Distance = Dodge.Distance;
+	}
+
+	const int32 Weapon = MoveTable.AddWeapon(Definitions.GetData(), Definitions.Num(), ResolveLink(Asset->LightEntryMove), ResolveLink(Asset->HeavyEntryMove), Dodges);
+	if (Weapon == INDEX_NONE)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("'%s' Move table is full, falling back to the default attack chains."), *DebugName);
+		return 0;
+	}
+
+	RegisteredAssets.Add(Asset, static_cast<uint8>(Weapon));
+	return static_cast<uint8>(Weapon);
+}
+
+void FHLtC_AttackChainRegistry::InvalidateWeapon(const UHLtC_AttackChainAsset* Asset)
+{
+	RegisteredAssets.Remove(Asset);
+}
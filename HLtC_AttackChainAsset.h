@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "UObject/ObjectKey.h"
+#include "HLtC_CombatStateMachine.h"
+#include "HLtC_AttackChainAsset.generated.h"
+
+class UAnimSequence;
+
+/** What an attack does when its hit window opens */
+USTRUCT(BlueprintType)
+struct FHLtC_AttackHitData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hit)
+	float Damage = 10.0f; // Damage dealt to anything hit
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hit)
+	float Range = 150.0f; // Reach of the attack from the attackers location
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hit)
+	float Radius = 30.0f; // Thickness of the attack, added to the targets capsule radius
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hit, meta = (ClampMin = "0", ClampMax = "360"))
+	float ArcDegrees = 90.0f; // Width of the swing in front of the attacker
+};
+
+/** A single move of an attack chain, as authored by designers */
+USTRUCT(BlueprintType)
+struct FHLtC_AttackMoveDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move)
+	FName MoveName; // Unique name of the move within its asset, used by the links below
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move)
+	bool bHeavy = false; // If the move plays as a "HeavyAttack" action rather than a "LightAttack" action
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move, meta = (ClampMin = "0.01"))
+	float Duration = 0.7f; // Duration of the move, the player can't move until it concludes
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move, meta = (ClampMin = "0", ClampMax = "1"))
+	float BufferWindow = 0.5f; // Fraction of Duration that has to remain for a followup move to be triggered. Presses before that are buffered
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move)
+	FName NextOnLight; // Move that follows when a light attack is pressed during this move. None ends the chain
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move)
+	FName NextOnHeavy; // Move that follows when a heavy attack is pressed during this move. None ends the chain
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Move)
+	FHLtC_AttackHitData HitData;
+};
+
+/** A dodge in one direction, as authored by designers. Its root motion is baked into samples when the asset is saved or cooked, the game never reads the animation for it */
+USTRUCT(BlueprintType)
+struct FHLtC_DodgeMoveDefinition
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge)
+	TObjectPtr<UAnimSequence> Animation; // Root motion animation the dodge follows. Without one the dodge eases out over Distance
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "0.01"))
+	float Duration = 0.6f; // Duration of the dodge, the player can't move until it concludes. Taken from Animation when there is one
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "0", ClampMax = "1"))
+	float BufferWindow = 0.3f; // Fraction of Duration that has to remain for an attack or another dodge to cancel the dodge. Presses before that are buffered
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "0"))
+	float InvulnerableStart = 0.05f; // Seconds into the dodge the player stops being hittable
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "0"))
+	float InvulnerableEnd = 0.35f; // Seconds into the dodge the player can be hit again
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "0"))
+	float Distance = 400.0f; // Distance covered by a dodge without an animation
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodge, meta = (ClampMin = "1"))
+	float SampleRate = 30.0f; // Root motion samples baked per second of Animation
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Dodge)
+	TArray<FVector2f> RootMotionSamples; // Baked from Animation: forward and right displacement from the start, evenly spaced over Duration
+};
+
+/**
+ * The attack chains of a weapon. Compiled once into the shared move table, characters only keep a cursor into it.
+ */
+UCLASS(BlueprintType)
+class UHLtC_AttackChainAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Chains)
+	FName LightEntryMove; // Move started by a light attack when no chain is running
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Chains)
+	FName HeavyEntryMove; // Move started by a heavy attack when no chain is running
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Chains)
+	TArray<FHLtC_AttackMoveDefinition> Moves;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodges)
+	FHLtC_DodgeMoveDefinition DodgeForward;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodges)
+	FHLtC_DodgeMoveDefinition DodgeBackward;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodges)
+	FHLtC_DodgeMoveDefinition DodgeLeft;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodges)
+	FHLtC_DodgeMoveDefinition DodgeRight;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Dodges)
+	float MeshYaw = -90.0f; // Yaw of the characters mesh relative to the actor, which dodge animations move in. -90 for the template mannequin
+
+	const FHLtC_DodgeMoveDefinition& GetDodge(EHLtC_DodgeDirection Direction) const;
+
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	void BakeRootMotion(); // Samples the root motion of every dodge animation into its RootMotionSamples
+#endif
+};
+
+/**
+ * Owns the move table shared by every combatant and compiles attack chain assets into it.
+ * Assets are appended the first time they are used, moves are never modified or removed afterwards so indices stay valid.
+ * Shared by every world, so registering on the game thread can happen while another worlds simulation or validation reads the table off it. FHLtC_MoveTable never moves what it already holds, which keeps that safe.
+ */
+class FHLtC_AttackChainRegistry
+{
+public:
+	static FHLtC_AttackChainRegistry& Get();
+
+	/** Compiles an asset into the table if it hasn't been already and returns its weapon index. Null gets the built-in default chains */
+	uint8 RegisterWeapon(const UHLtC_AttackChainAsset* Asset);
+
+	/** Drops the weapon index cached for an asset, so that the next registration compiles its current moves */
+	void InvalidateWeapon(const UHLtC_AttackChainAsset* Asset);
+
+	const FHLtC_MoveTable& GetMoveTable() const { return MoveTable; }
+
+private:
+	FHLtC_MoveTable MoveTable; // Starts out holding the default chains as weapon 0
+	TMap<TObjectKey<UHLtC_AttackChainAsset>, uint8> RegisteredAssets;
+};
@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CameraRigComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "HLtC_CombatTuningAsset.h"
+
+namespace
+{
+	/** Triangle wave between -1 and 1 that starts at 0 and rises, with a period of 1 */
+	float TriangleWave(float Phase)
+	{
+		return 1.0f - 4.0f * FMath::Abs(FMath::Frac(Phase + 0.25f) - 0.5f);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UHLtC_CameraRigComponent
+
+UHLtC_CameraRigComponent::UHLtC_CameraRigComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false; // Woken up by the first targets
+	PrimaryComponentTick.TickGroup = TG_PostPhysics; // After the owner has moved this frame, like the spring arm
+}
+
+void UHLtC_CameraRigComponent::SetTargets(float InArmLength, const FVector& InSocketOffset, int32 InShakeSpeed)
+{
+	const int32 NewShakeSpeed = FMath::IsWithinInclusive(InShakeSpeed, 0, 1) ? InShakeSpeed : INDEX_NONE;
+	if (InArmLength == DesiredArmLength && InSocketOffset == DesiredSocketOffset && NewShakeSpeed == ShakeSpeed)
+	{
+		return;
+	}
+
+	if (NewShakeSpeed == INDEX_NONE) // Shakes restart from the middle, as the old integrated shake did
+	{
+		ShakeTime = 0.0f;
+	}
+
+	else if (ShakeSpeed != INDEX_NONE && NewShakeSpeed != ShakeSpeed) // Keep the phase of the wave when only its speed changes, so the camera doesn't jump
+	{
+		const UHLtC_CombatTuningAsset& Tune = UHLtC_CombatTuningAsset::Get(Tuning);
+		ShakeTime *= Tune.ShakeDeltaTimeDivision[NewShakeSpeed] / Tune.ShakeDeltaTimeDivision[ShakeSpeed];
+	}
+
+	DesiredArmLength = InArmLength;
+	DesiredSocketOffset = InSocketOffset;
+	ShakeSpeed = NewShakeSpeed;
+	Wake();
+}
+
+void UHLtC_CameraRigComponent::SetHeld(bool bInHeld)
+{
+	if (bHeld != bInHeld)
+	{
+		bHeld = bInHeld;
+		Wake();
+	}
+}
+
+void UHLtC_CameraRigComponent::Wake()
+{
+	SetComponentTickEnabled(Boom != nullptr && !bHeld);
+}
+
+bool UHLtC_CameraRigComponent::HasSettled() const
+{
+	const float SettleTolerance = UHLtC_CombatTuningAsset::Get(Tuning).SettleTolerance;
+	return ShakeSpeed == INDEX_NONE
+		&& FMath::IsNearlyEqual(Boom->TargetArmLength, DesiredArmLength, SettleTolerance)
+		&& Boom->SocketOffset.Equals(DesiredSocketOffset, SettleTolerance);
+}
+
+void UHLtC_CameraRigComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Boom == nullptr || bHeld)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	const UHLtC_CombatTuningAsset& Tune = UHLtC_CombatTuningAsset::Get(Tuning);
+
+	FVector SocketOffset = DesiredSocketOffset;
+	if (ShakeSpeed != INDEX_NONE)
+	{
+		// The wave the old per-frame integration traced: it crossed the full amplitude in Amplitude * Division seconds
+		ShakeTime += DeltaTime;
+		const float Period = 4.0f * Tune.ShakeAmplitude * Tune.ShakeDeltaTimeDivision[ShakeSpeed];
+		const float Shake = Period > UE_SMALL_NUMBER ? Tune.ShakeAmplitude * TriangleWave(ShakeTime / Period) : 0.0f;
+
+		const FVector ShakenSocketOffset = DesiredSocketOffset + FVector(0, 0, 1);
+		SocketOffset = FMath::Lerp(ShakenSocketOffset, -ShakenSocketOffset, Shake);
+	}
+
+	// Exponential smoothing closes the same fraction of the gap per second whatever the frame rate
+	Boom->TargetArmLength = FMath::Lerp(Boom->TargetArmLength, DesiredArmLength, 1.0f - FMath::Exp(-Tune.ArmLengthSmoothing * DeltaTime));
+	Boom->SocketOffset = FMath::Lerp(Boom->SocketOffset, SocketOffset, 1.0f - FMath::Exp(-Tune.SocketOffsetSmoothing * DeltaTime));
+
+	if (HasSettled()) // Snap the last bit and sleep until the next state change
+	{
+		Boom->TargetArmLength = DesiredArmLength;
+		Boom->SocketOffset = DesiredSocketOffset;
+		SetComponentTickEnabled(false);
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "HLtC_CameraRigComponent.generated.h"
+
+class USpringArmComponent;
+class UHLtC_CombatTuningAsset;
+
+/**
+ * Blends a camera boom towards the arm length and socket offset of the owners current states.
+ * Smoothing is exponential so it behaves the same at any frame rate, and the shake is a function of time rather than an integrated wave.
+ * The component stops ticking once the boom has settled, and only wakes up when it's given new targets.
+ * Only created for locally controlled pawns, never on a dedicated server. Smoothing and shake rates come from the owners shared tuning.
+ */
+UCLASS(ClassGroup = Camera)
+class UHLtC_CameraRigComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHLtC_CameraRigComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void SetBoom(USpringArmComponent* InBoom) { Boom = InBoom; }
+	void SetTuning(const UHLtC_CombatTuningAsset* InTuning) { Tuning = InTuning; }
+
+	/** Sets where the boom should blend to, and wakes the rig up if anything changed. INDEX_NONE disables the shake, otherwise 0 or 1 picks a ShakeDeltaTimeDivision of the tuning */
+	void SetTargets(float InArmLength, const FVector& InSocketOffset, int32 InShakeSpeed);
+
+	/** Holds the boom where it is, e.g. during static actions. Releasing it wakes the rig up */
+	void SetHeld(bool bInHeld);
+
+	float GetDesiredArmLength() const { return DesiredArmLength; }
+	FVector GetDesiredSocketOffset() const { return DesiredSocketOffset; }
+
+private:
+	void Wake();
+	bool HasSettled() const;
+
+	UPROPERTY(Transient)
+	USpringArmComponent* Boom = nullptr;
+
+	UPROPERTY(Transient)
+	const UHLtC_CombatTuningAsset* Tuning = nullptr; // Shared with every character of the owners archetype, null uses the built-in tuning
+
+	float DesiredArmLength = 0.0f; // The target boom arm length, needed for when the actual boom arm length is between values
+	FVector DesiredSocketOffset = FVector::ZeroVector; // The target camera offset before any shake
+	int32 ShakeSpeed = INDEX_NONE; // ShakeDeltaTimeDivision in use, INDEX_NONE while not shaking
+	float ShakeTime = 0.0f; // Time spent shaking since the shake last started
+	bool bHeld = false;
+};
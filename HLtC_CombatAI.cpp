@@ -0,0 +1,186 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatAI.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	float Saturate(float Value)
+	{
+		return std::min(std::max(Value, 0.0f), 1.0f);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_BotCommand
+
+void FHLtC_BotCommand::AppendTo(FHLtC_CombatInput& Input) const
+{
+	Input.Held = Held;
+	for (uint8_t Press : HLtC::BotPressOrder)
+	{
+		if ((Presses & Press) != 0)
+		{
+			Input.AddPress(Press);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_BotBrain
+
+int32_t FHLtC_BotBrain::Add(int32_t InCombatant, int32_t InTarget, uint32_t Seed)
+{
+	const int32_t Bot = Num();
+	Combatant.push_back(InCombatant);
+	Target.push_back(InTarget);
+	Stamina.push_back(Tuning.MaxStamina);
+	RandomState.push_back(Seed != 0 ? Seed : 1u); // Xorshift never leaves 0
+	Action.push_back(EHLtC_BotAction::Idle);
+	MoveX.push_back(0.0f);
+	MoveY.push_back(0.0f);
+	PendingPresses.push_back(0);
+	bBlockHeld.push_back(0);
+	return Bot;
+}
+
+void FHLtC_BotBrain::RemoveAtSwap(int32_t Bot)
+{
+	const auto RemoveSwap = [Bot](auto& Column)
+	{
+		Column[Bot] = Column.back();
+		Column.pop_back();
+	};
+
+	RemoveSwap(Combatant);
+	RemoveSwap(Target);
+	RemoveSwap(Stamina);
+	RemoveSwap(RandomState);
+	RemoveSwap(Action);
+	RemoveSwap(MoveX);
+	RemoveSwap(MoveY);
+	RemoveSwap(PendingPresses);
+	RemoveSwap(bBlockHeld);
+}
+
+void FHLtC_BotBrain::GetDueRange(uint32_t Frame, int32_t Interval, int32_t& OutBegin, int32_t& OutEnd) const
+{
+	// Contiguous slices rather than every Nth bot, so each pass walks the columns in order
+	const int64_t Slices = std::max(Interval, 1);
+	const int64_t Slice = Frame % Slices;
+	OutBegin = static_cast<int32_t>(Num() * Slice / Slices);
+	OutEnd = static_cast<int32_t>(Num() * (Slice + 1) / Slices);
+}
+
+float FHLtC_BotBrain::NextRandom(int32_t Bot)
+{
+	uint32_t& State = RandomState[Bot];
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return static_cast<float>(State >> 8) * (1.0f / 16777216.0f);
+}
+
+void FHLtC_BotBrain::DecideRange(int32_t Begin, int32_t End, const FHLtC_CombatWorld& World, const FHLtC_CombatantBounds& Bounds)
+{
+	const int32_t NumCombatants = std::min(World.Num(), Bounds.Num());
+	const float InvMaxStamina = Tuning.MaxStamina > 0.0f ? 1.0f / Tuning.MaxStamina : 0.0f;
+	const float InvSprintRamp = 1.0f / std::max(Tuning.SprintRange - Tuning.AttackRange, 1.0f);
+	const float InvRangeFalloff = 1.0f / std::max(Tuning.AttackRange * 0.5f, 1.0f);
+
+	for (int32_t Bot = Begin; Bot < End; Bot++)
+	{
+		const int32_t Self = Combatant[Bot];
+		const int32_t Foe = Target[Bot];
+
+		float Scores[static_cast<int32_t>(EHLtC_BotAction::Count)] = {};
+		Scores[static_cast<int32_t>(EHLtC_BotAction::Idle)] = 0.05f; // Wins when nothing else is worth doing
+		float DirectionX = 0.0f;
+		float DirectionY = 0.0f;
+
+		if (Self >= 0 && Self < NumCombatants && Foe >= 0 && Foe < NumCombatants && Foe != Self)
+		{
+			const float DeltaX = Bounds.X[Foe] - Bounds.X[Self];
+			const float DeltaY = Bounds.Y[Foe] - Bounds.Y[Self];
+			const float Distance = std::sqrt(DeltaX * DeltaX + DeltaY * DeltaY);
+			if (Distance > 1.e-3f)
+			{
+				DirectionX = DeltaX / Distance;
+				DirectionY = DeltaY / Distance;
+			}
+
+			// Considerations, each between 0 and 1
+			const float Gap = std::max(Distance - Bounds.Radius[Self] - Bounds.Radius[Foe], 0.0f);
+			const float InRange = Saturate((Tuning.AttackRange * 1.5f - Gap) * InvRangeFalloff); // 1 up to the attack range, fading out over half of it again
+			const float Far = Saturate((Gap - Tuning.AttackRange) * InvSprintRamp);
+			const float StaminaFraction = Saturate(Stamina[Bot] * InvMaxStamina);
+			const auto Affordable = [this, Bot, StaminaFraction](float Cost) { return Stamina[Bot] >= Cost ? 0.5f + 0.5f * StaminaFraction : 0.0f; };
+
+			const bool bTargetBlocking = World.HasFlag(Foe, HLtC::Flag_Blocking);
+			const bool bTargetAttacking = HLtC::IsAttackAction(World.Action[Foe]);
+			const bool bAttacking = HLtC::IsAttackAction(World.Action[Self]);
+			const int32_t ChainIndex = bAttacking ? World.AttackIndex[Self] : 0;
+			const bool bCanPress = (World.Flags[Self] & (HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered)) == 0; // A second press would only replace the buffered one
+
+			Scores[static_cast<int32_t>(EHLtC_BotAction::Approach)] = (1.0f - InRange) * 0.6f;
+			Scores[static_cast<int32_t>(EHLtC_BotAction::Sprint)] = Far * StaminaFraction * 0.9f;
+			Scores[static_cast<int32_t>(EHLtC_BotAction::Retreat)] = InRange * (1.0f - StaminaFraction) * (1.0f - StaminaFraction) * 0.7f;
+			Scores[static_cast<int32_t>(EHLtC_BotAction::Block)] = InRange * (bTargetAttacking && !bAttacking ? 0.95f : 0.02f) * Affordable(Tuning.BlockCost);
+			if (bCanPress) // Light attacks open guards and carry chains on, heavy attacks break blocks and finish chains
+			{
+				Scores[static_cast<int32_t>(EHLtC_BotAction::LightAttack)] = InRange * Affordable(Tuning.LightAttackCost) * (bTargetBlocking ? 0.3f : 0.8f) * (1.0f + 0.1f * static_cast<float>(ChainIndex));
+				Scores[static_cast<int32_t>(EHLtC_BotAction::HeavyAttack)] = InRange * Affordable(Tuning.HeavyAttackCost) * (bTargetBlocking ? 0.75f : 0.35f) * (ChainIndex > 0 ? 1.3f : 1.0f);
+			}
+		}
+
+		int32_t Best = 0;
+		float BestScore = -1.0f;
+		for (int32_t Candidate = 0; Candidate < static_cast<int32_t>(EHLtC_BotAction::Count); Candidate++)
+		{
+			const float Score = Scores[Candidate] * (1.0f + Tuning.Jitter * (NextRandom(Bot) - 0.5f)); // Every bot draws the same number of times, whatever it decides
+			if (Score > BestScore)
+			{
+				Best = Candidate;
+				BestScore = Score;
+			}
+		}
+
+		const EHLtC_BotAction NewAction = static_cast<EHLtC_BotAction>(Best);
+		const float MoveSign = NewAction == EHLtC_BotAction::Retreat ? -1.0f
+			: NewAction == EHLtC_BotAction::Idle || NewAction == EHLtC_BotAction::Block ? 0.0f
+			: 1.0f; // Attacks close what's left of the gap until the move freezes the bot
+		Action[Bot] = NewAction;
+		MoveX[Bot] = DirectionX * MoveSign;
+		MoveY[Bot] = DirectionY * MoveSign;
+
+		const bool bBlock = NewAction == EHLtC_BotAction::Block;
+		PendingPresses[Bot] = static_cast<uint8_t>((bBlock && !bBlockHeld[Bot] ? HLtC::Input_BlockStarted : 0)
+			| (!bBlock && bBlockHeld[Bot] ? HLtC::Input_BlockCompleted : 0)
+			| (NewAction == EHLtC_BotAction::LightAttack ? HLtC::Input_LightAttack : 0)
+			| (NewAction == EHLtC_BotAction::HeavyAttack ? HLtC::Input_HeavyAttack : 0));
+	}
+}
+
+FHLtC_BotCommand FHLtC_BotBrain::TakeCommand(int32_t Bot, float DeltaTime)
+{
+	FHLtC_BotCommand Command;
+	Command.MoveX = MoveX[Bot];
+	Command.MoveY = MoveY[Bot];
+	Command.Held = static_cast<uint8_t>((Command.MoveX != 0.0f || Command.MoveY != 0.0f ? HLtC::Input_Moving : 0)
+		| (Action[Bot] == EHLtC_BotAction::Sprint && Stamina[Bot] > 0.0f ? HLtC::Input_Sprinting : 0)); // Out of stamina, a sprinting bot walks
+	Command.Presses = PendingPresses[Bot];
+	PendingPresses[Bot] = 0;
+
+	float& BotStamina = Stamina[Bot];
+	BotStamina -= (Command.Presses & HLtC::Input_LightAttack) != 0 ? Tuning.LightAttackCost : 0.0f;
+	BotStamina -= (Command.Presses & HLtC::Input_HeavyAttack) != 0 ? Tuning.HeavyAttackCost : 0.0f;
+	bBlockHeld[Bot] = (Command.Presses & HLtC::Input_BlockStarted) != 0 ? 1 : (Command.Presses & HLtC::Input_BlockCompleted) != 0 ? 0 : bBlockHeld[Bot];
+
+	BotStamina += (Command.Held & HLtC::Input_Sprinting) != 0 ? -Tuning.SprintCost * DeltaTime
+		: bBlockHeld[Bot] ? -Tuning.BlockCost * DeltaTime
+		: Tuning.StaminaRegen * DeltaTime;
+	BotStamina = std::min(std::max(BotStamina, 0.0f), Tuning.MaxStamina);
+	return Command;
+}
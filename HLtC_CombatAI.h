@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Utility AI for combat bots. Engine independent, like the rest of the core.
+// Bots don't think every step: each is re-scored once every DecisionInterval steps, as part of one pass over the slice of bots due, and holds its decision in between.
+// Scoring a bot only reads the world, the bounds and its own columns, so ranges of bots can be scored on any thread.
+
+#include "HLtC_CombatCore.h"
+#include "HLtC_CombatHits.h"
+
+/** What a bot decided to do until its next decision */
+enum class EHLtC_BotAction : uint8_t
+{
+	Idle, // Stands still, recovering stamina
+	Approach, // Walks towards the target
+	Sprint, // Sprints towards the target
+	Retreat, // Walks away from the target, recovering stamina
+	LightAttack,
+	HeavyAttack,
+	Block, // Holds block while the target attacks
+	Count
+};
+
+/** Weights and costs every bot is scored with. Distances are between the capsules, not their centres */
+struct FHLtC_BotTuning
+{
+	float AttackRange = 120.0f; // Gap to the target at or below which attacks are scored fully
+	float SprintRange = 900.0f; // Gap to the target at or above which sprinting is scored fully
+	float MaxStamina = 100.0f;
+	float StaminaRegen = 25.0f; // Per second while neither sprinting nor blocking
+	float LightAttackCost = 12.0f;
+	float HeavyAttackCost = 28.0f;
+	float SprintCost = 15.0f; // Per second
+	float BlockCost = 6.0f; // Per second
+	float Jitter = 0.2f; // Random spread of every score, so a crowd of bots doesn't act in lockstep
+};
+
+/** A bots input for one frame, as a player would give it */
+struct FHLtC_BotCommand
+{
+	float MoveX = 0.0f; // World space horizontal direction to move in, zero to stand still
+	float MoveY = 0.0f;
+	uint8_t Held = 0; // HLtC::EInputHeld
+	uint8_t Presses = 0; // HLtC::EInputPressed bits, see HLtC::BotPressOrder for the order they're given in
+
+	/** Adds the command to a combatants step input */
+	void AppendTo(FHLtC_CombatInput& Input) const;
+};
+
+namespace HLtC
+{
+	/** Order the presses of a bot command happen in, so a bot lets go of block before it attacks */
+	inline constexpr uint8_t BotPressOrder[] = { Input_BlockCompleted, Input_BlockStarted, Input_LightAttack, Input_HeavyAttack };
+}
+
+/**
+ * The decisions of every bot, one array per field. Index i belongs to bot i, which drives combatant Combatant[i] of the world.
+ * DecideRange scores the bots, TakeCommand turns their decisions into input one frame at a time.
+ */
+class FHLtC_BotBrain
+{
+public:
+	FHLtC_BotTuning Tuning;
+
+	int32_t Num() const { return static_cast<int32_t>(Combatant.size()); }
+	int32_t Add(int32_t InCombatant, int32_t InTarget, uint32_t Seed); // Returns the new bots index
+	void RemoveAtSwap(int32_t Bot); // Moves the last bot into Bot
+
+	/** Bots [OutBegin, OutEnd) due for a decision on Frame, so that every bot is decided once every Interval frames */
+	void GetDueRange(uint32_t Frame, int32_t Interval, int32_t& OutBegin, int32_t& OutEnd) const;
+
+	/**
+	 * Scores every action of bots [Begin, End) and keeps the best. Bounds holds every combatant of World.
+	 * Disjoint ranges can be decided concurrently, with the same results as deciding them in one go
+	 */
+	void DecideRange(int32_t Begin, int32_t End, const FHLtC_CombatWorld& World, const FHLtC_CombatantBounds& Bounds);
+
+	/** Input of a bot for a frame DeltaTime seconds long. Spends and recovers its stamina, and gives each press of a decision only once. Not during DecideRange */
+	FHLtC_BotCommand TakeCommand(int32_t Bot, float DeltaTime);
+
+	// Bots, one array per field
+	std::vector<int32_t> Combatant; // Combatant the bot drives. Kept up to date by the owner as combatants move around the world
+	std::vector<int32_t> Target; // Combatant the bot fights, -1 for none
+	std::vector<float> Stamina;
+	std::vector<uint32_t> RandomState; // Per bot, so the split into ranges can't change the draws
+	std::vector<EHLtC_BotAction> Action; // Current decision
+	std::vector<float> MoveX; // Direction of the current decision
+	std::vector<float> MoveY;
+	std::vector<uint8_t> PendingPresses; // Presses of the current decision not given yet
+	std::vector<uint8_t> bBlockHeld; // The bot last gave a block press rather than a release
+
+private:
+	float NextRandom(int32_t Bot); // Uniform in [0, 1)
+};
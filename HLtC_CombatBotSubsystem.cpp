@@ -0,0 +1,229 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatBotSubsystem.h"
+#include "HLtC_CombatSystemCharacter.h"
+#include "HLtC_CombatSimulationSubsystem.h"
+#include "HLtC_CombatTrace.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Controller.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "InputActionValue.h"
+
+static int32 GHLtCAIDecisionInterval = 4;
+static FAutoConsoleVariableRef CVarHLtCAIDecisionInterval(
+	TEXT("hltc.AI.DecisionInterval"),
+	GHLtCAIDecisionInterval,
+	TEXT("Frames between decisions of the same combat bot. Each frame decides an equal slice of the bots, so the cost per frame stays level."));
+
+static float GHLtCAIBudgetMs = 0.5f;
+static FAutoConsoleVariableRef CVarHLtCAIBudgetMs(
+	TEXT("hltc.AI.BudgetMs"),
+	GHLtCAIBudgetMs,
+	TEXT("Time the combat bot decisions of a frame may take. Slices that run over spread the decisions across more frames, until there's room again. 0 disables the budget."));
+
+static int32 GHLtCAIParallelDecisions = 1;
+static FAutoConsoleVariableRef CVarHLtCAIParallelDecisions(
+	TEXT("hltc.AI.ParallelDecisions"),
+	GHLtCAIParallelDecisions,
+	TEXT("Scores the combat bots due each frame across worker threads. Decisions are identical either way.\n")
+	TEXT("0: game thread only, 1: ParallelFor (default)"));
+
+static int32 GHLtCAIBatchSize = 64;
+static FAutoConsoleVariableRef CVarHLtCAIBatchSize(
+	TEXT("hltc.AI.BatchSize"),
+	GHLtCAIBatchSize,
+	TEXT("Number of combat bots scored by each worker task when hltc.AI.ParallelDecisions is on."));
+
+static constexpr int32 HLtCAIMaxDecisionInterval = 30; // The budget never stretches a bots reactions past half a second at 60 fps
+
+//////////////////////////////////////////////////////////////////////////
+// UHLtC_CombatBotSubsystem
+
+TStatId UHLtC_CombatBotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHLtC_CombatBotSubsystem, STATGROUP_Tickables);
+}
+
+bool UHLtC_CombatBotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UHLtC_CombatBotSubsystem::FindBot(const AHLtC_CombatSystemCharacter* Character) const
+{
+	return Bots.IndexOfByPredicate([Character](const TWeakObjectPtr<AHLtC_CombatSystemCharacter>& Bot) { return Bot.Get() == Character; });
+}
+
+void UHLtC_CombatBotSubsystem::AddBot(AHLtC_CombatSystemCharacter* Character, AHLtC_CombatSystemCharacter* Target)
+{
+	if (Character == nullptr || FindBot(Character) != INDEX_NONE)
+	{
+		SetTarget(Character, Target);
+		return;
+	}
+
+	Brain.Add(Character->Hot.CombatantIndex, Target ? Target->Hot.CombatantIndex : INDEX_NONE, NextSeed++ * 2654435761u);
+	Bots.Add(Character);
+	Targets.Add(Target);
+}
+
+void UHLtC_CombatBotSubsystem::RemoveBot(AHLtC_CombatSystemCharacter* Character)
+{
+	const int32 Bot = FindBot(Character);
+	if (Bot == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Leaves the character as a player who let go of everything would
+	Character->SimulateInput(EHLtC_InputAction::Move, FInputActionValue(FVector2D::ZeroVector));
+	Character->SimulateInput(EHLtC_InputAction::Sprint, FInputActionValue(false));
+	if (Brain.bBlockHeld[Bot])
+	{
+		Character->SimulateInput(EHLtC_InputAction::Block, FInputActionValue(false));
+	}
+	RemoveBotAt(Bot);
+}
+
+void UHLtC_CombatBotSubsystem::SetTarget(AHLtC_CombatSystemCharacter* Character, AHLtC_CombatSystemCharacter* Target)
+{
+	const int32 Bot = FindBot(Character);
+	if (Bot != INDEX_NONE)
+	{
+		Targets[Bot] = Target;
+	}
+}
+
+void UHLtC_CombatBotSubsystem::RemoveBotAt(int32 Bot)
+{
+	Brain.RemoveAtSwap(Bot);
+	Bots.RemoveAtSwap(Bot, 1, EAllowShrinking::No);
+	Targets.RemoveAtSwap(Bot, 1, EAllowShrinking::No);
+}
+
+void UHLtC_CombatBotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UHLtC_CombatSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UHLtC_CombatSimulationSubsystem>();
+	if (Bots.IsEmpty() || Simulation == nullptr)
+	{
+		return;
+	}
+
+	// Combatant indices move whenever a combatant leaves, so they're looked up again every frame. Backwards, so removing swaps in a bot already looked at
+	for (int32 Bot = Bots.Num() - 1; Bot >= 0; Bot--)
+	{
+		const AHLtC_CombatSystemCharacter* Character = Bots[Bot].Get();
+		if (Character == nullptr)
+		{
+			RemoveBotAt(Bot);
+			continue;
+		}
+
+		const AHLtC_CombatSystemCharacter* Target = Targets[Bot].Get();
+		Brain.Combatant[Bot] = Character->Hot.CombatantIndex;
+		Brain.Target[Bot] = Target ? Target->Hot.CombatantIndex : INDEX_NONE;
+	}
+
+	GatherBounds(*Simulation);
+	Decide(*Simulation);
+	ApplyCommands(DeltaTime);
+	Frame++;
+}
+
+void UHLtC_CombatBotSubsystem::GatherBounds(const UHLtC_CombatSimulationSubsystem& Simulation)
+{
+	const int32 NumCombatants = Simulation.Num();
+	Bounds.SetNum(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; Index++) // Only what the brain reads
+	{
+		const AHLtC_CombatSystemCharacter* Character = Simulation.GetCharacter(Index);
+		const FVector Location = Character->GetActorLocation();
+		Bounds.X[Index] = static_cast<float>(Location.X);
+		Bounds.Y[Index] = static_cast<float>(Location.Y);
+		Bounds.Radius[Index] = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	}
+}
+
+void UHLtC_CombatBotSubsystem::Decide(const UHLtC_CombatSimulationSubsystem& Simulation)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_BotDecisions);
+
+	const int32 ConfiguredInterval = FMath::Clamp(GHLtCAIDecisionInterval, 1, HLtCAIMaxDecisionInterval);
+	DecisionInterval = FMath::Clamp(DecisionInterval, ConfiguredInterval, HLtCAIMaxDecisionInterval);
+
+	int32 Begin, End;
+	Brain.GetDueRange(Frame, DecisionInterval, Begin, End);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const FHLtC_CombatWorld& World = Simulation.GetCombatWorld();
+	const int32 BatchSize = FMath::Max(GHLtCAIBatchSize, 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(End - Begin, BatchSize);
+	if (GHLtCAIParallelDecisions != 0 && NumBatches > 1)
+	{
+		// Every bot only writes its own columns and draws from its own random stream, so the split can't change the decisions
+		ParallelFor(NumBatches, [this, &World, Begin, End, BatchSize](int32 Batch)
+		{
+			const int32 BatchBegin = Begin + Batch * BatchSize;
+			Brain.DecideRange(BatchBegin, FMath::Min(BatchBegin + BatchSize, End), World, Bounds);
+		});
+	}
+
+	else
+	{
+		Brain.DecideRange(Begin, End, World, Bounds);
+	}
+
+	// Over budget, the bots get fewer decisions rather than the frame getting longer. Changing the interval shifts the slices, so a few bots are decided early or late once
+	const double DecideMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	if (GHLtCAIBudgetMs > 0.0f && DecideMs > GHLtCAIBudgetMs)
+	{
+		DecisionInterval = FMath::Min(DecisionInterval + 1, HLtCAIMaxDecisionInterval);
+	}
+
+	else if (DecideMs < GHLtCAIBudgetMs * 0.5f || GHLtCAIBudgetMs <= 0.0f)
+	{
+		DecisionInterval = FMath::Max(DecisionInterval - 1, ConfiguredInterval);
+	}
+}
+
+void UHLtC_CombatBotSubsystem::ApplyCommands(float DeltaTime)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_BotInput);
+
+	for (int32 Bot = 0; Bot < Bots.Num(); Bot++)
+	{
+		AHLtC_CombatSystemCharacter* Character = Bots[Bot].Get();
+		const FHLtC_BotCommand Command = Brain.TakeCommand(Bot, DeltaTime);
+
+		FVector2D MoveInput = FVector2D::ZeroVector; // Relative to the control rotation, like a players stick
+		if (const AController* Controller = Character->GetController())
+		{
+			const FRotator YawRotation(0.0, Controller->GetControlRotation().Yaw, 0.0);
+			const FVector Direction(Command.MoveX, Command.MoveY, 0.0f);
+			MoveInput = FVector2D(Direction | FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y), Direction | FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X));
+		}
+
+		Character->SimulateInput(EHLtC_InputAction::Move, FInputActionValue(MoveInput));
+		Character->SimulateInput(EHLtC_InputAction::Sprint, FInputActionValue((Command.Held & HLtC::Input_Sprinting) != 0)); // Every frame, as a held sprint input triggers
+
+		for (uint8 Press : HLtC::BotPressOrder)
+		{
+			if ((Command.Presses & Press) == 0)
+			{
+				continue;
+			}
+
+			switch (Press)
+			{
+			case HLtC::Input_BlockCompleted: Character->SimulateInput(EHLtC_InputAction::Block, FInputActionValue(false)); break;
+			case HLtC::Input_BlockStarted: Character->SimulateInput(EHLtC_InputAction::Block, FInputActionValue(true)); break;
+			case HLtC::Input_LightAttack: Character->SimulateInput(EHLtC_InputAction::LightAttack, FInputActionValue(true)); break;
+			case HLtC::Input_HeavyAttack: Character->SimulateInput(EHLtC_InputAction::HeavyAttack, FInputActionValue(true)); break;
+			default: break;
+			}
+		}
+	}
+}
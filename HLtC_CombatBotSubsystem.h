@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HLtC_CombatAI.h"
+#include "HLtC_CombatBotSubsystem.generated.h"
+
+class AHLtC_CombatSystemCharacter;
+class UHLtC_CombatSimulationSubsystem;
+
+/**
+ * Drives combat characters with an FHLtC_BotBrain, for NPCs and for load testing.
+ * Bots are scored in slices, one slice a frame spread across worker threads, so every bot is re-decided every hltc.AI.DecisionInterval frames at a steady cost.
+ * Their decisions go through SimulateInput, the same entry points a players input takes, so bots are simulated, replicated and recorded like players.
+ */
+UCLASS()
+class UHLtC_CombatBotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UTickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Hands a character over to the AI, fighting Target. The character needs a controller for its movement input to do anything */
+	void AddBot(AHLtC_CombatSystemCharacter* Character, AHLtC_CombatSystemCharacter* Target);
+	void RemoveBot(AHLtC_CombatSystemCharacter* Character); // Lets go of block and stops driving the character
+	void SetTarget(AHLtC_CombatSystemCharacter* Character, AHLtC_CombatSystemCharacter* Target); // Null leaves the bot idle
+
+	int32 Num() const { return Bots.Num(); }
+
+	FHLtC_BotTuning& GetTuning() { return Brain.Tuning; }
+
+	int32 GetDecisionInterval() const { return DecisionInterval; } // Frames between decisions of the same bot, raised above hltc.AI.DecisionInterval while the budget is exceeded
+
+private:
+	int32 FindBot(const AHLtC_CombatSystemCharacter* Character) const;
+	void RemoveBotAt(int32 Bot);
+	void GatherBounds(const UHLtC_CombatSimulationSubsystem& Simulation); // Positions of every combatant, which the bots are scored against
+	void Decide(const UHLtC_CombatSimulationSubsystem& Simulation); // Scores the slice of bots due this frame
+	void ApplyCommands(float DeltaTime); // Feeds every bots current decision through its characters input handlers
+
+	FHLtC_BotBrain Brain;
+	TArray<TWeakObjectPtr<AHLtC_CombatSystemCharacter>> Bots; // Character of each bot of the brain
+	TArray<TWeakObjectPtr<AHLtC_CombatSystemCharacter>> Targets; // Target of each bot, resolved to a combatant every frame as combatants move around
+	FHLtC_CombatantBounds Bounds;
+
+	uint32 Frame = 0;
+	uint32 NextSeed = 1; // Never reused, so a bot added after another left doesn't repeat its draws
+	int32 DecisionInterval = 1;
+};
@@ -0,0 +1,865 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatCore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_MoveTable
+
+FHLtC_MoveTable::FHLtC_MoveTable()
+{
+	// Weapon 0 is always the built-in chains, so a default cursor is valid: five light attacks and three heavy attacks, buffering from half way through each
+	const float LightAttackTimings[5] = { 1.0f, 0.7f, 0.7f, 0.7f, 0.7f };
+	const float HeavyAttackTimings[3] = { 1.5f, 1.0f, 1.0f };
+
+	FHLtC_MoveDefinition Definitions[8];
+	for (uint16_t Index = 0; Index < 5; Index++)
+	{
+		Definitions[Index].Duration = LightAttackTimings[Index];
+		Definitions[Index].NextOnLight = Index + 1 < 5 ? static_cast<uint16_t>(Index + 1) : HLtC::InvalidMove;
+	}
+	for (uint16_t Index = 0; Index < 3; Index++)
+	{
+		Definitions[5 + Index].Duration = HeavyAttackTimings[Index];
+		Definitions[5 + Index].NextOnHeavy = Index + 1 < 3 ? static_cast<uint16_t>(5 + Index + 1) : HLtC::InvalidMove;
+		Definitions[5 + Index].bHeavy = true;
+	}
+
+	AddWeapon(Definitions, 8, 0, 5);
+}
+
+int32_t FHLtC_MoveTable::AddWeapon(const FHLtC_MoveDefinition* Definitions, int32_t NumDefinitions, uint16_t LightEntry, uint16_t HeavyEntry, const FHLtC_DodgeDefinition* DodgeDefinitions)
+{
+	// Dodges default to a straight ease-out roll in each direction
+	static const FHLtC_RootMotionSample DefaultDirections[HLtC::NumDodgeDirections] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, -1.0f }, { 0.0f, 1.0f } };
+	static const FHLtC_DodgeDefinition DefaultDodges[HLtC::NumDodgeDirections];
+	constexpr int32_t NumDefaultSamples = 16;
+
+	int32_t NumNewSamples = 0;
+	for (int32_t Direction = 0; Direction < HLtC::NumDodgeDirections; Direction++)
+	{
+		const FHLtC_DodgeDefinition& Definition = DodgeDefinitions ? DodgeDefinitions[Direction] : DefaultDodges[Direction];
+		NumNewSamples += Definition.Samples && Definition.NumSamples >= 2 ? Definition.NumSamples : NumDefaultSamples;
+	}
+
+	if (NumWeapons() >= MaxWeapons || NumMoves() + NumDefinitions >= MaxMoves || NumRootMotionSamples + NumNewSamples > MaxRootMotionSamples)
+	{
+		return -1;
+	}
+
+	const int32_t FirstMove = NumMoves();
+	const int32_t Weapon = NumWeapons();
+	auto ResolveLink = [FirstMove, NumDefinitions](uint16_t Link) -> uint16_t
+	{
+		return Link < NumDefinitions ? static_cast<uint16_t>(FirstMove + Link) : HLtC::InvalidMove;
+	};
+
+	// Everything is written past the published counts, where no reader looks yet
+	for (int32_t Index = 0; Index < NumDefinitions; Index++)
+	{
+		const FHLtC_MoveDefinition& Definition = Definitions[Index];
+
+		FHLtC_CompiledMove Move = {};
+		Move.Duration = std::max(Definition.Duration, 1.e-4f);
+		Move.BufferTime = Move.Duration * std::clamp(Definition.BufferWindow, 0.0f, 1.0f);
+		Move.Next[HLtC::GetLinkIndex(EHLtC_AttackType::Light)] = ResolveLink(Definition.NextOnLight);
+		Move.Next[HLtC::GetLinkIndex(EHLtC_AttackType::Heavy)] = ResolveLink(Definition.NextOnHeavy);
+		Move.Action = Definition.bHeavy ? EHLtC_PlayerAction::HeavyAttack : EHLtC_PlayerAction::LightAttack;
+		Move.ChainIndex = 0;
+		Move.Hit.Damage = Definition.Damage;
+		Move.Hit.Range = Definition.Range;
+		Move.Hit.Radius = Definition.Radius;
+		Move.Hit.CosHalfArc = std::cos(std::clamp(Definition.ArcDegrees, 0.0f, 360.0f) * 0.5f * 3.14159265f / 180.0f);
+		Moves[FirstMove + Index] = Move;
+	}
+
+	FWeaponEntries& Entries = WeaponEntries[Weapon];
+	Entries.Entry[HLtC::GetLinkIndex(EHLtC_AttackType::Light)] = ResolveLink(LightEntry);
+	Entries.Entry[HLtC::GetLinkIndex(EHLtC_AttackType::Heavy)] = ResolveLink(HeavyEntry);
+
+	for (int32_t Direction = 0; Direction < HLtC::NumDodgeDirections; Direction++)
+	{
+		const FHLtC_DodgeDefinition& Definition = DodgeDefinitions ? DodgeDefinitions[Direction] : DefaultDodges[Direction];
+
+		FHLtC_CompiledDodge Dodge = {};
+		Dodge.Duration = std::max(Definition.Duration, 1.e-4f);
+		Dodge.BufferTime = Dodge.Duration * std::clamp(Definition.BufferWindow, 0.0f, 1.0f);
+		Dodge.InvulnerableStart = static_cast<int32_t>(HLtC::ToTimeUnits(std::clamp(Definition.InvulnerableStart, 0.0f, Dodge.Duration)));
+		Dodge.InvulnerableEnd = static_cast<int32_t>(HLtC::ToTimeUnits(std::clamp(Definition.InvulnerableEnd, 0.0f, Dodge.Duration)));
+		Dodge.FirstSample = static_cast<uint32_t>(NumRootMotionSamples);
+
+		if (Definition.Samples && Definition.NumSamples >= 2)
+		{
+			std::copy(Definition.Samples, Definition.Samples + Definition.NumSamples, &RootMotion[NumRootMotionSamples]);
+			NumRootMotionSamples += Definition.NumSamples;
+		}
+
+		else
+		{
+			for (int32_t Sample = 0; Sample < NumDefaultSamples; Sample++)
+			{
+				const float Alpha = static_cast<float>(Sample) / (NumDefaultSamples - 1);
+				const float Eased = 1.0f - (1.0f - Alpha) * (1.0f - Alpha); // Fastest at the start, coming to rest at the end
+				RootMotion[NumRootMotionSamples++] = { DefaultDirections[Direction].Forward * Definition.Distance * Eased, DefaultDirections[Direction].Right * Definition.Distance * Eased };
+			}
+		}
+
+		Dodge.NumSamples = static_cast<uint32_t>(NumRootMotionSamples) - Dodge.FirstSample;
+		Dodges[Weapon * HLtC::NumDodgeDirections + Direction] = Dodge;
+	}
+
+	// Chain indices are the depth of each move from the entry moves, so branching chains still name their actions "LightAttack_N".
+	// Breadth first, so each move gets the shortest depth it can be reached at
+	std::vector<uint16_t> Pending;
+	std::vector<bool> Queued(NumDefinitions, false);
+	for (const uint16_t Entry : Entries.Entry)
+	{
+		if (Entry != HLtC::InvalidMove && !Queued[Entry - FirstMove])
+		{
+			Queued[Entry - FirstMove] = true;
+			Pending.push_back(Entry);
+		}
+	}
+
+	for (size_t Cursor = 0; Cursor < Pending.size(); Cursor++)
+	{
+		const FHLtC_CompiledMove& Move = Moves[Pending[Cursor]];
+		for (const uint16_t Next : Move.Next)
+		{
+			if (Next != HLtC::InvalidMove && !Queued[Next - FirstMove])
+			{
+				Queued[Next - FirstMove] = true;
+				Moves[Next].ChainIndex = static_cast<uint8_t>(std::min(Move.ChainIndex + 1, 255));
+				Pending.push_back(Next);
+			}
+		}
+	}
+
+	// Published last, a reader that sees the new counts sees everything they cover
+	NumCompiledMoves.store(FirstMove + NumDefinitions, std::memory_order_release);
+	NumCompiledWeapons.store(Weapon + 1, std::memory_order_release);
+	return Weapon;
+}
+
+FHLtC_RootMotionSample FHLtC_MoveTable::SampleRootMotion(const FHLtC_CompiledDodge& Dodge, float Time) const
+{
+	const float Position = std::clamp(Time / Dodge.Duration, 0.0f, 1.0f) * static_cast<float>(Dodge.NumSamples - 1);
+	const uint32_t Sample = std::min(static_cast<uint32_t>(Position), Dodge.NumSamples - 2);
+	const float Alpha = Position - static_cast<float>(Sample);
+
+	const FHLtC_RootMotionSample& From = RootMotion[Dodge.FirstSample + Sample];
+	const FHLtC_RootMotionSample& To = RootMotion[Dodge.FirstSample + Sample + 1];
+	return { From.Forward + (To.Forward - From.Forward) * Alpha, From.Right + (To.Right - From.Right) * Alpha };
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Input events
+
+bool HLtC::ApplyInputEvent(FHLtC_CombatInput& Input, EHLtC_InputEvent Type, uint8_t Time)
+{
+	switch (Type)
+	{
+	case EHLtC_InputEvent::LightAttack: return Input.AddPress(HLtC::Input_LightAttack, Time);
+	case EHLtC_InputEvent::HeavyAttack: return Input.AddPress(HLtC::Input_HeavyAttack, Time);
+	case EHLtC_InputEvent::BlockStarted: return Input.AddPress(HLtC::Input_BlockStarted, Time);
+	case EHLtC_InputEvent::BlockCompleted: return Input.AddPress(HLtC::Input_BlockCompleted, Time);
+	case EHLtC_InputEvent::DodgeForward: return Input.AddPress(HLtC::MakeDodgePress(EHLtC_DodgeDirection::Forward), Time);
+	case EHLtC_InputEvent::DodgeBackward: return Input.AddPress(HLtC::MakeDodgePress(EHLtC_DodgeDirection::Backward), Time);
+	case EHLtC_InputEvent::DodgeLeft: return Input.AddPress(HLtC::MakeDodgePress(EHLtC_DodgeDirection::Left), Time);
+	case EHLtC_InputEvent::DodgeRight: return Input.AddPress(HLtC::MakeDodgePress(EHLtC_DodgeDirection::Right), Time);
+	case EHLtC_InputEvent::SprintStarted: Input.Held |= HLtC::Input_Sprinting; return true;
+	case EHLtC_InputEvent::SprintCompleted: Input.Held &= static_cast<uint8_t>(~HLtC::Input_Sprinting); return true;
+	default: return true;
+	}
+}
+
+void HLtC::ConsumeInputEvents(FHLtC_InputEventRing& Ring, FHLtC_CombatInput& Input, double StepStart, double StepDuration)
+{
+	const double StepEnd = StepStart + StepDuration;
+	while (const FHLtC_InputEvent* Event = Ring.Peek())
+	{
+		if (Event->Time >= StepEnd) // Belongs to a later step
+		{
+			return;
+		}
+
+		const double Fraction = StepDuration > 0.0 ? (Event->Time - StepStart) / StepDuration : 0.0;
+		const uint8_t Time = static_cast<uint8_t>(std::clamp(Fraction * 256.0, 0.0, 255.0));
+		if (!ApplyInputEvent(Input, Event->Type, Time)) // Step is full, keep the event for the next one
+		{
+			return;
+		}
+
+		Ring.Pop();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_CombatWorld
+
+void FHLtC_CombatWorld::Reserve(int32_t Capacity)
+{
+	StaticActionEnd.reserve(Capacity);
+	AdditionalAttackBufferTiming.reserve(Capacity);
+	AttackMove.reserve(Capacity);
+	Weapon.reserve(Capacity);
+	Action.reserve(Capacity);
+	AttackIndex.reserve(Capacity);
+	ControlState.reserve(Capacity);
+	CameraState.reserve(Capacity);
+	CurrentAttackType.reserve(Capacity);
+	Flags.reserve(Capacity);
+	BufferedDodge.reserve(Capacity);
+	Changed.reserve(Capacity);
+	for (std::vector<int32_t>& Handles : TimerHandles)
+	{
+		Handles.reserve(Capacity);
+	}
+}
+
+int32_t FHLtC_CombatWorld::Add(uint8_t InWeapon)
+{
+	HLtC::CountGrowth(Flags, Flags.size()); // Every column grows together, so one stands for all of them
+	StaticActionEnd.push_back(0);
+	AdditionalAttackBufferTiming.push_back(0.0f);
+	AttackMove.push_back(HLtC::InvalidMove);
+	Weapon.push_back(InWeapon);
+	Action.push_back(EHLtC_PlayerAction::Idle);
+	AttackIndex.push_back(0);
+	ControlState.push_back(EHLtC_ControlState::Slow);
+	CameraState.push_back(EHLtC_CameraState::Free);
+	CurrentAttackType.push_back(EHLtC_AttackType::None);
+	Flags.push_back(0);
+	BufferedDodge.push_back(EHLtC_DodgeDirection::Forward);
+	Changed.push_back(1);
+	for (std::vector<int32_t>& Handles : TimerHandles)
+	{
+		Handles.push_back(-1);
+	}
+	return Num() - 1;
+}
+
+void FHLtC_CombatWorld::RemoveAtSwap(int32_t Index)
+{
+	// The last combatants timers follow it into Index, the removed ones are dropped
+	const int32_t Last = Num() - 1;
+	for (uint32_t Event = 0; Event < Timer_NumEvents; Event++)
+	{
+		Timers.Cancel(TimerHandles[Event][Index]);
+		if (Last != Index && TimerHandles[Event][Last] >= 0)
+		{
+			Timers.SetPayload(TimerHandles[Event][Last], static_cast<uint32_t>(Index) << TimerEventBits | Event);
+		}
+	}
+
+	auto RemoveSwap = [Index](auto& Column)
+	{
+		Column[Index] = Column.back();
+		Column.pop_back();
+	};
+
+	RemoveSwap(StaticActionEnd);
+	RemoveSwap(AdditionalAttackBufferTiming);
+	RemoveSwap(AttackMove);
+	RemoveSwap(Weapon);
+	RemoveSwap(Action);
+	RemoveSwap(AttackIndex);
+	RemoveSwap(ControlState);
+	RemoveSwap(CameraState);
+	RemoveSwap(CurrentAttackType);
+	RemoveSwap(Flags);
+	RemoveSwap(BufferedDodge);
+	RemoveSwap(Changed);
+	for (std::vector<int32_t>& Handles : TimerHandles)
+	{
+		RemoveSwap(Handles);
+	}
+}
+
+void FHLtC_CombatWorld::BeginStep(float DeltaTime)
+{
+	StepStart = Clock;
+	StepEnd = Clock + std::max<int64_t>(HLtC::ToTimeUnits(DeltaTime), 0);
+
+	const size_t FiredCapacity = FiredTimers.capacity();
+	const size_t DueCapacity = DueCombatants.capacity();
+
+	FiredTimers.clear();
+	Timers.Advance(StepEnd, FiredTimers);
+
+	DueCombatants.clear();
+	for (const uint32_t Payload : FiredTimers)
+	{
+		const int32_t Index = static_cast<int32_t>(Payload >> TimerEventBits);
+		TimerHandles[Payload & ((1u << TimerEventBits) - 1)][Index] = -1; // Fired timers are freed by the wheel
+		DueCombatants.push_back(Index);
+	}
+
+	// Sorted so each range can find its own, and so the order timers fired in can't change anything
+	std::sort(DueCombatants.begin(), DueCombatants.end());
+	DueCombatants.erase(std::unique(DueCombatants.begin(), DueCombatants.end()), DueCombatants.end());
+
+	HLtC::CountGrowth(FiredTimers, FiredCapacity);
+	HLtC::CountGrowth(DueCombatants, DueCapacity);
+}
+
+void FHLtC_CombatWorld::StepRange(int32_t Begin, int32_t End, const FHLtC_CombatInput* Inputs)
+{
+	for (int32_t Index = Begin; Index < End; Index++)
+	{
+		SetFlag(Index, HLtC::Flag_Sprinting, (Inputs[Index].Held & HLtC::Input_Sprinting) != 0);
+		SetFlag(Index, HLtC::Flag_Moving, (Inputs[Index].Held & HLtC::Input_Moving) != 0);
+		SetFlag(Index, HLtC::Flag_AttackStarted, false); // Only marks moves entered during this step
+	}
+
+	// Combatants with presses this step are resolved in pieces, one per press
+	for (int32_t Index = Begin; Index < End; Index++)
+	{
+		if (Inputs[Index].NumPresses > 0)
+		{
+			StepTimedPresses(Index, Inputs[Index]);
+		}
+	}
+
+	// Combatants whose deadlines passed during the step, in place of counting down and checking every combatants timer
+	for (auto Due = std::lower_bound(DueCombatants.begin(), DueCombatants.end(), Begin); Due != DueCombatants.end() && *Due < End; ++Due)
+	{
+		if (Inputs[*Due].NumPresses == 0)
+		{
+			ResolveCombatant(*Due, StepEnd);
+		}
+	}
+
+	// Locomotion follows the held input of everyone that's free to move
+	for (int32_t Index = Begin; Index < End; Index++)
+	{
+		if (Inputs[Index].NumPresses == 0 && !HasFlag(Index, HLtC::Flag_StaticAction))
+		{
+			ResolveLocomotion(Index);
+		}
+	}
+}
+
+void FHLtC_CombatWorld::EndStep(const FHLtC_CombatInput* Inputs)
+{
+	Clock = StepEnd;
+
+	// Only the combatants the step could have changed the deadlines of
+	for (const int32_t Index : DueCombatants)
+	{
+		ScheduleTimers(Index);
+	}
+
+	for (int32_t Index = 0; Index < Num(); Index++)
+	{
+		if (Inputs[Index].NumPresses > 0)
+		{
+			ScheduleTimers(Index);
+		}
+	}
+}
+
+void FHLtC_CombatWorld::ScheduleTimers(int32_t Index)
+{
+	for (std::vector<int32_t>& Handles : TimerHandles) // Interrupted or finished chains leave nothing behind to fire
+	{
+		Timers.Cancel(Handles[Index]);
+		Handles[Index] = -1;
+	}
+
+	if (!HasFlag(Index, HLtC::Flag_StaticAction))
+	{
+		return;
+	}
+
+	const uint32_t Payload = static_cast<uint32_t>(Index) << TimerEventBits;
+	TimerHandles[Timer_AttackEnds][Index] = Timers.Schedule(StaticActionEnd[Index], Payload | Timer_AttackEnds);
+
+	if (Flags[Index] & (HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered)) // Only a buffered attack or dodge cares when the window opens, presses after that start straight away
+	{
+		TimerHandles[Timer_BufferOpens][Index] = Timers.Schedule(GetBufferOpenTime(Index), Payload | Timer_BufferOpens);
+	}
+}
+
+float FHLtC_CombatWorld::GetStaticActionDurationTimer(int32_t Index) const
+{
+	const int64_t Remaining = HasFlag(Index, HLtC::Flag_StaticAction) ? std::max<int64_t>(StaticActionEnd[Index] - Clock, 0) : 0;
+	return static_cast<float>(static_cast<double>(Remaining) / HLtC::TimeUnitsPerSecond);
+}
+
+void FHLtC_CombatWorld::StepTimedPresses(int32_t Index, const FHLtC_CombatInput& Input)
+{
+	const int64_t Duration = StepEnd - StepStart;
+	int64_t Elapsed = StepStart;
+	for (int32_t Press = 0; Press < Input.NumPresses; Press++)
+	{
+		const int64_t PressTime = StepStart + Duration * Input.PressTimes[Press] / 256;
+		if (PressTime > Elapsed)
+		{
+			ResolveCombatant(Index, PressTime);
+			Elapsed = PressTime;
+		}
+
+		ApplyPress(Index, Input.Presses[Press], PressTime);
+	}
+
+	ResolveCombatant(Index, StepEnd);
+}
+
+void FHLtC_CombatWorld::ApplyPress(int32_t Index, uint8_t Press, int64_t Time)
+{
+	if (HLtC::IsDodgePress(Press))
+	{
+		TryDodgeAt(Index, HLtC::GetDodgeDirection(Press), Time);
+		return;
+	}
+
+	switch (Press)
+	{
+	case HLtC::Input_BlockStarted: SetBlocking(Index, true); break;
+	case HLtC::Input_BlockCompleted: SetBlocking(Index, false); break;
+	case HLtC::Input_LightAttack: TryAttackAt(Index, EHLtC_AttackType::Light, Time); break;
+	case HLtC::Input_HeavyAttack: TryAttackAt(Index, EHLtC_AttackType::Heavy, Time); break;
+	default: break;
+	}
+}
+
+void FHLtC_CombatWorld::ResolveCombatant(int32_t Index, int64_t Time)
+{
+	if (!HasFlag(Index, HLtC::Flag_StaticAction)) // If the combatant is free to move, pick the locomotion action
+	{
+		ResolveLocomotion(Index);
+		return;
+	}
+
+	// Buffered followups fire at the moment their window opened, so one that opens and ends inside the same step still plays out from its deadline
+	while (HasFlag(Index, HLtC::Flag_StaticAction))
+	{
+		const int64_t OpenTime = GetBufferOpenTime(Index);
+		const bool bBufferOpened = OpenTime <= Time && OpenTime < StaticActionEnd[Index];
+
+		if (bBufferOpened && HasFlag(Index, HLtC::Flag_DodgeBuffered)) // If the buffer window has opened, and a dodge has been buffered...
+		{
+			StartDodge(Index, BufferedDodge[Index], OpenTime);
+		}
+
+		else if (bBufferOpened && HasFlag(Index, HLtC::Flag_AttackBuffered)) // If the buffer window has opened, and an additional attack has been buffered...
+		{
+			SetFlag(Index, HLtC::Flag_AttackBuffered, false); // Starts straight away from the open window, or is dropped if the chain no longer links
+			TryAttackAt(Index, CurrentAttackType[Index], OpenTime); // Trigger the buffered attack
+		}
+
+		else
+		{
+			if (StaticActionEnd[Index] <= Time) // If the action has run its course...
+			{
+				EndChain(Index);
+			}
+			break;
+		}
+	}
+}
+
+void FHLtC_CombatWorld::ResolveLocomotion(int32_t Index)
+{
+	const uint8_t CombatantFlags = Flags[Index];
+	const EHLtC_PlayerAction NewAction = !(CombatantFlags & HLtC::Flag_Moving) ? EHLtC_PlayerAction::Idle
+		: (CombatantFlags & HLtC::Flag_Sprinting) ? EHLtC_PlayerAction::Sprinting
+		: EHLtC_PlayerAction::Moving;
+
+	if (NewAction != Action[Index])
+	{
+		Action[Index] = NewAction;
+		AttackIndex[Index] = 0;
+		Changed[Index] = 1;
+		HLtC::IncrementCounter(HLtC::Counter_ActionTransitions);
+	}
+}
+
+void FHLtC_CombatWorld::TryAttack(int32_t Index, EHLtC_AttackType Type)
+{
+	TryAttackAt(Index, Type, Clock);
+	ScheduleTimers(Index);
+}
+
+void FHLtC_CombatWorld::TryAttackAt(int32_t Index, EHLtC_AttackType Type, int64_t Time)
+{
+	const uint16_t NextMove = MoveTable->GetNextMove(GetAttackCursor(Index), Type);
+
+	if (NextMove == HLtC::InvalidMove) // The current move doesn't link to another move for this attack type
+	{
+		HLtC::IncrementCounter(HLtC::Counter_AttacksDropped);
+		return;
+	}
+
+	CurrentAttackType[Index] = Type;
+
+	if (!HasFlag(Index, HLtC::Flag_StaticAction) || GetBufferOpenTime(Index) <= Time) // If the current attack has reached its buffer window, or there's none...
+	{
+		StartMove(Index, NextMove, Time);
+	}
+
+	else // If the user attempts to attack too soon after a prior attack...
+	{
+		Flags[Index] = static_cast<uint8_t>((Flags[Index] | HLtC::Flag_AttackBuffered) & ~HLtC::Flag_DodgeBuffered); // Buffer an attack to use as soon as it can be, in place of any buffered dodge
+		HLtC::IncrementCounter(HLtC::Counter_AttacksBuffered);
+	}
+
+	Changed[Index] = 1;
+}
+
+void FHLtC_CombatWorld::TryDodge(int32_t Index, EHLtC_DodgeDirection Direction)
+{
+	TryDodgeAt(Index, Direction, Clock);
+	ScheduleTimers(Index);
+}
+
+void FHLtC_CombatWorld::TryDodgeAt(int32_t Index, EHLtC_DodgeDirection Direction, int64_t Time)
+{
+	if (!HasFlag(Index, HLtC::Flag_StaticAction) || GetBufferOpenTime(Index) <= Time) // Free, or the current attack or dodge has reached its cancel window
+	{
+		StartDodge(Index, Direction, Time);
+	}
+
+	else // Too soon, dodge as soon as the window opens
+	{
+		BufferedDodge[Index] = Direction;
+		Flags[Index] = static_cast<uint8_t>((Flags[Index] | HLtC::Flag_DodgeBuffered) & ~HLtC::Flag_AttackBuffered);
+		Changed[Index] = 1;
+	}
+}
+
+void FHLtC_CombatWorld::StartDodge(int32_t Index, EHLtC_DodgeDirection Direction, int64_t Time)
+{
+	const FHLtC_CompiledDodge& Dodge = MoveTable->GetDodge(Weapon[Index], Direction);
+
+	AttackMove[Index] = HLtC::InvalidMove; // A dodge ends the chain, attacks out of it start from the entry moves
+	Action[Index] = EHLtC_PlayerAction::Dodge;
+	AttackIndex[Index] = static_cast<uint8_t>(Direction);
+	CurrentAttackType[Index] = EHLtC_AttackType::None;
+	StaticActionEnd[Index] = Time + HLtC::ToTimeUnits(Dodge.Duration);
+	AdditionalAttackBufferTiming[Index] = Dodge.BufferTime; // Attacks and dodges buffered during the dodge fire once this much of it remains
+
+	HLtC::IncrementCounter(HLtC::Counter_ActionTransitions);
+
+	Flags[Index] |= HLtC::Flag_StaticAction;
+	Flags[Index] &= static_cast<uint8_t>(~(HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered | HLtC::Flag_Blocking)); // Dodging drops the guard
+
+	Changed[Index] = 1;
+}
+
+bool FHLtC_CombatWorld::IsInvulnerable(int32_t Index) const
+{
+	if (Action[Index] != EHLtC_PlayerAction::Dodge || !HasFlag(Index, HLtC::Flag_StaticAction))
+	{
+		return false;
+	}
+
+	const FHLtC_CompiledDodge& Dodge = MoveTable->GetDodge(Weapon[Index], static_cast<EHLtC_DodgeDirection>(AttackIndex[Index]));
+	const int64_t Elapsed = HLtC::ToTimeUnits(Dodge.Duration) - (StaticActionEnd[Index] - Clock);
+	return Elapsed >= Dodge.InvulnerableStart && Elapsed < Dodge.InvulnerableEnd;
+}
+
+bool FHLtC_CombatWorld::GetDodgeRootMotion(int32_t Index, float ExtraTime, FHLtC_RootMotionSample& OutRootMotion) const
+{
+	if (Action[Index] != EHLtC_PlayerAction::Dodge || !HasFlag(Index, HLtC::Flag_StaticAction))
+	{
+		return false;
+	}
+
+	const FHLtC_CompiledDodge& Dodge = MoveTable->GetDodge(Weapon[Index], static_cast<EHLtC_DodgeDirection>(AttackIndex[Index]));
+	const float Remaining = static_cast<float>(static_cast<double>(StaticActionEnd[Index] - Clock) / HLtC::TimeUnitsPerSecond);
+	OutRootMotion = MoveTable->SampleRootMotion(Dodge, Dodge.Duration - Remaining + ExtraTime);
+	return true;
+}
+
+void FHLtC_CombatWorld::StartMove(int32_t Index, uint16_t MoveIndex, int64_t Time)
+{
+	const FHLtC_CompiledMove& Move = MoveTable->GetMove(MoveIndex);
+
+	AttackMove[Index] = MoveIndex;
+	Action[Index] = Move.Action;
+	AttackIndex[Index] = Move.ChainIndex;
+	StaticActionEnd[Index] = Time + HLtC::ToTimeUnits(Move.Duration); // Set the attack duration based on what attack it is
+	AdditionalAttackBufferTiming[Index] = Move.BufferTime; // Set the attack buffer based on the moves buffer window
+
+	HLtC::IncrementCounter(HLtC::Counter_AttacksStarted);
+	HLtC::IncrementCounter(HLtC::Counter_ActionTransitions);
+
+	Flags[Index] |= HLtC::Flag_StaticAction | HLtC::Flag_AttackStarted;
+	Flags[Index] &= static_cast<uint8_t>(~(HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered | HLtC::Flag_Blocking)); // Attacking drops the guard
+
+	Changed[Index] = 1;
+}
+
+void FHLtC_CombatWorld::EndChain(int32_t Index)
+{
+	StaticActionEnd[Index] = 0;
+	AdditionalAttackBufferTiming[Index] = 0.0f;
+	AttackMove[Index] = HLtC::InvalidMove;
+	Action[Index] = EHLtC_PlayerAction::Idle; // Leave the attack straight away so a new chain can be entered on the same step
+	AttackIndex[Index] = 0;
+	Flags[Index] &= static_cast<uint8_t>(~(HLtC::Flag_StaticAction | HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered));
+	Changed[Index] = 1;
+
+	HLtC::IncrementCounter(HLtC::Counter_ChainResets);
+	HLtC::IncrementCounter(HLtC::Counter_ActionTransitions);
+}
+
+bool FHLtC_CombatWorld::SetBlocking(int32_t Index, bool bBlocking)
+{
+	if (HasFlag(Index, HLtC::Flag_StaticAction) || HasFlag(Index, HLtC::Flag_Blocking) == bBlocking) // Blocking only changes while the combatant isn't doing an action
+	{
+		return false;
+	}
+
+	SetFlag(Index, HLtC::Flag_Blocking, bBlocking);
+	Changed[Index] = 1;
+	return true;
+}
+
+void FHLtC_CombatWorld::SetControlState(int32_t Index, EHLtC_ControlState NewState)
+{
+	ControlState[Index] = NewState;
+	Changed[Index] = 1;
+}
+
+void FHLtC_CombatWorld::SetCameraState(int32_t Index, EHLtC_CameraState NewState)
+{
+	CameraState[Index] = NewState;
+	Changed[Index] = 1;
+}
+
+bool FHLtC_CombatWorld::HasSameState(const FHLtC_CombatWorld& Other) const
+{
+	auto SameBits = [](const auto& Column, const auto& OtherColumn)
+	{
+		return Column.size() == OtherColumn.size() && std::memcmp(Column.data(), OtherColumn.data(), Column.size() * sizeof(Column[0])) == 0;
+	};
+
+	return Clock == Other.Clock
+		&& SameBits(StaticActionEnd, Other.StaticActionEnd)
+		&& SameBits(AdditionalAttackBufferTiming, Other.AdditionalAttackBufferTiming)
+		&& SameBits(AttackMove, Other.AttackMove)
+		&& SameBits(Weapon, Other.Weapon)
+		&& SameBits(Action, Other.Action)
+		&& SameBits(AttackIndex, Other.AttackIndex)
+		&& SameBits(ControlState, Other.ControlState)
+		&& SameBits(CameraState, Other.CameraState)
+		&& SameBits(CurrentAttackType, Other.CurrentAttackType)
+		&& SameBits(Flags, Other.Flags)
+		&& SameBits(BufferedDodge, Other.BufferedDodge)
+		&& SameBits(Changed, Other.Changed);
+}
+
+void FHLtC_CombatWorld::SaveSnapshot(FHLtC_CombatantSnapshot* OutSnapshots) const
+{
+	const int32_t NumCombatants = Num();
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		SaveCombatant(Index, OutSnapshots[Index]);
+	}
+}
+
+void FHLtC_CombatWorld::SaveCombatant(int32_t Index, FHLtC_CombatantSnapshot& OutSnapshot) const
+{
+	OutSnapshot.StaticActionRemaining = HasFlag(Index, HLtC::Flag_StaticAction) ? static_cast<uint32_t>(std::clamp<int64_t>(StaticActionEnd[Index] - Clock, 0, UINT32_MAX)) : 0;
+	OutSnapshot.AdditionalAttackBufferTiming = AdditionalAttackBufferTiming[Index];
+	OutSnapshot.AttackMove = AttackMove[Index];
+	OutSnapshot.Weapon = Weapon[Index];
+	OutSnapshot.Action = Action[Index];
+	OutSnapshot.AttackIndex = AttackIndex[Index];
+	OutSnapshot.ControlState = ControlState[Index];
+	OutSnapshot.CameraState = CameraState[Index];
+	OutSnapshot.CurrentAttackType = CurrentAttackType[Index];
+	OutSnapshot.Flags = Flags[Index];
+	OutSnapshot.BufferedDodge = BufferedDodge[Index];
+}
+
+void FHLtC_CombatWorld::RestoreSnapshot(const FHLtC_CombatantSnapshot* Snapshots, int64_t InClock)
+{
+	Clock = InClock;
+
+	const int32_t NumCombatants = Num();
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		UnpackCombatant(Index, Snapshots[Index]);
+	}
+
+	std::fill(Changed.begin(), Changed.end(), static_cast<uint8_t>(1)); // Whoever mirrors the world has to catch up with the restored state
+
+	// The wheel isn't part of the snapshot, it's rebuilt from the restored deadlines
+	Timers.Reset(Clock);
+	for (std::vector<int32_t>& Handles : TimerHandles)
+	{
+		std::fill(Handles.begin(), Handles.end(), -1);
+	}
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		ScheduleTimers(Index);
+	}
+}
+
+void FHLtC_CombatWorld::RestoreCombatant(int32_t Index, const FHLtC_CombatantSnapshot& Snapshot)
+{
+	UnpackCombatant(Index, Snapshot);
+	Changed[Index] = 1;
+	ScheduleTimers(Index);
+}
+
+void FHLtC_CombatWorld::UnpackCombatant(int32_t Index, const FHLtC_CombatantSnapshot& Snapshot)
+{
+	StaticActionEnd[Index] = (Snapshot.Flags & HLtC::Flag_StaticAction) ? Clock + Snapshot.StaticActionRemaining : 0;
+	AdditionalAttackBufferTiming[Index] = Snapshot.AdditionalAttackBufferTiming;
+	AttackMove[Index] = Snapshot.AttackMove;
+	Weapon[Index] = Snapshot.Weapon;
+	Action[Index] = Snapshot.Action;
+	AttackIndex[Index] = Snapshot.AttackIndex;
+	ControlState[Index] = Snapshot.ControlState;
+	CameraState[Index] = Snapshot.CameraState;
+	CurrentAttackType[Index] = Snapshot.CurrentAttackType;
+	Flags[Index] = Snapshot.Flags;
+	BufferedDodge[Index] = Snapshot.BufferedDodge;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_RollbackBuffer
+
+void FHLtC_RollbackBuffer::Init(int32_t InNumFrames, int32_t InMaxCombatants)
+{
+	NumFrames = std::max(InNumFrames, 1);
+	MaxCombatants = std::max(InMaxCombatants, 0);
+	NewestFrame = 0;
+
+	Headers.assign(NumFrames, FFrameHeader());
+	Snapshots.assign(static_cast<size_t>(NumFrames) * MaxCombatants, FHLtC_CombatantSnapshot());
+	Inputs.assign(static_cast<size_t>(NumFrames) * MaxCombatants, FHLtC_CombatInput());
+	RecordedStartedMoves.assign(MaxCombatants, HLtC::InvalidMove);
+	LatestStartedMoves.assign(MaxCombatants, HLtC::InvalidMove);
+}
+
+bool FHLtC_RollbackBuffer::SaveFrame(uint32_t Frame, const FHLtC_CombatWorld& World, const FHLtC_CombatInput* FrameInputs, float DeltaTime)
+{
+	const int32_t NumCombatants = World.Num();
+	if (NumFrames == 0 || NumCombatants > MaxCombatants)
+	{
+		return false;
+	}
+
+	const int32_t Slot = GetSlot(Frame);
+	const size_t First = static_cast<size_t>(Slot) * MaxCombatants;
+
+	FFrameHeader& Header = Headers[Slot];
+	Header.Frame = Frame;
+	Header.NumCombatants = NumCombatants;
+	Header.DeltaTime = DeltaTime;
+	Header.Clock = World.Clock;
+
+	World.SaveSnapshot(Snapshots.data() + First);
+	std::copy(FrameInputs, FrameInputs + NumCombatants, Inputs.data() + First);
+
+	NewestFrame = Frame;
+	return true;
+}
+
+bool FHLtC_RollbackBuffer::HasFrame(uint32_t Frame, int32_t NumCombatants) const
+{
+	if (NumFrames == 0 || NewestFrame - Frame >= static_cast<uint32_t>(NumFrames)) // Too old, or newer than anything saved
+	{
+		return false;
+	}
+
+	const FFrameHeader& Header = Headers[GetSlot(Frame)];
+	return Header.Frame == Frame && Header.NumCombatants == NumCombatants;
+}
+
+FHLtC_CombatInput* FHLtC_RollbackBuffer::GetInputs(uint32_t Frame)
+{
+	if (NumFrames == 0 || !HasFrame(Frame, Headers[GetSlot(Frame)].NumCombatants))
+	{
+		return nullptr;
+	}
+
+	return Inputs.data() + static_cast<size_t>(GetSlot(Frame)) * MaxCombatants;
+}
+
+bool FHLtC_RollbackBuffer::RestoreFrame(uint32_t Frame, FHLtC_CombatWorld& World) const
+{
+	if (!HasFrame(Frame, World.Num())) // A combatant joining or leaving invalidates the history before it
+	{
+		return false;
+	}
+
+	World.RestoreSnapshot(Snapshots.data() + static_cast<size_t>(GetSlot(Frame)) * MaxCombatants, Headers[GetSlot(Frame)].Clock);
+	return true;
+}
+
+int32_t FHLtC_RollbackBuffer::Resimulate(uint32_t Frame, FHLtC_CombatWorld& World, std::vector<FHLtC_Attack>* OutStartedAttacks)
+{
+	const uint32_t LastFrame = NewestFrame;
+	for (uint32_t StepFrame = Frame; StepFrame - Frame <= LastFrame - Frame; StepFrame++) // Every replayed step needs its input, for the same combatants
+	{
+		if (!HasFrame(StepFrame, World.Num()))
+		{
+			return 0;
+		}
+	}
+
+	if (OutStartedAttacks) // Nothing holds what the newest recorded step started once the world is rolled back
+	{
+		for (int32_t Index = 0; Index < World.Num(); Index++)
+		{
+			LatestStartedMoves[Index] = World.HasFlag(Index, HLtC::Flag_AttackStarted) ? World.AttackMove[Index] : HLtC::InvalidMove;
+		}
+	}
+
+	RestoreFrame(Frame, World);
+
+	int32_t NumSteps = 0;
+	for (uint32_t StepFrame = Frame; StepFrame - Frame <= LastFrame - Frame; StepFrame++)
+	{
+		const int32_t Slot = GetSlot(StepFrame);
+		const size_t First = static_cast<size_t>(Slot) * MaxCombatants;
+
+		if (StepFrame != Frame) // The restored frame already holds the state it started from
+		{
+			if (OutStartedAttacks) // The recorded state of this frame is where the recorded timeline was after the previous step, compared before it's overwritten
+			{
+				for (int32_t Index = 0; Index < World.Num(); Index++)
+				{
+					const FHLtC_CombatantSnapshot& Recorded = Snapshots[First + Index];
+					RecordedStartedMoves[Index] = (Recorded.Flags & HLtC::Flag_AttackStarted) ? Recorded.AttackMove : HLtC::InvalidMove;
+				}
+				GatherNewAttacks(World, RecordedStartedMoves.data(), *OutStartedAttacks);
+			}
+
+			World.SaveSnapshot(Snapshots.data() + First);
+			Headers[Slot].Clock = World.Clock;
+		}
+
+		World.Step(Inputs.data() + First, Headers[Slot].DeltaTime);
+		NumSteps++;
+	}
+
+	if (OutStartedAttacks)
+	{
+		GatherNewAttacks(World, LatestStartedMoves.data(), *OutStartedAttacks);
+	}
+
+	NewestFrame = LastFrame;
+	return NumSteps;
+}
+
+void FHLtC_RollbackBuffer::GatherNewAttacks(const FHLtC_CombatWorld& World, const uint16_t* StartedMoves, std::vector<FHLtC_Attack>& OutStartedAttacks)
+{
+	for (int32_t Index = 0; Index < World.Num(); Index++)
+	{
+		if (World.HasFlag(Index, HLtC::Flag_AttackStarted) && World.AttackMove[Index] != StartedMoves[Index]) // Already announced when the recorded timeline started it
+		{
+			OutStartedAttacks.push_back({ Index, World.AttackMove[Index] });
+		}
+	}
+}
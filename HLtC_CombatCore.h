@@ -0,0 +1,566 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// The combat rules, free of any engine dependency so they can be built, tested and benchmarked on their own.
+// AHLtC_CombatSystemCharacter and UHLtC_CombatSimulationSubsystem are adapters over this.
+
+#include "HLtC_CombatStats.h"
+#include "HLtC_TimingWheel.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER)
+	#define HLTC_RESTRICT __restrict
+#else
+	#define HLTC_RESTRICT __restrict__
+#endif
+
+// States
+
+enum class EHLtC_ControlState : uint8_t
+{
+	Slow,
+	Action,
+	Count
+};
+
+enum class EHLtC_PlayerAction : uint8_t
+{
+	Idle,
+	Moving,
+	Sprinting,
+	LightAttack,
+	HeavyAttack,
+	Dodge,
+	Count
+};
+
+enum class EHLtC_CameraState : uint8_t
+{
+	Free,
+	Focus,
+	Count
+};
+
+enum class EHLtC_AttackType : uint8_t
+{
+	None,
+	Light,
+	Heavy,
+	Count
+};
+
+/** Relative to the facing of the combatant when the dodge starts */
+enum class EHLtC_DodgeDirection : uint8_t
+{
+	Forward,
+	Backward,
+	Left,
+	Right,
+	Count
+};
+
+namespace HLtC
+{
+	inline constexpr int32_t NumControlStates = static_cast<int32_t>(EHLtC_ControlState::Count);
+	inline constexpr int32_t NumPlayerActions = static_cast<int32_t>(EHLtC_PlayerAction::Count);
+	inline constexpr int32_t NumCameraStates = static_cast<int32_t>(EHLtC_CameraState::Count);
+	inline constexpr int32_t NumLocomotionActions = 3; // Idle, Moving and Sprinting. Only these actions have state defaults, static actions keep the ones they were entered with
+	inline constexpr int32_t NumDodgeDirections = static_cast<int32_t>(EHLtC_DodgeDirection::Count);
+
+	constexpr bool IsLocomotionAction(EHLtC_PlayerAction Action) { return Action <= EHLtC_PlayerAction::Sprinting; }
+	constexpr bool IsAttackAction(EHLtC_PlayerAction Action) { return Action == EHLtC_PlayerAction::LightAttack || Action == EHLtC_PlayerAction::HeavyAttack; }
+
+	constexpr EHLtC_PlayerAction GetAttackAction(EHLtC_AttackType Type)
+	{
+		return Type == EHLtC_AttackType::Heavy ? EHLtC_PlayerAction::HeavyAttack : EHLtC_PlayerAction::LightAttack;
+	}
+
+	inline constexpr uint16_t InvalidMove = 0xFFFF;
+
+	inline constexpr int64_t TimeUnitsPerSecond = 1000000; // The combat clock counts microseconds, so deadlines compare exactly however the steps are split
+
+	inline int64_t ToTimeUnits(float Seconds) { return std::llround(static_cast<double>(Seconds) * TimeUnitsPerSecond); }
+
+	constexpr int32_t GetLinkIndex(EHLtC_AttackType Type) { return Type == EHLtC_AttackType::Heavy ? 1 : 0; }
+
+	/** Bits of FHLtC_CombatWorld::Flags */
+	enum ECombatantFlags : uint8_t
+	{
+		Flag_StaticAction = 1 << 0, // The combatant can't move (e.g. an attack)
+		Flag_AttackBuffered = 1 << 1, // The next attack in the chain should trigger as soon as the buffer window opens
+		Flag_Blocking = 1 << 2, // The block input is being held
+		Flag_Sprinting = 1 << 3, // The sprint input is being held
+		Flag_DodgeBuffered = 1 << 4, // A dodge should trigger as soon as the buffer window opens, in place of a buffered attack
+		Flag_Moving = 1 << 5, // The movement component has a velocity
+		Flag_AttackStarted = 1 << 6, // A move was entered during the last step, so its hit should be resolved
+	};
+
+	/** Values of FHLtC_CombatInput::Presses, edges that happened during the step */
+	enum EInputPressed : uint8_t
+	{
+		Input_LightAttack = 1 << 0,
+		Input_HeavyAttack = 1 << 1,
+		Input_BlockStarted = 1 << 2,
+		Input_BlockCompleted = 1 << 3,
+		Input_Dodge = 1 << 4, // The direction rides in the bits above, see MakeDodgePress
+	};
+
+	inline constexpr uint8_t DodgeDirectionShift = 5;
+
+	constexpr uint8_t MakeDodgePress(EHLtC_DodgeDirection Direction) { return static_cast<uint8_t>(Input_Dodge | static_cast<uint8_t>(Direction) << DodgeDirectionShift); }
+	constexpr bool IsDodgePress(uint8_t Press) { return (Press & ((1 << DodgeDirectionShift) - 1)) == Input_Dodge; }
+	constexpr EHLtC_DodgeDirection GetDodgeDirection(uint8_t Press) { return static_cast<EHLtC_DodgeDirection>((Press >> DodgeDirectionShift) & 3); }
+
+	inline constexpr int32_t MaxPressesPerStep = 4; // Presses beyond this wait for the next step
+
+	/** Bits of FHLtC_CombatInput::Held, levels sampled for the step */
+	enum EInputHeld : uint8_t
+	{
+		Input_Sprinting = 1 << 0,
+		Input_Moving = 1 << 1,
+	};
+}
+
+// Move table
+
+/** Flat, immutable form of an attacks hit data */
+struct FHLtC_CompiledHitData
+{
+	float Damage;
+	float Range;
+	float Radius;
+	float CosHalfArc; // Cosine of half the swing arc, compared against the dot product towards a target
+};
+
+/** A move in the shared move table. Two of these fit in a cache line */
+struct FHLtC_CompiledMove
+{
+	float Duration; // Duration of the move
+	float BufferTime; // Remaining duration at or below which the next move can be triggered
+	uint16_t Next[2]; // Move that follows a light and heavy press respectively, HLtC::InvalidMove ends the chain
+	EHLtC_PlayerAction Action; // LightAttack or HeavyAttack
+	uint8_t ChainIndex; // Depth of the move in its chain, used for the "LightAttack_N" action names
+	FHLtC_CompiledHitData Hit;
+};
+static_assert(sizeof(FHLtC_CompiledMove) == 32, "Keep compiled moves at half a cache line");
+
+/** Root motion of a dodge at one sample, relative to where it started and in the frame the combatant faced when it started */
+struct FHLtC_RootMotionSample
+{
+	float Forward;
+	float Right;
+};
+
+/** Flat, immutable form of a dodge. Its root motion is a run of evenly spaced samples in the move tables sample pool */
+struct FHLtC_CompiledDodge
+{
+	float Duration;
+	float BufferTime; // Remaining duration at or below which an attack or another dodge cancels the dodge
+	int32_t InvulnerableStart; // Time units into the dodge the invulnerability window opens at
+	int32_t InvulnerableEnd; // Time units into the dodge it closes at
+	uint32_t FirstSample;
+	uint32_t NumSamples; // At least 2, the first at the start of the dodge and the last at its end
+};
+
+/** A dodge as handed to FHLtC_MoveTable::AddWeapon */
+struct FHLtC_DodgeDefinition
+{
+	float Duration = 0.6f;
+	float BufferWindow = 0.3f; // Fraction of Duration that has to remain for an attack or dodge to cancel it
+	float InvulnerableStart = 0.05f; // Seconds into the dodge
+	float InvulnerableEnd = 0.35f;
+	const FHLtC_RootMotionSample* Samples = nullptr; // Evenly spaced over Duration, copied into the table. Without any the dodge eases out over Distance
+	int32_t NumSamples = 0;
+	float Distance = 400.0f;
+};
+
+/** A move as handed to FHLtC_MoveTable::AddWeapon. Links are indices into the same weapons definitions */
+struct FHLtC_MoveDefinition
+{
+	float Duration = 0.7f;
+	float BufferWindow = 0.5f; // Fraction of Duration that has to remain for a followup move to be triggered
+	uint16_t NextOnLight = HLtC::InvalidMove;
+	uint16_t NextOnHeavy = HLtC::InvalidMove;
+	bool bHeavy = false;
+	float Damage = 10.0f;
+	float Range = 150.0f;
+	float Radius = 30.0f;
+	float ArcDegrees = 90.0f;
+};
+
+/** The position of a combatant in the move table */
+struct FHLtC_AttackCursor
+{
+	uint16_t Move = HLtC::InvalidMove; // Move currently being performed, HLtC::InvalidMove when no chain is running
+	uint8_t Weapon = 0; // Set of entry moves used to start a chain
+
+	bool IsInChain() const { return Move != HLtC::InvalidMove; }
+};
+
+/**
+ * One contiguous table of compiled attack moves, shared by all combatants.
+ * Weapons are only ever appended, so move and weapon indices stay valid. Storage is allocated at its maximum size up front and the counts are published
+ * after the entries they cover, so a weapon can be appended while other threads read the moves and weapons before it. Only one thread may append at a time.
+ */
+class FHLtC_MoveTable
+{
+public:
+	FHLtC_MoveTable();
+
+	static constexpr int32_t MaxWeapons = 256;
+	static constexpr int32_t MaxMoves = HLtC::InvalidMove;
+	static constexpr int32_t MaxRootMotionSamples = 1 << 18;
+
+	/**
+	 * Compiles a weapons moves into the table. Entries and links index into Definitions. Dodges holds HLtC::NumDodgeDirections definitions, or is null for the defaults.
+	 * Returns the weapon index, or -1 if the table is full
+	 */
+	int32_t AddWeapon(const FHLtC_MoveDefinition* Definitions, int32_t NumDefinitions, uint16_t LightEntry, uint16_t HeavyEntry, const FHLtC_DodgeDefinition* Dodges = nullptr);
+
+	/** Returns the move that an attack of the given type leads to from the cursor, or HLtC::InvalidMove if the chain doesn't continue */
+	uint16_t GetNextMove(const FHLtC_AttackCursor& Cursor, EHLtC_AttackType Type) const
+	{
+		const int32_t Link = HLtC::GetLinkIndex(Type);
+		return Cursor.IsInChain() ? Moves[Cursor.Move].Next[Link] : WeaponEntries[Cursor.Weapon].Entry[Link];
+	}
+
+	const FHLtC_CompiledMove& GetMove(uint16_t MoveIndex) const { return Moves[MoveIndex]; }
+	int32_t NumMoves() const { return NumCompiledMoves.load(std::memory_order_acquire); }
+	int32_t NumWeapons() const { return NumCompiledWeapons.load(std::memory_order_acquire); }
+
+	const FHLtC_CompiledDodge& GetDodge(uint8_t Weapon, EHLtC_DodgeDirection Direction) const { return Dodges[Weapon * HLtC::NumDodgeDirections + static_cast<int32_t>(Direction)]; }
+
+	/** Root motion of a dodge Time seconds in, interpolated between the two samples around it. Clamped to the dodge */
+	FHLtC_RootMotionSample SampleRootMotion(const FHLtC_CompiledDodge& Dodge, float Time) const;
+
+private:
+	struct FWeaponEntries
+	{
+		uint16_t Entry[2]; // First light and heavy move of the weapon
+	};
+
+	// Left uninitialized, pages are only touched once entries are written to them
+	std::unique_ptr<FHLtC_CompiledMove[]> Moves{ new FHLtC_CompiledMove[MaxMoves] };
+	std::unique_ptr<FWeaponEntries[]> WeaponEntries{ new FWeaponEntries[MaxWeapons] };
+	std::unique_ptr<FHLtC_CompiledDodge[]> Dodges{ new FHLtC_CompiledDodge[MaxWeapons * HLtC::NumDodgeDirections] }; // HLtC::NumDodgeDirections per weapon
+	std::unique_ptr<FHLtC_RootMotionSample[]> RootMotion{ new FHLtC_RootMotionSample[MaxRootMotionSamples] }; // Samples of every dodge
+
+	std::atomic<int32_t> NumCompiledMoves{ 0 };
+	std::atomic<int32_t> NumCompiledWeapons{ 0 };
+	int32_t NumRootMotionSamples = 0; // Only read by the appending thread, dodges carry their own range
+};
+
+// Simulation
+
+/** One combatants input for a step */
+struct FHLtC_CombatInput
+{
+	uint8_t Held = 0; // HLtC::EInputHeld
+	uint8_t NumPresses = 0;
+	uint8_t Presses[HLtC::MaxPressesPerStep] = {}; // HLtC::EInputPressed of each press, in the order they happened
+	uint8_t PressTimes[HLtC::MaxPressesPerStep] = {}; // When each press happened, in 256ths of the step
+
+	/** Appends a press Time 256ths into the step, never earlier than the previous press. Returns false if the step is already full */
+	bool AddPress(uint8_t Press, uint8_t Time = 0)
+	{
+		if (NumPresses >= HLtC::MaxPressesPerStep)
+		{
+			return false;
+		}
+
+		Presses[NumPresses] = Press;
+		PressTimes[NumPresses] = NumPresses > 0 && PressTimes[NumPresses - 1] > Time ? PressTimes[NumPresses - 1] : Time;
+		NumPresses++;
+		return true;
+	}
+
+	bool operator==(const FHLtC_CombatInput& Other) const
+	{
+		if (Held != Other.Held || NumPresses != Other.NumPresses)
+		{
+			return false;
+		}
+
+		for (int32_t Press = 0; Press < NumPresses; Press++)
+		{
+			if (Presses[Press] != Other.Presses[Press] || PressTimes[Press] != Other.PressTimes[Press])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	bool operator!=(const FHLtC_CombatInput& Other) const { return !(*this == Other); }
+};
+
+// Input events
+
+enum class EHLtC_InputEvent : uint8_t
+{
+	LightAttack,
+	HeavyAttack,
+	BlockStarted,
+	BlockCompleted,
+	DodgeForward, // Dodges follow EHLtC_DodgeDirection
+	DodgeBackward,
+	DodgeLeft,
+	DodgeRight,
+	SprintStarted,
+	SprintCompleted,
+	Count
+};
+
+/** An input as it arrived, stamped with the time it happened */
+struct FHLtC_InputEvent
+{
+	double Time = 0.0; // Seconds, on the same clock the consumer steps with
+	EHLtC_InputEvent Type = EHLtC_InputEvent::LightAttack;
+};
+
+/**
+ * Fixed capacity, lock-free queue of input events for one combatant.
+ * One thread may push (e.g. the input thread) while one other thread pops (the simulation). Nothing allocates.
+ */
+class FHLtC_InputEventRing
+{
+public:
+	static constexpr uint32_t Capacity = 64; // Must be a power of two
+
+	/** Producer only. Returns false and drops the event if the ring is full */
+	bool Push(const FHLtC_InputEvent& Event)
+	{
+		const uint32_t WriteIndex = Head.load(std::memory_order_relaxed);
+		if (WriteIndex - Tail.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+
+		Events[WriteIndex & (Capacity - 1)] = Event;
+		Head.store(WriteIndex + 1, std::memory_order_release); // Publishes the event
+		return true;
+	}
+
+	/** Consumer only. Returns the oldest event without removing it, or null if the ring is empty */
+	const FHLtC_InputEvent* Peek() const
+	{
+		const uint32_t ReadIndex = Tail.load(std::memory_order_relaxed);
+		return ReadIndex != Head.load(std::memory_order_acquire) ? &Events[ReadIndex & (Capacity - 1)] : nullptr;
+	}
+
+	/** Consumer only. Removes the event returned by Peek */
+	void Pop()
+	{
+		Tail.store(Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); // Hands the slot back to the producer
+	}
+
+	uint32_t Num() const { return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire); }
+
+private:
+	FHLtC_InputEvent Events[Capacity];
+	alignas(64) std::atomic<uint32_t> Head{ 0 }; // Next slot the producer writes. Kept on its own cache line from Tail
+	alignas(64) std::atomic<uint32_t> Tail{ 0 }; // Next slot the consumer reads
+};
+
+namespace HLtC
+{
+	/** Folds an event into a steps input, as a press at Time 256ths into the step or a change of what's held. Returns false if the step has no room for another press */
+	bool ApplyInputEvent(FHLtC_CombatInput& Input, EHLtC_InputEvent Type, uint8_t Time);
+
+	/**
+	 * Moves the events of Ring that happened before StepStart + StepDuration into Input, timed relative to the step. Late events count as happening at its start.
+	 * Newer events, and any that don't fit in the step, stay queued for the next one. Consumer only
+	 */
+	void ConsumeInputEvents(FHLtC_InputEventRing& Ring, FHLtC_CombatInput& Input, double StepStart, double StepDuration);
+}
+
+/** Everything that decides how a combatant steps, packed so a frame of combatants can be copied in one go */
+struct FHLtC_CombatantSnapshot
+{
+	uint32_t StaticActionRemaining; // Time units till the static action concludes
+	float AdditionalAttackBufferTiming;
+	uint16_t AttackMove;
+	uint8_t Weapon;
+	EHLtC_PlayerAction Action;
+	uint8_t AttackIndex;
+	EHLtC_ControlState ControlState;
+	EHLtC_CameraState CameraState;
+	EHLtC_AttackType CurrentAttackType;
+	uint8_t Flags;
+	EHLtC_DodgeDirection BufferedDodge;
+};
+static_assert(std::is_trivially_copyable<FHLtC_CombatantSnapshot>::value, "Snapshots are copied as raw memory");
+
+/** An attack a combatant started, to announce and resolve */
+struct FHLtC_Attack
+{
+	int32_t Attacker;
+	uint16_t Move; // Move in the move table, whose hit data shapes the attack
+};
+static_assert(sizeof(FHLtC_CombatantSnapshot) == 20, "Keep snapshots packed");
+
+/**
+ * The hot combat state of every combatant, one array per field. Index i of each array belongs to combatant i.
+ * Stepping a combatant only reads and writes its own index and the immutable move table, so ranges can be stepped on any thread.
+ * Static actions end, and buffered attacks fire, from deadlines in a timing wheel, so a combatant is only looked at when one of its deadlines passes or it gets a press.
+ */
+struct FHLtC_CombatWorld
+{
+	int64_t Clock = 0; // Time units simulated so far
+	std::vector<int64_t> StaticActionEnd; // Clock time the static action concludes at
+	std::vector<float> AdditionalAttackBufferTiming; // Remaining duration at or below which a followup attack can be triggered
+	std::vector<uint16_t> AttackMove; // Current move in the move table, HLtC::InvalidMove when no chain is running
+	std::vector<uint8_t> Weapon; // Entry moves used to start a chain
+	std::vector<EHLtC_PlayerAction> Action;
+	std::vector<uint8_t> AttackIndex; // Chain index of the current action for attacks, the EHLtC_DodgeDirection for dodges
+	std::vector<EHLtC_ControlState> ControlState;
+	std::vector<EHLtC_CameraState> CameraState;
+	std::vector<EHLtC_AttackType> CurrentAttackType; // Type of the attack currently being used or buffered
+	std::vector<uint8_t> Flags; // HLtC::ECombatantFlags
+	std::vector<EHLtC_DodgeDirection> BufferedDodge; // Direction of the dodge to trigger, only meaningful with HLtC::Flag_DodgeBuffered
+	std::vector<uint8_t> Changed; // Set when the combatant changed, cleared by whoever consumes the change
+
+	const FHLtC_MoveTable* MoveTable = nullptr;
+
+	FHLtC_CombatWorld() = default;
+	explicit FHLtC_CombatWorld(const FHLtC_MoveTable& InMoveTable) : MoveTable(&InMoveTable) {}
+
+	int32_t Num() const { return static_cast<int32_t>(Flags.size()); }
+	void Reserve(int32_t Capacity);
+	int32_t Add(uint8_t InWeapon); // Returns the new combatants index
+	void RemoveAtSwap(int32_t Index); // Moves the last combatant into Index
+
+	/** Advances every combatant by one fixed step. Inputs holds one entry per combatant */
+	void Step(const FHLtC_CombatInput* Inputs, float DeltaTime)
+	{
+		BeginStep(DeltaTime);
+		StepRange(0, Num(), Inputs);
+		EndStep(Inputs);
+	}
+
+	// A step split up, so the middle can be spread across threads. BeginStep and EndStep run alone, StepRange once for every combatant in between
+
+	void BeginStep(float DeltaTime); // Collects the combatants whose deadlines pass during the step
+	void StepRange(int32_t Begin, int32_t End, const FHLtC_CombatInput* Inputs); // Advances combatants [Begin, End). Disjoint ranges can be stepped concurrently, with the same results
+	void EndStep(const FHLtC_CombatInput* Inputs); // Moves the clock on and schedules the deadlines the step changed
+
+	float GetStaticActionDurationTimer(int32_t Index) const; // Seconds till the static action concludes
+
+	bool HasFlag(int32_t Index, HLtC::ECombatantFlags Flag) const { return (Flags[Index] & Flag) != 0; }
+	void SetFlag(int32_t Index, HLtC::ECombatantFlags Flag, bool bValue) { Flags[Index] = static_cast<uint8_t>(bValue ? (Flags[Index] | Flag) : (Flags[Index] & ~Flag)); }
+	FHLtC_AttackCursor GetAttackCursor(int32_t Index) const { return { AttackMove[Index], Weapon[Index] }; }
+
+	void TryAttack(int32_t Index, EHLtC_AttackType Type); // Starts the next move of the chain for the given attack type, or buffers it if the current move hasn't reached its buffer window
+	void TryDodge(int32_t Index, EHLtC_DodgeDirection Direction); // Starts a dodge, cancelling the current action if it has reached its buffer window, or buffers it if it hasn't
+
+	bool IsInvulnerable(int32_t Index) const; // True while the combatant is inside the invulnerability window of a dodge
+
+	/** Root motion of the combatants dodge so far, ExtraTime seconds past the clock. Returns false if it isn't dodging */
+	bool GetDodgeRootMotion(int32_t Index, float ExtraTime, FHLtC_RootMotionSample& OutRootMotion) const;
+	bool SetBlocking(int32_t Index, bool bBlocking); // Returns true if blocking changed. It only changes while not performing a static action
+	void SetControlState(int32_t Index, EHLtC_ControlState NewState);
+	void SetCameraState(int32_t Index, EHLtC_CameraState NewState);
+
+	bool HasSameState(const FHLtC_CombatWorld& Other) const; // Bitwise comparison of every column
+
+	void SaveSnapshot(FHLtC_CombatantSnapshot* OutSnapshots) const; // Packs every combatant into OutSnapshots, which holds Num() entries
+	void RestoreSnapshot(const FHLtC_CombatantSnapshot* Snapshots, int64_t InClock); // Unpacks Num() combatants saved at InClock and marks them all changed. Doesn't allocate once the timer pool has grown
+
+	void SaveCombatant(int32_t Index, FHLtC_CombatantSnapshot& OutSnapshot) const; // Packs a single combatant
+	void RestoreCombatant(int32_t Index, const FHLtC_CombatantSnapshot& Snapshot); // Unpacks a single combatant as of the current clock, marks it changed and reschedules its deadlines. Not during a step
+
+private:
+	/** What a timer of the wheel marks. Its payload is the combatant index shifted up past these */
+	enum ETimerEvent : uint32_t
+	{
+		Timer_AttackEnds, // The static action concludes
+		Timer_BufferOpens, // The buffered followup attack or dodge can start
+		Timer_NumEvents,
+	};
+	static constexpr uint32_t TimerEventBits = 1;
+
+	void ApplyPress(int32_t Index, uint8_t Press, int64_t Time);
+	void StepTimedPresses(int32_t Index, const FHLtC_CombatInput& Input); // Resolves the combatant at each press in turn, so it's applied at the exact time it happened
+	void TryAttackAt(int32_t Index, EHLtC_AttackType Type, int64_t Time);
+	void TryDodgeAt(int32_t Index, EHLtC_DodgeDirection Direction, int64_t Time);
+	void StartDodge(int32_t Index, EHLtC_DodgeDirection Direction, int64_t Time);
+	void StartMove(int32_t Index, uint16_t MoveIndex, int64_t Time); // Enters a move of the move table
+	void EndChain(int32_t Index); // Sets variables ready for the combatant to move freely again
+	void ResolveCombatant(int32_t Index, int64_t Time); // Handles passed deadlines, buffered attacks and locomotion changes of a single combatant
+	void ResolveLocomotion(int32_t Index); // Picks the locomotion action of a combatant that's free to move
+	void ScheduleTimers(int32_t Index); // Replaces the combatants pending timers with ones for its current deadlines. Cancels them if it has none
+	void UnpackCombatant(int32_t Index, const FHLtC_CombatantSnapshot& Snapshot); // Sets the combatants columns, deadlines relative to the clock
+	int64_t GetBufferOpenTime(int32_t Index) const { return StaticActionEnd[Index] - HLtC::ToTimeUnits(AdditionalAttackBufferTiming[Index]); }
+
+	FHLtC_TimingWheel Timers;
+	std::vector<int32_t> TimerHandles[Timer_NumEvents]; // Pending timer of each combatant for each event, -1 if none
+	std::vector<uint32_t> FiredTimers; // Scratch for the wheel
+	std::vector<int32_t> DueCombatants; // Combatants with a timer that fired this step, sorted
+	int64_t StepStart = 0;
+	int64_t StepEnd = 0;
+};
+
+// Rollback
+
+/**
+ * Ring buffer of the last NumFrames steps of a world: the state each step started from and the input it was given.
+ * Used to roll the world back to an earlier step and replay it, e.g. once a late remote input arrives. Nothing allocates after Init.
+ */
+class FHLtC_RollbackBuffer
+{
+public:
+	/** Allocates room for NumFrames steps of up to MaxCombatants combatants, dropping any history */
+	void Init(int32_t InNumFrames, int32_t InMaxCombatants);
+
+	int32_t GetNumFrames() const { return NumFrames; }
+	int32_t GetMaxCombatants() const { return MaxCombatants; }
+
+	/** Records the state of World before it steps Frame, and the input it steps with. Returns false if World has more combatants than fit */
+	bool SaveFrame(uint32_t Frame, const FHLtC_CombatWorld& World, const FHLtC_CombatInput* Inputs, float DeltaTime);
+
+	/** Returns true if Frame is still held and was saved with NumCombatants combatants */
+	bool HasFrame(uint32_t Frame, int32_t NumCombatants) const;
+
+	/** Recorded input of a held frame, writable so late input can be corrected before resimulating. Null if the frame isn't held */
+	FHLtC_CombatInput* GetInputs(uint32_t Frame);
+
+	/** Puts World back to the state it was in before stepping Frame. Fails if the frame isn't held or the combatants have changed since */
+	bool RestoreFrame(uint32_t Frame, FHLtC_CombatWorld& World) const;
+
+	/**
+	 * Restores Frame and steps the world again through every newer saved frame with the recorded input, re-saving each one on the way.
+	 * World ends up where it would be had the recorded input been known all along. Returns the number of steps replayed, 0 if Frame couldn't be restored.
+	 * OutStartedAttacks, if given, gets the attacks the replayed steps started that the recorded timeline didn't start on the same step, in step order
+	 */
+	int32_t Resimulate(uint32_t Frame, FHLtC_CombatWorld& World, std::vector<FHLtC_Attack>* OutStartedAttacks = nullptr);
+
+private:
+	struct FFrameHeader
+	{
+		uint32_t Frame = 0;
+		int32_t NumCombatants = -1; // -1 while the slot is empty
+		float DeltaTime = 0.0f;
+		int64_t Clock = 0; // Clock of the world when the frame was saved
+	};
+
+	int32_t GetSlot(uint32_t Frame) const { return static_cast<int32_t>(Frame % static_cast<uint32_t>(NumFrames)); }
+
+	int32_t NumFrames = 0;
+	int32_t MaxCombatants = 0;
+	uint32_t NewestFrame = 0;
+
+	std::vector<FFrameHeader> Headers; // One per slot
+	std::vector<FHLtC_CombatantSnapshot> Snapshots; // MaxCombatants per slot
+	std::vector<FHLtC_CombatInput> Inputs; // MaxCombatants per slot
+	std::vector<uint16_t> RecordedStartedMoves; // MaxCombatants. Moves the recorded timeline started on the step being replayed, HLtC::InvalidMove for none
+	std::vector<uint16_t> LatestStartedMoves; // MaxCombatants. Same for the newest step, taken from the world before it's rolled back
+
+	/** Adds the attacks World started on its last step that the recorded timeline didn't, per StartedMoves */
+	static void GatherNewAttacks(const FHLtC_CombatWorld& World, const uint16_t* StartedMoves, std::vector<FHLtC_Attack>& OutStartedAttacks);
+};
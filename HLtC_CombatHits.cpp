@@ -0,0 +1,292 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatHits.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define HLTC_HITS_SSE 1
+	#include <emmintrin.h>
+#else
+	#define HLTC_HITS_SSE 0
+#endif
+
+namespace
+{
+	/**
+	 * Whether a target at Delta from the attacker is inside the swept arc of Move. Squared distances only, no square root.
+	 * The arc test Facing >= Cos * Distance is squared keeping the signs, as Facing * |Facing| >= Cos * |Cos| * Distance^2.
+	 * The SSE narrow phase does the same operations in the same order, so both give the same answer on every edge
+	 */
+	inline bool IsInAttackArc(const FHLtC_CompiledMove& Move, float CosHalfArcSigned, float ForwardX, float ForwardY, float DeltaX, float DeltaY, float DeltaZ, float TargetRadius, float TargetHalfHeight)
+	{
+		const float DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY;
+
+		const float Reach = Move.Hit.Range + Move.Hit.Radius + TargetRadius;
+		const bool bInReach = DistanceSquared <= Reach * Reach;
+		const bool bInHeight = std::fabs(DeltaZ) <= TargetHalfHeight + Move.Hit.Radius;
+
+		// Within the arc if the direction to the target is within half the arc of the attackers facing. Targets overlapping the attacker are always in it
+		const float Facing = ForwardX * DeltaX + ForwardY * DeltaY;
+		const float Overlap = TargetRadius + Move.Hit.Radius;
+		const bool bInArc = Facing * std::fabs(Facing) >= CosHalfArcSigned * DistanceSquared || DistanceSquared <= Overlap * Overlap;
+
+		return bInReach && bInHeight && bInArc;
+	}
+
+	inline float GetCosHalfArcSigned(const FHLtC_CompiledMove& Move) { return Move.Hit.CosHalfArc * std::fabs(Move.Hit.CosHalfArc); }
+
+	/** Whether an attack of Move by Attacker reaches Target */
+	inline bool DoesAttackHit(const FHLtC_CombatantBounds& Bounds, const FHLtC_CompiledMove& Move, int32_t Attacker, int32_t Target)
+	{
+		return Target != Attacker && Bounds.Invulnerable[Target] == 0
+			&& IsInAttackArc(Move, GetCosHalfArcSigned(Move), Bounds.ForwardX[Attacker], Bounds.ForwardY[Attacker], Bounds.X[Target] - Bounds.X[Attacker],
+				Bounds.Y[Target] - Bounds.Y[Attacker], Bounds.Z[Target] - Bounds.Z[Attacker], Bounds.Radius[Target], Bounds.HalfHeight[Target]);
+	}
+
+	/** Blocking only stops attacks coming from in front of the target */
+	inline bool IsHitBlocked(const FHLtC_CombatantBounds& Bounds, int32_t Attacker, int32_t Target)
+	{
+		const float Facing = Bounds.ForwardX[Target] * (Bounds.X[Attacker] - Bounds.X[Target]) + Bounds.ForwardY[Target] * (Bounds.Y[Attacker] - Bounds.Y[Target]);
+		return Bounds.Blocking[Target] != 0 && Facing > 0.0f;
+	}
+}
+
+void HLtC::GatherStartedAttacks(const FHLtC_CombatWorld& World, std::vector<FHLtC_Attack>& OutAttacks)
+{
+	for (int32_t Index = 0; Index < World.Num(); Index++)
+	{
+		if (World.HasFlag(Index, HLtC::Flag_AttackStarted))
+		{
+			OutAttacks.push_back({ Index, World.AttackMove[Index] });
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_CombatantBounds
+
+void FHLtC_CombatantBounds::SetNum(int32_t NumCombatants)
+{
+	X.resize(NumCombatants);
+	Y.resize(NumCombatants);
+	Z.resize(NumCombatants);
+	ForwardX.resize(NumCombatants);
+	ForwardY.resize(NumCombatants);
+	Radius.resize(NumCombatants);
+	HalfHeight.resize(NumCombatants);
+	Blocking.resize(NumCombatants);
+	Invulnerable.resize(NumCombatants);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_HitResolver
+
+uint32_t FHLtC_HitResolver::GetBucket(int32_t InCellX, int32_t InCellY) const
+{
+	const uint32_t Hash = static_cast<uint32_t>(InCellX) * 73856093u ^ static_cast<uint32_t>(InCellY) * 19349663u;
+	return Hash & BucketMask;
+}
+
+void FHLtC_HitResolver::BuildGrid(const FHLtC_CombatantBounds& Bounds)
+{
+	const int32_t NumCombatants = Bounds.Num();
+
+	uint32_t NumBuckets = 64;
+	while (NumBuckets < static_cast<uint32_t>(NumCombatants) * 2) // Twice as many buckets as combatants keeps collisions rare
+	{
+		NumBuckets *= 2;
+	}
+	BucketMask = NumBuckets - 1;
+
+	CellX.resize(NumCombatants);
+	CellY.resize(NumCombatants);
+	BucketStart.assign(NumBuckets + 1, 0);
+	Entries.resize(NumCombatants);
+
+	const float InvCellSize = 1.0f / CellSize;
+	MaxTargetRadius = 0.0f;
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		CellX[Index] = static_cast<int32_t>(std::floor(Bounds.X[Index] * InvCellSize));
+		CellY[Index] = static_cast<int32_t>(std::floor(Bounds.Y[Index] * InvCellSize));
+		BucketStart[GetBucket(CellX[Index], CellY[Index]) + 1]++;
+		MaxTargetRadius = std::max(MaxTargetRadius, Bounds.Radius[Index]);
+	}
+
+	for (uint32_t Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		BucketStart[Bucket + 1] += BucketStart[Bucket];
+	}
+
+	BucketCursor.assign(BucketStart.begin(), BucketStart.end() - 1);
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		Entries[BucketCursor[GetBucket(CellX[Index], CellY[Index])]++] = Index;
+	}
+}
+
+void FHLtC_HitResolver::Resolve(const FHLtC_CombatantBounds& Bounds, const FHLtC_MoveTable& MoveTable, const FHLtC_Attack* Attacks, int32_t NumAttacks, std::vector<FHLtC_HitEvent>& OutHits)
+{
+	if (NumAttacks == 0)
+	{
+		return;
+	}
+
+	BuildGrid(Bounds);
+
+	const size_t HitsCapacity = OutHits.capacity();
+	const size_t CandidatesCapacity = Candidates.capacity();
+	const size_t CandidateColumnsCapacity = CandidateX.capacity();
+
+	const float InvCellSize = 1.0f / CellSize;
+	for (int32_t AttackIndex = 0; AttackIndex < NumAttacks; AttackIndex++)
+	{
+		const FHLtC_Attack& Attack = Attacks[AttackIndex];
+		const FHLtC_CompiledMove& Move = MoveTable.GetMove(Attack.Move);
+
+		// Broadphase. Every cell the attacks reach could put a target in
+		const float Reach = Move.Hit.Range + Move.Hit.Radius + MaxTargetRadius;
+		const int32_t MinX = static_cast<int32_t>(std::floor((Bounds.X[Attack.Attacker] - Reach) * InvCellSize));
+		const int32_t MaxX = static_cast<int32_t>(std::floor((Bounds.X[Attack.Attacker] + Reach) * InvCellSize));
+		const int32_t MinY = static_cast<int32_t>(std::floor((Bounds.Y[Attack.Attacker] - Reach) * InvCellSize));
+		const int32_t MaxY = static_cast<int32_t>(std::floor((Bounds.Y[Attack.Attacker] + Reach) * InvCellSize));
+
+		VisitedBuckets.clear();
+		Candidates.clear();
+		for (int32_t QueryY = MinY; QueryY <= MaxY; QueryY++)
+		{
+			for (int32_t QueryX = MinX; QueryX <= MaxX; QueryX++)
+			{
+				const uint32_t Bucket = GetBucket(QueryX, QueryY);
+				if (std::find(VisitedBuckets.begin(), VisitedBuckets.end(), Bucket) != VisitedBuckets.end())
+				{
+					continue;
+				}
+				VisitedBuckets.push_back(Bucket);
+
+				Candidates.insert(Candidates.end(), Entries.begin() + BucketStart[Bucket], Entries.begin() + BucketStart[Bucket + 1]); // Buckets can hold other cells too, the narrow phase rejects them
+			}
+		}
+
+		std::sort(Candidates.begin(), Candidates.end()); // Keeps the hit order independent of the grid layout
+		TestCandidates(Bounds, Move, Attack.Attacker, OutHits);
+	}
+
+	HLtC::CountGrowth(OutHits, HitsCapacity);
+	HLtC::CountGrowth(Candidates, CandidatesCapacity);
+	HLtC::CountGrowth(CandidateX, CandidateColumnsCapacity); // The other candidate columns grow with it
+}
+
+void FHLtC_HitResolver::TestCandidates(const FHLtC_CombatantBounds& Bounds, const FHLtC_CompiledMove& Move, int32_t Attacker, std::vector<FHLtC_HitEvent>& OutHits)
+{
+	// Copy the candidates that can be hit at all into the scratch columns, compacting Candidates to match. Padded to whole groups of four, whose lanes past the end are masked off
+	int32_t NumCandidates = 0;
+	for (const int32_t Target : Candidates)
+	{
+		NumCandidates += Target != Attacker && Bounds.Invulnerable[Target] == 0 ? 1 : 0;
+	}
+
+	const size_t NumPadded = (static_cast<size_t>(NumCandidates) + 3) & ~static_cast<size_t>(3);
+	CandidateX.resize(NumPadded);
+	CandidateY.resize(NumPadded);
+	CandidateZ.resize(NumPadded);
+	CandidateRadius.resize(NumPadded);
+	CandidateHalfHeight.resize(NumPadded);
+
+	int32_t Gathered = 0;
+	for (const int32_t Target : Candidates)
+	{
+		if (Target == Attacker || Bounds.Invulnerable[Target] != 0)
+		{
+			continue;
+		}
+
+		Candidates[Gathered] = Target;
+		CandidateX[Gathered] = Bounds.X[Target];
+		CandidateY[Gathered] = Bounds.Y[Target];
+		CandidateZ[Gathered] = Bounds.Z[Target];
+		CandidateRadius[Gathered] = Bounds.Radius[Target];
+		CandidateHalfHeight[Gathered] = Bounds.HalfHeight[Target];
+		Gathered++;
+	}
+
+	const float AttackerX = Bounds.X[Attacker];
+	const float AttackerY = Bounds.Y[Attacker];
+	const float AttackerZ = Bounds.Z[Attacker];
+	const float ForwardX = Bounds.ForwardX[Attacker];
+	const float ForwardY = Bounds.ForwardY[Attacker];
+	const float CosHalfArcSigned = GetCosHalfArcSigned(Move);
+
+	const auto AppendHit = [&Bounds, &Move, Attacker, &OutHits](int32_t Target)
+	{
+		OutHits.push_back({ Attacker, Target, Move.Hit.Damage, IsHitBlocked(Bounds, Attacker, Target) });
+	};
+
+#if HLTC_HITS_SSE
+	// Four candidates a lane each, with the same operations as IsInAttackArc. The mask of each group is walked in lane order so hits stay ordered by target
+	const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 AttackerX4 = _mm_set1_ps(AttackerX);
+	const __m128 AttackerY4 = _mm_set1_ps(AttackerY);
+	const __m128 AttackerZ4 = _mm_set1_ps(AttackerZ);
+	const __m128 ForwardX4 = _mm_set1_ps(ForwardX);
+	const __m128 ForwardY4 = _mm_set1_ps(ForwardY);
+	const __m128 Range4 = _mm_set1_ps(Move.Hit.Range + Move.Hit.Radius);
+	const __m128 HitRadius4 = _mm_set1_ps(Move.Hit.Radius);
+	const __m128 CosHalfArcSigned4 = _mm_set1_ps(CosHalfArcSigned);
+	for (int32_t First = 0; First < NumCandidates; First += 4)
+	{
+		const __m128 DeltaX = _mm_sub_ps(_mm_loadu_ps(CandidateX.data() + First), AttackerX4);
+		const __m128 DeltaY = _mm_sub_ps(_mm_loadu_ps(CandidateY.data() + First), AttackerY4);
+		const __m128 DeltaZ = _mm_sub_ps(_mm_loadu_ps(CandidateZ.data() + First), AttackerZ4);
+		const __m128 TargetRadius = _mm_loadu_ps(CandidateRadius.data() + First);
+		const __m128 DistanceSquared = _mm_add_ps(_mm_mul_ps(DeltaX, DeltaX), _mm_mul_ps(DeltaY, DeltaY));
+
+		const __m128 Reach = _mm_add_ps(Range4, TargetRadius);
+		const __m128 InReach = _mm_cmple_ps(DistanceSquared, _mm_mul_ps(Reach, Reach));
+		const __m128 InHeight = _mm_cmple_ps(_mm_and_ps(DeltaZ, AbsMask), _mm_add_ps(_mm_loadu_ps(CandidateHalfHeight.data() + First), HitRadius4));
+
+		const __m128 Facing = _mm_add_ps(_mm_mul_ps(ForwardX4, DeltaX), _mm_mul_ps(ForwardY4, DeltaY));
+		const __m128 Overlap = _mm_add_ps(TargetRadius, HitRadius4);
+		const __m128 InArc = _mm_or_ps(_mm_cmpge_ps(_mm_mul_ps(Facing, _mm_and_ps(Facing, AbsMask)), _mm_mul_ps(CosHalfArcSigned4, DistanceSquared)),
+			_mm_cmple_ps(DistanceSquared, _mm_mul_ps(Overlap, Overlap)));
+
+		const int32_t NumLanes = std::min(NumCandidates - First, 4);
+		const int32_t HitMask = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(InReach, InHeight), InArc)) & ((1 << NumLanes) - 1);
+		for (int32_t Lane = 0; HitMask >> Lane; Lane++)
+		{
+			if (HitMask & (1 << Lane))
+			{
+				AppendHit(Candidates[First + Lane]);
+			}
+		}
+	}
+#else
+	for (int32_t Candidate = 0; Candidate < NumCandidates; Candidate++)
+	{
+		if (IsInAttackArc(Move, CosHalfArcSigned, ForwardX, ForwardY, CandidateX[Candidate] - AttackerX, CandidateY[Candidate] - AttackerY, CandidateZ[Candidate] - AttackerZ,
+			CandidateRadius[Candidate], CandidateHalfHeight[Candidate]))
+		{
+			AppendHit(Candidates[Candidate]);
+		}
+	}
+#endif
+}
+
+void FHLtC_HitResolver::ResolveBruteForce(const FHLtC_CombatantBounds& Bounds, const FHLtC_MoveTable& MoveTable, const FHLtC_Attack* Attacks, int32_t NumAttacks, std::vector<FHLtC_HitEvent>& OutHits)
+{
+	for (int32_t AttackIndex = 0; AttackIndex < NumAttacks; AttackIndex++)
+	{
+		const FHLtC_Attack& Attack = Attacks[AttackIndex];
+		const FHLtC_CompiledMove& Move = MoveTable.GetMove(Attack.Move);
+
+		for (int32_t Target = 0; Target < Bounds.Num(); Target++)
+		{
+			if (DoesAttackHit(Bounds, Move, Attack.Attacker, Target))
+			{
+				OutHits.push_back({ Attack.Attacker, Target, Move.Hit.Damage, IsHitBlocked(Bounds, Attack.Attacker, Target) });
+			}
+		}
+	}
+}
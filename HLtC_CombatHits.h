@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Hit resolution for the attacks started by an FHLtC_CombatWorld. Engine independent, like the rest of the core.
+// Every attack of a frame is tested in one batch against a uniform grid of the combatants, instead of each attacker tracing the world.
+
+#include "HLtC_CombatCore.h"
+
+/** Where each combatant is this frame, one array per field. Index i belongs to combatant i of the world */
+struct FHLtC_CombatantBounds
+{
+	std::vector<float> X;
+	std::vector<float> Y;
+	std::vector<float> Z; // Centre of the capsule
+	std::vector<float> ForwardX; // Horizontal facing, normalized
+	std::vector<float> ForwardY;
+	std::vector<float> Radius; // Capsule radius
+	std::vector<float> HalfHeight; // Capsule half height
+	std::vector<uint8_t> Blocking; // Non-zero while the combatant is blocking
+	std::vector<uint8_t> Invulnerable; // Non-zero while the combatant can't be hit, e.g. during the invulnerability window of a dodge
+
+	int32_t Num() const { return static_cast<int32_t>(X.size()); }
+	void SetNum(int32_t NumCombatants); // Keeps the allocation when shrinking
+};
+
+/** An attack that connected */
+struct FHLtC_HitEvent
+{
+	int32_t Attacker;
+	int32_t Target;
+	float Damage;
+	bool bBlocked; // The target was blocking and facing the attacker
+};
+
+namespace HLtC
+{
+	/** Appends an attack for every combatant of World that entered a move during its last step */
+	void GatherStartedAttacks(const FHLtC_CombatWorld& World, std::vector<FHLtC_Attack>& OutAttacks);
+}
+
+/**
+ * Resolves a frames attacks against a spatial hash grid of the combatants.
+ * Attacks are swept arcs: a horizontal sector of the moves range and arc, thickened by its radius, tested against each targets capsule.
+ * All buffers are kept between frames, so nothing allocates once they've grown to the largest frame seen.
+ */
+class FHLtC_HitResolver
+{
+public:
+	float CellSize = 400.0f; // Width of a grid cell. Best around the longest attack reach
+
+	/** Appends the hits of every attack to OutHits. Attacks are resolved in order, and the hits of each attack are ordered by target index */
+	void Resolve(const FHLtC_CombatantBounds& Bounds, const FHLtC_MoveTable& MoveTable, const FHLtC_Attack* Attacks, int32_t NumAttacks, std::vector<FHLtC_HitEvent>& OutHits);
+
+	/** Reference version that tests every attack against every combatant, for checking and benchmarking Resolve */
+	static void ResolveBruteForce(const FHLtC_CombatantBounds& Bounds, const FHLtC_MoveTable& MoveTable, const FHLtC_Attack* Attacks, int32_t NumAttacks, std::vector<FHLtC_HitEvent>& OutHits);
+
+private:
+	void BuildGrid(const FHLtC_CombatantBounds& Bounds);
+	uint32_t GetBucket(int32_t CellX, int32_t CellY) const;
+
+	/** Copies the candidates into the scratch columns and tests them against one attack, four at a time with SSE where it's available, appending the hits in target order */
+	void TestCandidates(const FHLtC_CombatantBounds& Bounds, const FHLtC_CompiledMove& Move, int32_t Attacker, std::vector<FHLtC_HitEvent>& OutHits);
+
+	// Grid, a counting sort of the combatants by the bucket their cell hashes to
+	uint32_t BucketMask = 0;
+	float MaxTargetRadius = 0.0f;
+	std::vector<int32_t> CellX; // Cell of each combatant
+	std::vector<int32_t> CellY;
+	std::vector<uint32_t> BucketStart; // First entry of each bucket in Entries, plus one past the end
+	std::vector<uint32_t> BucketCursor; // Next entry to fill of each bucket while building
+	std::vector<int32_t> Entries; // Combatant indices, grouped by bucket
+
+	// Per attack scratch
+	std::vector<uint32_t> VisitedBuckets; // Distinct cells can share a bucket, which must only be gathered once
+	std::vector<int32_t> Candidates;
+	std::vector<float> CandidateX; // The candidates bounds, one column per field like FHLtC_CombatantBounds, so groups of four load straight into SIMD registers
+	std::vector<float> CandidateY;
+	std::vector<float> CandidateZ;
+	std::vector<float> CandidateRadius;
+	std::vector<float> CandidateHalfHeight;
+};
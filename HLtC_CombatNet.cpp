@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatNet.h"
+
+#include <algorithm>
+
+FHLtC_NetCombatState FHLtC_NetCombatState::FromSnapshot(const FHLtC_CombatantSnapshot& Snapshot, uint8_t InInputAck)
+{
+	FHLtC_NetCombatState State;
+	State.AttackMove = Snapshot.AttackMove < (1 << HLtC::NetMoveBits) ? Snapshot.AttackMove : HLtC::InvalidMove;
+	State.Action = Snapshot.Action;
+	State.ControlState = Snapshot.ControlState;
+	State.CurrentAttackType = Snapshot.CurrentAttackType;
+	State.Flags = Snapshot.Flags & HLtC::NetFlagsMask;
+	State.InputAck = InInputAck;
+	State.DodgeDirection = Snapshot.Action == EHLtC_PlayerAction::Dodge ? static_cast<EHLtC_DodgeDirection>(Snapshot.AttackIndex & 3) : EHLtC_DodgeDirection::Forward;
+	State.BufferedDodge = (State.Flags & HLtC::Flag_DodgeBuffered) ? Snapshot.BufferedDodge : EHLtC_DodgeDirection::Forward;
+
+	if (State.Flags & HLtC::Flag_StaticAction) // Rounded up, so a client never ends an action before the server does
+	{
+		const int64_t Units = (static_cast<int64_t>(Snapshot.StaticActionRemaining) + HLtC::NetTimerUnit - 1) / HLtC::NetTimerUnit;
+		State.StaticActionRemaining = static_cast<uint16_t>(std::min<int64_t>(Units, (1 << HLtC::NetTimerBits) - 1));
+	}
+
+	return State;
+}
+
+void FHLtC_NetCombatState::ToSnapshot(FHLtC_CombatantSnapshot& InOutSnapshot, const FHLtC_MoveTable& MoveTable) const
+{
+	const bool bValidMove = AttackMove != HLtC::InvalidMove && AttackMove < MoveTable.NumMoves();
+	const bool bDodging = Action == EHLtC_PlayerAction::Dodge && InOutSnapshot.Weapon < MoveTable.NumWeapons();
+
+	InOutSnapshot.AttackMove = bValidMove ? AttackMove : HLtC::InvalidMove;
+	InOutSnapshot.AttackIndex = bValidMove ? MoveTable.GetMove(AttackMove).ChainIndex : bDodging ? static_cast<uint8_t>(DodgeDirection) : 0;
+	InOutSnapshot.AdditionalAttackBufferTiming = bValidMove ? MoveTable.GetMove(AttackMove).BufferTime
+		: bDodging ? MoveTable.GetDodge(InOutSnapshot.Weapon, DodgeDirection).BufferTime
+		: 0.0f;
+	InOutSnapshot.Action = Action;
+	InOutSnapshot.ControlState = ControlState;
+	InOutSnapshot.CurrentAttackType = CurrentAttackType;
+	InOutSnapshot.BufferedDodge = BufferedDodge;
+	InOutSnapshot.Flags = static_cast<uint8_t>((InOutSnapshot.Flags & ~(HLtC::NetFlagsMask | HLtC::Flag_AttackStarted)) | Flags);
+	InOutSnapshot.StaticActionRemaining = (Flags & HLtC::Flag_StaticAction) ? static_cast<uint32_t>(StaticActionRemaining * HLtC::NetTimerUnit) : 0;
+}
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// The combat state of a combatant as it goes over the network. Engine independent, like the rest of the core.
+// Only what a client needs to carry on predicting the combatant is sent, quantized and bit-packed: a few bytes per update, and nothing while the state holds.
+
+#include "HLtC_CombatCore.h"
+
+namespace HLtC
+{
+	inline constexpr uint32_t NetFlagBits = 5; // Flag_StaticAction, Flag_AttackBuffered, Flag_Blocking, Flag_Sprinting and Flag_DodgeBuffered. The rest are derived every step
+	inline constexpr uint8_t NetFlagsMask = (1 << NetFlagBits) - 1;
+	inline constexpr uint32_t NetActionBits = 3;
+	inline constexpr uint32_t NetAttackTypeBits = 2;
+	inline constexpr uint32_t NetDodgeDirectionBits = 2;
+	inline constexpr uint32_t NetMoveBits = 12; // Moves past the first 4096 of the move table can't be replicated
+	inline constexpr uint32_t NetTimerBits = 10;
+	inline constexpr int64_t NetTimerUnit = 4000; // Time units per step of a replicated timer, so timers up to about 4 seconds fit
+	inline constexpr uint32_t NetInputAckBits = 8;
+
+	static_assert(NumPlayerActions <= (1 << NetActionBits) && static_cast<int32_t>(EHLtC_AttackType::Count) <= (1 << NetAttackTypeBits), "Widen the replicated state");
+	static_assert(NumDodgeDirections <= (1 << NetDodgeDirectionBits), "Widen the replicated dodge directions");
+	static_assert(NumControlStates <= 2, "The control state is sent as a bit");
+}
+
+/**
+ * A combatants combat state, quantized for replication. The chain index and buffer timing aren't sent, they follow from the move or dodge.
+ * Weapons don't change once a combatant is added, so each end keeps its own. Both ends must build the same move table.
+ * The camera state isn't sent either: it follows the lock-on of whoever controls the combatant, so each end keeps its own.
+ */
+struct FHLtC_NetCombatState
+{
+	uint16_t AttackMove = HLtC::InvalidMove;
+	uint16_t StaticActionRemaining = 0; // In HLtC::NetTimerUnit, only sent during static actions
+	EHLtC_PlayerAction Action = EHLtC_PlayerAction::Idle;
+	EHLtC_ControlState ControlState = EHLtC_ControlState::Slow;
+	EHLtC_AttackType CurrentAttackType = EHLtC_AttackType::None;
+	uint8_t Flags = 0; // HLtC::ECombatantFlags within HLtC::NetFlagsMask
+	EHLtC_DodgeDirection DodgeDirection = EHLtC_DodgeDirection::Forward; // Only sent while dodging
+	EHLtC_DodgeDirection BufferedDodge = EHLtC_DodgeDirection::Forward; // Only sent with HLtC::Flag_DodgeBuffered
+	uint8_t InputAck = 0; // Number of inputs the server had received from the owning client when the state was taken, wrapping
+
+	static FHLtC_NetCombatState FromSnapshot(const FHLtC_CombatantSnapshot& Snapshot, uint8_t InInputAck);
+
+	/** Overwrites the replicated parts of a snapshot. Flags that aren't replicated keep their value, except Flag_AttackStarted, whose hit belongs to the server. The camera state stays as it was */
+	void ToSnapshot(FHLtC_CombatantSnapshot& InOutSnapshot, const FHLtC_MoveTable& MoveTable) const;
+
+	/** Compares everything but the timer and the acknowledgement, which move on without the state changing */
+	bool HasSameStates(const FHLtC_NetCombatState& Other) const
+	{
+		return AttackMove == Other.AttackMove && Action == Other.Action && ControlState == Other.ControlState
+			&& CurrentAttackType == Other.CurrentAttackType && Flags == Other.Flags && DodgeDirection == Other.DodgeDirection && BufferedDodge == Other.BufferedDodge;
+	}
+
+	bool operator==(const FHLtC_NetCombatState& Other) const { return HasSameStates(Other) && StaticActionRemaining == Other.StaticActionRemaining && InputAck == Other.InputAck; }
+	bool operator!=(const FHLtC_NetCombatState& Other) const { return !(*this == Other); }
+
+	/**
+	 * Writes or reads the state through SerializeBits(uint32_t& Value, uint32_t NumBits), which either writes the low NumBits of Value or reads them into it.
+	 * 20 bits outside of a chain, 42 during an attack and 32 during a dodge. Returns false if what was read isn't a valid state
+	 */
+	template <typename TSerializeBits>
+	bool Serialize(TSerializeBits&& SerializeBits);
+};
+
+template <typename TSerializeBits>
+bool FHLtC_NetCombatState::Serialize(TSerializeBits&& SerializeBits)
+{
+	auto Field = [&SerializeBits](auto& Value, uint32_t NumBits) // Every field goes through a uint32_t, so the same code writes and reads
+	{
+		uint32_t Bits = static_cast<uint32_t>(Value);
+		SerializeBits(Bits, NumBits);
+		Value = static_cast<std::remove_reference_t<decltype(Value)>>(Bits);
+	};
+
+	Field(Flags, HLtC::NetFlagBits);
+	Field(Action, HLtC::NetActionBits);
+	Field(ControlState, 1);
+	Field(CurrentAttackType, HLtC::NetAttackTypeBits);
+	Field(InputAck, HLtC::NetInputAckBits);
+
+	uint32_t bInChain = AttackMove != HLtC::InvalidMove;
+	SerializeBits(bInChain, 1);
+	if (bInChain)
+	{
+		Field(AttackMove, HLtC::NetMoveBits);
+	}
+
+	else
+	{
+		AttackMove = HLtC::InvalidMove;
+	}
+
+	if (Flags & HLtC::Flag_StaticAction)
+	{
+		Field(StaticActionRemaining, HLtC::NetTimerBits);
+	}
+
+	else
+	{
+		StaticActionRemaining = 0;
+	}
+
+	if (Action == EHLtC_PlayerAction::Dodge)
+	{
+		Field(DodgeDirection, HLtC::NetDodgeDirectionBits);
+	}
+
+	else
+	{
+		DodgeDirection = EHLtC_DodgeDirection::Forward;
+	}
+
+	if (Flags & HLtC::Flag_DodgeBuffered)
+	{
+		Field(BufferedDodge, HLtC::NetDodgeDirectionBits);
+	}
+
+	else
+	{
+		BufferedDodge = EHLtC_DodgeDirection::Forward;
+	}
+
+	return Action < EHLtC_PlayerAction::Count && CurrentAttackType < EHLtC_AttackType::Count;
+}
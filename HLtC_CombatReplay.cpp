@@ -0,0 +1,413 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatReplay.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Multi-byte values are written in the machine's byte order, which is little-endian on every platform the game ships on
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_ReplayEncoder
+
+void FHLtC_ReplayEncoder::WriteUInt(uint64_t Value)
+{
+	while (Value >= 0x80)
+	{
+		WriteByte(static_cast<uint8_t>(Value) | 0x80);
+		Value >>= 7;
+	}
+	WriteByte(static_cast<uint8_t>(Value));
+}
+
+void FHLtC_ReplayEncoder::WriteInt(int64_t Value)
+{
+	WriteUInt((static_cast<uint64_t>(Value) << 1) ^ static_cast<uint64_t>(Value >> 63));
+}
+
+void FHLtC_ReplayEncoder::WriteFloat(float Value)
+{
+	uint8_t Raw[sizeof(float)];
+	std::memcpy(Raw, &Value, sizeof(float));
+	Bytes.insert(Bytes.end(), Raw, Raw + sizeof(float));
+}
+
+void FHLtC_ReplayEncoder::WriteHeader()
+{
+	const uint32_t Header[2] = { HLtC::ReplayMagic, HLtC::ReplayVersion };
+	const uint8_t* Raw = reinterpret_cast<const uint8_t*>(Header);
+	Bytes.insert(Bytes.end(), Raw, Raw + sizeof(Header));
+}
+
+void FHLtC_ReplayEncoder::WriteFrame(uint32_t Frame, float DeltaTime, int64_t Clock)
+{
+	WriteByte(HLtC::Record_Frame);
+	WriteUInt(Frame - LastFrame);
+	WriteFloat(DeltaTime);
+	WriteInt(Clock - LastClock);
+	LastFrame = Frame;
+	LastClock = Clock;
+}
+
+void FHLtC_ReplayEncoder::WriteActor(uint16_t ActorId, const std::string& Name)
+{
+	WriteByte(HLtC::Record_Actor);
+	WriteUInt(ActorId);
+	WriteUInt(Name.size());
+	Bytes.insert(Bytes.end(), Name.begin(), Name.end());
+}
+
+void FHLtC_ReplayEncoder::WriteInput(const FHLtC_ReplayInput& Input)
+{
+	WriteByte(HLtC::Record_Input);
+	WriteUInt(Input.ActorId);
+	WriteByte(Input.Action);
+	WriteByte(Input.ValueType);
+	for (int32_t Axis = 0; Axis < std::clamp<int32_t>(Input.ValueType, 1, 3); Axis++) // Booleans keep theirs in the first axis
+	{
+		WriteFloat(Input.Axes[Axis]);
+	}
+	WriteInt(Input.Time - LastClock); // Usually a few microseconds either side of the frames clock
+}
+
+void FHLtC_ReplayEncoder::WriteCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint)
+{
+	const size_t NumBytes = Checkpoint.Combatants.size() * sizeof(FHLtC_ReplayCombatant);
+	const uint8_t* Current = reinterpret_cast<const uint8_t*>(Checkpoint.Combatants.data());
+
+	const bool bKeyframe = NumCheckpoints % std::max(KeyframeInterval, 1) == 0 || LastCheckpoint.size() != NumBytes;
+	if (bKeyframe) // Diffed against zeros, so it decodes on its own
+	{
+		LastCheckpoint.assign(NumBytes, 0);
+	}
+	NumCheckpoints++;
+
+	WriteByte(HLtC::Record_Checkpoint);
+	WriteByte(bKeyframe ? 1 : 0);
+	WriteUInt(Checkpoint.Frame);
+	WriteInt(Checkpoint.Clock);
+	WriteUInt(Checkpoint.SimulationFrame);
+	WriteFloat(Checkpoint.StepAccumulator);
+	WriteUInt(Checkpoint.Combatants.size());
+
+	// Alternating runs of unchanged bytes and changed bytes, the changed ones XORed with what they were. The runs are prefixed with their total length so readers can skip them
+	std::vector<uint8_t> Runs;
+	std::swap(Runs, Bytes);
+	size_t Byte = 0;
+	while (Byte < NumBytes)
+	{
+		const size_t UnchangedStart = Byte;
+		while (Byte < NumBytes && Current[Byte] == LastCheckpoint[Byte])
+		{
+			Byte++;
+		}
+
+		const size_t ChangedStart = Byte;
+		while (Byte < NumBytes && Current[Byte] != LastCheckpoint[Byte])
+		{
+			Byte++;
+		}
+
+		WriteUInt(ChangedStart - UnchangedStart);
+		WriteUInt(Byte - ChangedStart);
+		for (size_t Changed = ChangedStart; Changed < Byte; Changed++)
+		{
+			WriteByte(Current[Changed] ^ LastCheckpoint[Changed]);
+		}
+	}
+	std::swap(Runs, Bytes);
+
+	WriteUInt(Runs.size());
+	Bytes.insert(Bytes.end(), Runs.begin(), Runs.end());
+
+	std::memcpy(LastCheckpoint.data(), Current, NumBytes);
+
+	if (bKeyframe) // Times after a keyframe are relative to 0, so reading can start there
+	{
+		LastFrame = 0;
+		LastClock = 0;
+	}
+}
+
+void FHLtC_ReplayEncoder::WriteEnd()
+{
+	WriteByte(HLtC::Record_End);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_ReplayDecoder
+
+bool FHLtC_ReplayDecoder::ReadByte(uint8_t& Out)
+{
+	if (Position >= Size)
+	{
+		bCorrupt = true;
+		return false;
+	}
+
+	Out = Data[Position++];
+	return true;
+}
+
+bool FHLtC_ReplayDecoder::ReadUInt(uint64_t& Out)
+{
+	Out = 0;
+	for (int32_t Shift = 0; Shift < 64; Shift += 7)
+	{
+		uint8_t Byte;
+		if (!ReadByte(Byte))
+		{
+			return false;
+		}
+
+		Out |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+		if ((Byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	bCorrupt = true; // Longer than any 64 bit value
+	return false;
+}
+
+bool FHLtC_ReplayDecoder::ReadInt(int64_t& Out)
+{
+	uint64_t Value;
+	if (!ReadUInt(Value))
+	{
+		return false;
+	}
+
+	Out = static_cast<int64_t>(Value >> 1) ^ -static_cast<int64_t>(Value & 1);
+	return true;
+}
+
+bool FHLtC_ReplayDecoder::ReadFloat(float& Out)
+{
+	if (Size - Position < sizeof(float))
+	{
+		bCorrupt = true;
+		return false;
+	}
+
+	std::memcpy(&Out, Data + Position, sizeof(float));
+	Position += sizeof(float);
+	return true;
+}
+
+bool FHLtC_ReplayDecoder::Open(const uint8_t* InData, size_t InSize)
+{
+	uint32_t Header[2];
+	if (InData == nullptr || InSize < sizeof(Header))
+	{
+		return false;
+	}
+
+	std::memcpy(Header, InData, sizeof(Header));
+	if (Header[0] != HLtC::ReplayMagic || Header[1] != HLtC::ReplayVersion)
+	{
+		return false;
+	}
+
+	Data = InData;
+	Size = InSize;
+	FirstRecord = sizeof(Header);
+	Position = FirstRecord;
+	bCorrupt = false;
+	LastFrame = 0;
+	LastClock = 0;
+	NumFrames = 0;
+	Keyframes.clear();
+	ActorNames.clear();
+
+	// Index the keyframes and actors. A recording cut short by a crash stops at its last whole record, which is still worth playing
+	FHLtC_ReplayRecord Record;
+	size_t RecordStart = Position;
+	while (ReadRecord(Record) && Record.Type != HLtC::Record_End)
+	{
+		if (Record.Type == HLtC::Record_Frame)
+		{
+			NumFrames = std::max(NumFrames, Record.Frame + 1);
+		}
+
+		else if (Record.Type == HLtC::Record_Actor)
+		{
+			if (ActorNames.size() <= Record.ActorId)
+			{
+				ActorNames.resize(Record.ActorId + 1);
+			}
+			ActorNames[Record.ActorId] = Record.ActorName;
+		}
+
+		else if (Record.Type == HLtC::Record_Checkpoint && Record.bKeyframe)
+		{
+			Keyframes.push_back({ Record.Checkpoint->Frame, RecordStart });
+		}
+
+		RecordStart = Position;
+	}
+
+	Position = FirstRecord;
+	bCorrupt = false;
+	LastFrame = 0;
+	LastClock = 0;
+	LastCheckpoint.clear();
+	return true;
+}
+
+bool FHLtC_ReplayDecoder::Next(FHLtC_ReplayRecord& Out)
+{
+	return ReadRecord(Out) && Out.Type != HLtC::Record_End;
+}
+
+int64_t FHLtC_ReplayDecoder::Seek(uint32_t Frame)
+{
+	const auto After = std::upper_bound(Keyframes.begin(), Keyframes.end(), Frame, [](uint32_t InFrame, const FKeyframe& Keyframe) { return InFrame < Keyframe.Frame; });
+	if (After == Keyframes.begin())
+	{
+		return -1;
+	}
+
+	Position = std::prev(After)->Offset;
+	bCorrupt = false;
+	return std::prev(After)->Frame;
+}
+
+bool FHLtC_ReplayDecoder::ReadRecord(FHLtC_ReplayRecord& Out)
+{
+	uint8_t Type;
+	if (Position >= Size || !ReadByte(Type))
+	{
+		return false;
+	}
+
+	Out.Type = static_cast<HLtC::EReplayRecord>(Type);
+	uint64_t Value;
+	int64_t SignedValue;
+	switch (Out.Type)
+	{
+	case HLtC::Record_Frame:
+		if (!ReadUInt(Value) || !ReadFloat(Out.DeltaTime) || !ReadInt(SignedValue))
+		{
+			return false;
+		}
+		LastFrame += static_cast<uint32_t>(Value);
+		LastClock += SignedValue;
+		Out.Frame = LastFrame;
+		Out.Clock = LastClock;
+		return true;
+
+	case HLtC::Record_Actor:
+		if (!ReadUInt(Value) || Value > UINT16_MAX)
+		{
+			return false;
+		}
+		Out.ActorId = static_cast<uint16_t>(Value);
+
+		if (!ReadUInt(Value) || Value > Size - Position)
+		{
+			bCorrupt = true;
+			return false;
+		}
+		Out.ActorName.assign(reinterpret_cast<const char*>(Data + Position), static_cast<size_t>(Value));
+		Position += static_cast<size_t>(Value);
+		return true;
+
+	case HLtC::Record_Input:
+	{
+		FHLtC_ReplayInput& Input = Out.Input;
+		if (!ReadUInt(Value) || Value > UINT16_MAX || !ReadByte(Input.Action) || !ReadByte(Input.ValueType))
+		{
+			return false;
+		}
+		Input.ActorId = static_cast<uint16_t>(Value);
+
+		const int32_t NumAxes = std::clamp<int32_t>(Input.ValueType, 1, 3);
+		for (int32_t Axis = 0; Axis < 3; Axis++)
+		{
+			Input.Axes[Axis] = 0.0f;
+			if (Axis < NumAxes && !ReadFloat(Input.Axes[Axis]))
+			{
+				return false;
+			}
+		}
+
+		if (!ReadInt(SignedValue))
+		{
+			return false;
+		}
+		Input.Time = LastClock + SignedValue;
+		return true;
+	}
+
+	case HLtC::Record_Checkpoint:
+	{
+		uint8_t bKeyframe;
+		uint64_t SimulationFrame;
+		uint64_t NumCombatants;
+		uint64_t RunsSize;
+		if (!ReadByte(bKeyframe) || !ReadUInt(Value) || !ReadInt(Checkpoint.Clock) || !ReadUInt(SimulationFrame) || !ReadFloat(Checkpoint.StepAccumulator)
+			|| !ReadUInt(NumCombatants) || NumCombatants > UINT16_MAX + 1ull || !ReadUInt(RunsSize) || RunsSize > Size - Position)
+		{
+			bCorrupt = true;
+			return false;
+		}
+		Checkpoint.Frame = static_cast<uint32_t>(Value);
+		Out.bKeyframe = bKeyframe != 0;
+		Checkpoint.SimulationFrame = static_cast<uint32_t>(SimulationFrame);
+
+		const size_t NumBytes = static_cast<size_t>(NumCombatants) * sizeof(FHLtC_ReplayCombatant);
+		if (bKeyframe != 0)
+		{
+			LastCheckpoint.assign(NumBytes, 0);
+		}
+
+		else if (LastCheckpoint.size() != NumBytes) // A delta without the checkpoint it's relative to, e.g. when read without a seek
+		{
+			bCorrupt = true;
+			return false;
+		}
+
+		const size_t RunsEnd = Position + static_cast<size_t>(RunsSize);
+		size_t Byte = 0;
+		while (Position < RunsEnd)
+		{
+			uint64_t Unchanged;
+			uint64_t Changed;
+			if (!ReadUInt(Unchanged) || !ReadUInt(Changed) || Unchanged + Changed > NumBytes - Byte || Changed > RunsEnd - Position)
+			{
+				bCorrupt = true;
+				return false;
+			}
+
+			Byte += static_cast<size_t>(Unchanged);
+			for (uint64_t Index = 0; Index < Changed; Index++)
+			{
+				LastCheckpoint[Byte++] ^= Data[Position++];
+			}
+		}
+
+		Checkpoint.Combatants.resize(static_cast<size_t>(NumCombatants));
+		if (NumBytes > 0)
+		{
+			std::memcpy(Checkpoint.Combatants.data(), LastCheckpoint.data(), NumBytes);
+		}
+		Out.Checkpoint = &Checkpoint;
+
+		if (bKeyframe != 0)
+		{
+			LastFrame = 0;
+			LastClock = 0;
+		}
+		return true;
+	}
+
+	case HLtC::Record_End:
+		return true;
+
+	default:
+		bCorrupt = true;
+		return false;
+	}
+}
@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Binary replay stream of combat input and state. Engine independent, like the rest of the core.
+// A replay is a sequence of records: a frame record, the input that arrived during that frame, and every so often a checkpoint of the combat state at the end of a frame.
+// Integers are variable length and times are stored relative to the previous one, checkpoints only store the bytes that changed since the last one.
+
+#include "HLtC_CombatCore.h"
+
+#include <string>
+
+namespace HLtC
+{
+	constexpr uint32_t ReplayMagic = 0x50524C48; // "HLRP"
+	constexpr uint32_t ReplayVersion = 2; // 2: dodges, which moved the combatant flags
+
+	enum EReplayRecord : uint8_t
+	{
+		Record_Frame = 1, // Start of a frame, with its delta time and the clock the simulation ticked at
+		Record_Actor, // Name of an actor id, written before the id is first used
+		Record_Input, // An input action as a handler received it
+		Record_Checkpoint, // Combat state and bodies of every combatant at the end of a frame
+		Record_End,
+	};
+}
+
+/** Where a combatants body was, saved next to its combat state */
+struct FHLtC_ReplayBody
+{
+	float X, Y, Z;
+	float Yaw;
+	float VelocityX, VelocityY, VelocityZ;
+};
+
+/** One combatant of a checkpoint, packed without padding so checkpoints can be diffed as raw bytes */
+struct FHLtC_ReplayCombatant
+{
+	uint16_t ActorId;
+	uint8_t Held; // HLtC::EInputHeld the simulation was sampling, which isn't part of the combat state
+	uint8_t Reserved; // Always 0
+	FHLtC_CombatantSnapshot State; // Padding must be zeroed before saving into it
+	FHLtC_ReplayBody Body;
+};
+static_assert(std::is_trivially_copyable<FHLtC_ReplayCombatant>::value, "Checkpoints are diffed as raw memory");
+static_assert(sizeof(FHLtC_ReplayCombatant) == 52, "Keep replay combatants packed");
+
+struct FHLtC_ReplayCheckpoint
+{
+	uint32_t Frame = 0; // Frames completed when the checkpoint was taken
+	int64_t Clock = 0; // Clock of the combat world
+	uint32_t SimulationFrame = 0; // Next fixed step of the simulation
+	float StepAccumulator = 0.0f; // Frame time the simulation hadn't stepped yet
+	std::vector<FHLtC_ReplayCombatant> Combatants;
+};
+
+/** An input action with its value, stored as the handler got it */
+struct FHLtC_ReplayInput
+{
+	uint16_t ActorId = 0;
+	uint8_t Action = 0; // EHLtC_InputAction of the engine side
+	uint8_t ValueType = 0; // EInputActionValueType of the engine side, which also gives how many axes are used
+	float Axes[3] = {};
+	int64_t Time = 0; // Microseconds, on the simulations input clock
+};
+
+/** Everything a record can carry. Only the fields of its Type are set */
+struct FHLtC_ReplayRecord
+{
+	HLtC::EReplayRecord Type = HLtC::Record_End;
+	uint32_t Frame = 0; // Record_Frame
+	float DeltaTime = 0.0f; // Record_Frame
+	int64_t Clock = 0; // Record_Frame, microseconds on the simulations input clock
+	uint16_t ActorId = 0; // Record_Actor
+	std::string ActorName; // Record_Actor
+	FHLtC_ReplayInput Input; // Record_Input
+	const FHLtC_ReplayCheckpoint* Checkpoint = nullptr; // Record_Checkpoint, owned by the decoder and valid till its next call
+	bool bKeyframe = false; // Record_Checkpoint
+};
+
+/**
+ * Builds a replay stream in memory. Bytes are taken off as they're written, so a recording only holds what hasn't been flushed yet.
+ * Every KeyframeInterval-th checkpoint is stored whole, so a reader can start from it without decoding the checkpoints before it.
+ */
+class FHLtC_ReplayEncoder
+{
+public:
+	int32_t KeyframeInterval = 16;
+
+	void WriteHeader();
+	void WriteFrame(uint32_t Frame, float DeltaTime, int64_t Clock);
+	void WriteActor(uint16_t ActorId, const std::string& Name);
+	void WriteInput(const FHLtC_ReplayInput& Input); // Belongs to the last frame written
+	void WriteCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint);
+	void WriteEnd();
+
+	/** Swaps the bytes written since the last call into Out, which should be empty */
+	void TakeBytes(std::vector<uint8_t>& Out) { Out.clear(); Out.swap(Bytes); }
+	size_t NumBytes() const { return Bytes.size(); }
+
+private:
+	void WriteByte(uint8_t Value) { Bytes.push_back(Value); }
+	void WriteUInt(uint64_t Value);
+	void WriteInt(int64_t Value); // Zigzag, so small negative values stay short
+	void WriteFloat(float Value);
+
+	std::vector<uint8_t> Bytes;
+	uint32_t LastFrame = 0;
+	int64_t LastClock = 0;
+	int32_t NumCheckpoints = 0;
+	std::vector<uint8_t> LastCheckpoint; // Combatant bytes of the previous checkpoint, what the next one is diffed against
+};
+
+/**
+ * Reads a replay stream from memory, e.g. a mapped file. Nothing is copied out of it but the current checkpoint.
+ * Opening scans the stream once to index its keyframes and actors, so Seek can jump straight to the keyframe before any frame.
+ */
+class FHLtC_ReplayDecoder
+{
+public:
+	/** Returns false if Data isn't a replay of this version. Data must outlive the decoder */
+	bool Open(const uint8_t* Data, size_t Size);
+
+	/** Reads the record at the current position. Returns false at the end of the stream, or at the first byte that doesn't parse */
+	bool Next(FHLtC_ReplayRecord& Out);
+
+	/** Moves to the newest keyframe at or before Frame, so the next record is that keyframe. Returns its frame, or -1 if there's none */
+	int64_t Seek(uint32_t Frame);
+
+	uint32_t GetNumFrames() const { return NumFrames; }
+	bool IsCorrupt() const { return bCorrupt; }
+
+	/** Name of every actor id in the stream, indexed by id. Known as soon as the stream is open, so a seek can map ids to actors straight away */
+	const std::vector<std::string>& GetActorNames() const { return ActorNames; }
+
+private:
+	bool ReadByte(uint8_t& Out);
+	bool ReadUInt(uint64_t& Out);
+	bool ReadInt(int64_t& Out);
+	bool ReadFloat(float& Out);
+	bool ReadRecord(FHLtC_ReplayRecord& Out);
+
+	struct FKeyframe
+	{
+		uint32_t Frame;
+		size_t Offset;
+	};
+
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	size_t Position = 0;
+	size_t FirstRecord = 0;
+	bool bCorrupt = false;
+
+	uint32_t LastFrame = 0;
+	int64_t LastClock = 0;
+	uint32_t NumFrames = 0;
+	std::vector<FKeyframe> Keyframes;
+	std::vector<std::string> ActorNames;
+
+	FHLtC_ReplayCheckpoint Checkpoint;
+	std::vector<uint8_t> LastCheckpoint;
+};
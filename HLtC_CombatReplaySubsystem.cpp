@@ -0,0 +1,696 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatReplaySubsystem.h"
+#include "HLtC_CombatSimulationSubsystem.h"
+#include "HLtC_CombatSystemCharacter.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "InputActionValue.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+static int32 GHLtCReplayCheckpointInterval = 60;
+static FAutoConsoleVariableRef CVarHLtCReplayCheckpointInterval(
+	TEXT("hltc.Replay.CheckpointInterval"),
+	GHLtCReplayCheckpointInterval,
+	TEXT("Frames between the combat state checkpoints of a replay recording. Playback verifies itself against them, and seeks start from them."));
+
+static float GHLtCReplayVerifyTolerance = 1.0f;
+static FAutoConsoleVariableRef CVarHLtCReplayVerifyTolerance(
+	TEXT("hltc.Replay.VerifyTolerance"),
+	GHLtCReplayVerifyTolerance,
+	TEXT("Distance in cm a body may be off its recorded position before replay playback reports a divergence. Combat state has to match exactly."));
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_ReplayWriter
+
+/** Appends blocks of bytes to a file on a thread of its own, so recording never waits on the disk */
+class FHLtC_ReplayWriter : public FRunnable
+{
+public:
+	static TUniquePtr<FHLtC_ReplayWriter> Create(const FString& Path)
+	{
+		FArchive* File = IFileManager::Get().CreateFileWriter(*Path);
+		return File ? TUniquePtr<FHLtC_ReplayWriter>(new FHLtC_ReplayWriter(File)) : nullptr;
+	}
+
+	virtual ~FHLtC_ReplayWriter() override
+	{
+		bStopping = true;
+		WorkEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+
+		File->Close();
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	}
+
+	void Write(std::vector<uint8_t>&& Bytes) // Game thread only
+	{
+		if (!Bytes.empty())
+		{
+			Pending.Enqueue(MoveTemp(Bytes));
+			WorkEvent->Trigger();
+		}
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping)
+		{
+			WorkEvent->Wait();
+			Drain();
+		}
+
+		Drain(); // Whatever was queued before the stop
+		return 0;
+	}
+
+private:
+	explicit FHLtC_ReplayWriter(FArchive* InFile)
+		: File(InFile)
+		, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+	{
+		Thread = FRunnableThread::Create(this, TEXT("HLtCReplayWriter"), 0, TPri_BelowNormal); // Last, everything Run touches exists by now
+	}
+
+	void Drain()
+	{
+		std::vector<uint8_t> Bytes;
+		while (Pending.Dequeue(Bytes))
+		{
+			File->Serialize(Bytes.data(), Bytes.size());
+		}
+	}
+
+	TUniquePtr<FArchive> File;
+	FEvent* WorkEvent;
+	FRunnableThread* Thread = nullptr;
+	TQueue<std::vector<uint8_t>, EQueueMode::Spsc> Pending;
+	std::atomic<bool> bStopping{ false };
+};
+
+//////////////////////////////////////////////////////////////////////////
+// UHLtC_CombatReplaySubsystem
+
+void UHLtC_CombatReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UHLtC_CombatSimulationSubsystem>();
+}
+
+void UHLtC_CombatReplaySubsystem::Deinitialize()
+{
+	Stop();
+
+	Super::Deinitialize();
+}
+
+bool UHLtC_CombatReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UHLtC_CombatSimulationSubsystem* UHLtC_CombatReplaySubsystem::GetSimulation() const
+{
+	return GetWorld()->GetSubsystem<UHLtC_CombatSimulationSubsystem>();
+}
+
+bool UHLtC_CombatReplaySubsystem::StartRecording(const FString& Path)
+{
+	if (Mode != EMode::None)
+	{
+		return false;
+	}
+
+	Writer = FHLtC_ReplayWriter::Create(Path);
+	if (!Writer)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("Couldn't open '%s' to record a combat replay."), *Path);
+		return false;
+	}
+
+	Mode = EMode::Recording;
+	bStarted = false;
+	ReplayPath = Path;
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UHLtC_CombatReplaySubsystem::OnPreActorTick);
+	return true;
+}
+
+bool UHLtC_CombatReplaySubsystem::StartPlayback(const FString& Path, bool bInFastForward)
+{
+	if (Mode != EMode::None || !GetSimulation())
+	{
+		return false;
+	}
+
+	// Replays can be long, so they're mapped rather than read whenever the platform allows
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	MappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path);
+	MappedRegion = MappedFile ? MappedFile->MapRegion() : nullptr;
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Path))
+	{
+		Data = LoadedFile.GetData();
+		Size = LoadedFile.Num();
+	}
+
+	bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	Mode = EMode::Playing;
+	ReplayPath = Path;
+	if (!Data || !Decoder.Open(Data, Size) || !ReadToNextFrame() || !bHasPendingCheckpoint)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("'%s' isn't a combat replay this build can play."), *Path);
+		Stop();
+		return false;
+	}
+
+	MapCharacters();
+
+	FApp::SetUseFixedTimeStep(true); // The next frame runs with the delta time of the replays first frame, set by ReadToNextFrame
+
+	bRestorePending = true;
+	bFastForwardWhole = bInFastForward;
+	SetFastForward(bInFastForward);
+	BaseClock = FPlatformTime::Seconds();
+	NumCheckpointsVerified = 0;
+	NumDivergences = 0;
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UHLtC_CombatReplaySubsystem::OnPreActorTick);
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("Playing combat replay '%s', %u frames."), *Path, Decoder.GetNumFrames());
+	return true;
+}
+
+bool UHLtC_CombatReplaySubsystem::SeekPlayback(uint32 InFrame)
+{
+	if (Mode != EMode::Playing)
+	{
+		return false;
+	}
+
+	const int64 KeyframeFrame = Decoder.Seek(InFrame);
+	if (KeyframeFrame < 0)
+	{
+		return false;
+	}
+
+	bHasPendingCheckpoint = false;
+	bEndOfReplay = false;
+	if (!ReadToNextFrame() || !bHasPendingCheckpoint) // Reads the keyframe, and sets the delta time of the frame after it
+	{
+		return false;
+	}
+
+	bRestorePending = true;
+	SeekTarget = InFrame;
+	SetFastForward(bFastForwardWhole || InFrame > uint32(KeyframeFrame));
+	return true;
+}
+
+void UHLtC_CombatReplaySubsystem::Stop()
+{
+	if (Mode == EMode::Recording)
+	{
+		if (bStarted)
+		{
+			Encoder.WriteEnd();
+
+			std::vector<uint8_t> Bytes;
+			Encoder.TakeBytes(Bytes);
+			Writer->Write(MoveTemp(Bytes));
+		}
+
+		Writer.Reset(); // Waits for the writer to finish the file
+		UE_LOG(LogTemplateCharacter, Display, TEXT("Recorded %u frames of combat to '%s'."), Frame, *ReplayPath);
+	}
+
+	else if (Mode == EMode::Playing)
+	{
+		SetFastForward(false);
+		FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+
+		if (UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation())
+		{
+			Simulation->SetInputClockOverride(-1.0);
+		}
+
+		UE_LOG(LogTemplateCharacter, Display, TEXT("Combat replay stopped at frame %u, %d checkpoints verified, %d divergences."), Frame, NumCheckpointsVerified, NumDivergences);
+	}
+
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	PreActorTickHandle.Reset();
+
+	Decoder = FHLtC_ReplayDecoder(); // Before the memory it reads goes away
+	delete MappedRegion;
+	delete MappedFile;
+	MappedRegion = nullptr;
+	MappedFile = nullptr;
+	LoadedFile.Empty();
+
+	Encoder = FHLtC_ReplayEncoder();
+	ActorIds.Empty();
+	BufferedInputs.Empty();
+	ActorCharacters.Empty();
+	bHasPendingCheckpoint = false;
+	bRestorePending = false;
+	bEndOfReplay = false;
+	bStarted = false;
+	Frame = 0;
+	SeekTarget = 0;
+	Mode = EMode::None;
+}
+
+bool UHLtC_CombatReplaySubsystem::FilterInput(AHLtC_CombatSystemCharacter* Character, EHLtC_InputAction Action, const FInputActionValue& Value)
+{
+	if (Mode == EMode::Playing)
+	{
+		return bInjecting; // The replay is the only input while it plays
+	}
+
+	if (Mode == EMode::Recording && bStarted)
+	{
+		const FVector Axes = Value.Get<FVector>();
+
+		FBufferedInput& Buffered = BufferedInputs.AddDefaulted_GetRef();
+		Buffered.Character = Character;
+		Buffered.Input.Action = uint8(Action);
+		Buffered.Input.ValueType = uint8(Value.GetValueType());
+		Buffered.Input.Axes[0] = Axes.X;
+		Buffered.Input.Axes[1] = Axes.Y;
+		Buffered.Input.Axes[2] = Axes.Z;
+		Buffered.Input.Time = ToReplayTime(GetSimulation()->GetInputClock()); // The clock the characters input event gets stamped with
+	}
+
+	return true;
+}
+
+void UHLtC_CombatReplaySubsystem::OnPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+
+	if (Mode == EMode::Recording)
+	{
+		RecordFrame(DeltaSeconds);
+	}
+
+	else if (Mode == EMode::Playing)
+	{
+		PlayFrame();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Recording
+
+void UHLtC_CombatReplaySubsystem::RecordFrame(float DeltaSeconds)
+{
+	UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation();
+	if (!bStarted) // The replay starts from the state the world is in before its first frame
+	{
+		BaseClock = Simulation->GetInputClock();
+		Encoder.WriteHeader();
+		WriteCheckpoint(0);
+		bStarted = true;
+	}
+
+	else // The frame before this one has ended, the simulation has ticked and its input is all in
+	{
+		Encoder.WriteFrame(Frame, FrameDeltaTime, ToReplayTime(Simulation->GetLastTickClock()));
+		for (FBufferedInput& Buffered : BufferedInputs)
+		{
+			if (AHLtC_CombatSystemCharacter* Character = Buffered.Character.Get())
+			{
+				Buffered.Input.ActorId = GetActorId(Character);
+				Encoder.WriteInput(Buffered.Input);
+			}
+		}
+		BufferedInputs.Reset();
+
+		Frame++;
+		if (Frame % FMath::Max(GHLtCReplayCheckpointInterval, 1) == 0)
+		{
+			WriteCheckpoint(Frame);
+		}
+	}
+
+	FrameDeltaTime = DeltaSeconds;
+
+	std::vector<uint8_t> Bytes;
+	Encoder.TakeBytes(Bytes);
+	Writer->Write(MoveTemp(Bytes));
+}
+
+void UHLtC_CombatReplaySubsystem::WriteCheckpoint(uint32 InFrame)
+{
+	UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation();
+
+	FHLtC_ReplayCheckpoint Checkpoint;
+	CaptureCheckpoint(Checkpoint);
+	Checkpoint.Frame = InFrame;
+	for (int32 Index = 0; Index < Simulation->Num(); Index++)
+	{
+		Checkpoint.Combatants[Index].ActorId = GetActorId(Simulation->GetCharacter(Index));
+	}
+
+	Encoder.WriteCheckpoint(Checkpoint);
+}
+
+void UHLtC_CombatReplaySubsystem::CaptureCheckpoint(FHLtC_ReplayCheckpoint& Out)
+{
+	UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation();
+	const FHLtC_CombatWorld& CombatWorld = Simulation->GetCombatWorld();
+	const int32 NumCombatants = Simulation->Num();
+
+	Snapshots.SetNumUninitialized(NumCombatants);
+	FMemory::Memzero(Snapshots.GetData(), NumCombatants * sizeof(FHLtC_CombatantSnapshot)); // Padding is compared too
+	CombatWorld.SaveSnapshot(Snapshots.GetData());
+
+	Out.Clock = CombatWorld.Clock;
+	Out.SimulationFrame = Simulation->GetCurrentFrame();
+	Out.StepAccumulator = Simulation->GetStepAccumulator();
+	Out.Combatants.resize(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		const AHLtC_CombatSystemCharacter* Character = Simulation->GetCharacter(Index);
+		const FVector Location = Character->GetActorLocation();
+		const FVector Velocity = Character->GetCharacterMovement()->Velocity;
+
+		FHLtC_ReplayCombatant& Combatant = Out.Combatants[Index];
+		FMemory::Memzero(Combatant);
+		FMemory::Memcpy(&Combatant.State, &Snapshots[Index], sizeof(FHLtC_CombatantSnapshot));
+		Combatant.Held = Simulation->GetHeldInput(Index);
+		Combatant.Body = { float(Location.X), float(Location.Y), float(Location.Z), float(Character->GetActorRotation().Yaw), float(Velocity.X), float(Velocity.Y), float(Velocity.Z) };
+	}
+}
+
+uint16 UHLtC_CombatReplaySubsystem::GetActorId(AHLtC_CombatSystemCharacter* Character)
+{
+	if (const uint16* ActorId = ActorIds.Find(Character))
+	{
+		return *ActorId;
+	}
+
+	const uint16 ActorId = uint16(ActorIds.Num());
+	ActorIds.Add(Character, ActorId);
+	Encoder.WriteActor(ActorId, TCHAR_TO_UTF8(*Character->GetName()));
+	return ActorId;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Playback
+
+void UHLtC_CombatReplaySubsystem::PlayFrame()
+{
+	if (bHasPendingCheckpoint) // The state the frame before this one ended with
+	{
+		bHasPendingCheckpoint = false;
+		if (bRestorePending)
+		{
+			bRestorePending = false;
+			if (!RestoreCheckpoint(PendingCheckpoint))
+			{
+				Stop();
+				return;
+			}
+		}
+
+		else
+		{
+			VerifyCheckpoint(PendingCheckpoint);
+		}
+	}
+
+	if (bEndOfReplay)
+	{
+		UE_LOG(LogTemplateCharacter, Display, TEXT("Combat replay '%s' finished."), *ReplayPath);
+		Stop();
+		return;
+	}
+
+	Frame = PendingFrame.Frame;
+	const int64 FrameClock = PendingFrame.Clock;
+	if (bFastForward && !bFastForwardWhole && Frame >= SeekTarget)
+	{
+		SetFastForward(false);
+	}
+
+	if (!ReadToNextFrame())
+	{
+		bEndOfReplay = true; // This frame still plays, and a checkpoint after it is still verified
+	}
+
+	GetSimulation()->SetInputClockOverride(FromReplayTime(FrameClock)); // Steps are placed on the clock the recording ticked at
+}
+
+bool UHLtC_CombatReplaySubsystem::ReadToNextFrame()
+{
+	UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation();
+
+	FHLtC_ReplayRecord Record;
+	while (Decoder.Next(Record))
+	{
+		switch (Record.Type)
+		{
+		case HLtC::Record_Frame:
+			PendingFrame = Record;
+			FApp::SetFixedDeltaTime(Record.DeltaTime); // Takes effect with the next engine frame, the one this record belongs to
+			return true;
+
+		case HLtC::Record_Input:
+			if (ActorCharacters.IsValidIndex(Record.Input.ActorId))
+			{
+				if (AHLtC_CombatSystemCharacter* Character = ActorCharacters[Record.Input.ActorId].Get())
+				{
+					const FHLtC_ReplayInput& Input = Record.Input;
+					Simulation->SetInputClockOverride(FromReplayTime(Input.Time)); // Stamps the characters input event with the recorded time
+
+					TGuardValue<bool> Injecting(bInjecting, true);
+					Character->SimulateInput(EHLtC_InputAction(Input.Action), FInputActionValue(EInputActionValueType(Input.ValueType), FVector(Input.Axes[0], Input.Axes[1], Input.Axes[2])));
+				}
+			}
+			break;
+
+		case HLtC::Record_Checkpoint:
+			PendingCheckpoint = *Record.Checkpoint;
+			bHasPendingCheckpoint = true;
+			break;
+
+		default: // Actor names are indexed when the replay is opened
+			break;
+		}
+	}
+
+	if (Decoder.IsCorrupt())
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("Combat replay '%s' is corrupt after frame %u."), *ReplayPath, Frame);
+	}
+
+	return false;
+}
+
+bool UHLtC_CombatReplaySubsystem::MapCharacters()
+{
+	TMap<FString, AHLtC_CombatSystemCharacter*> CharactersByName;
+	for (TActorIterator<AHLtC_CombatSystemCharacter> It(GetWorld()); It; ++It)
+	{
+		CharactersByName.Add(It->GetName(), *It);
+	}
+
+	bool bAllFound = true;
+	const std::vector<std::string>& ActorNames = Decoder.GetActorNames();
+	ActorCharacters.SetNum(int32(ActorNames.size()));
+	for (int32 ActorId = 0; ActorId < ActorCharacters.Num(); ActorId++)
+	{
+		const FString Name = UTF8_TO_TCHAR(ActorNames[ActorId].c_str());
+		AHLtC_CombatSystemCharacter** Character = CharactersByName.Find(Name);
+		ActorCharacters[ActorId] = Character ? *Character : nullptr;
+		if (!Character)
+		{
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("Combat replay actor '%s' isn't in this world, its input is skipped."), *Name);
+			bAllFound = false;
+		}
+	}
+
+	return bAllFound;
+}
+
+bool UHLtC_CombatReplaySubsystem::RestoreCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint)
+{
+	UHLtC_CombatSimulationSubsystem* Simulation = GetSimulation();
+	const int32 NumCombatants = Simulation->Num();
+	if (int32(Checkpoint.Combatants.size()) != NumCombatants)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("Combat replay checkpoint has %d combatants, the world has %d."), int32(Checkpoint.Combatants.size()), NumCombatants);
+		return false;
+	}
+
+	Snapshots.SetNumUninitialized(NumCombatants);
+	HeldInputs.SetNumUninitialized(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		const FHLtC_ReplayCombatant& Combatant = Checkpoint.Combatants[Index];
+		AHLtC_CombatSystemCharacter* Character = Simulation->GetCharacter(Index);
+		if (!ActorCharacters.IsValidIndex(Combatant.ActorId) || ActorCharacters[Combatant.ActorId].Get() != Character) // Snapshots are restored by index
+		{
+			UE_LOG(LogTemplateCharacter, Error, TEXT("Combat replay was recorded with different combatants, or registered in a different order. Combatant %d is %s."), Index, *Character->GetName());
+			return false;
+		}
+
+		FMemory::Memcpy(&Snapshots[Index], &Combatant.State, sizeof(FHLtC_CombatantSnapshot));
+		HeldInputs[Index] = Combatant.Held;
+
+		const FHLtC_ReplayBody& Body = Combatant.Body;
+		Character->SetActorLocationAndRotation(FVector(Body.X, Body.Y, Body.Z), FRotator(0.0f, Body.Yaw, 0.0f), false, nullptr, ETeleportType::TeleportPhysics);
+		Character->GetCharacterMovement()->Velocity = FVector(Body.VelocityX, Body.VelocityY, Body.VelocityZ);
+		Character->Hot.bSprinting = (Combatant.Held & HLtC::Input_Sprinting) != 0;
+	}
+
+	Simulation->RestoreState(Snapshots.GetData(), HeldInputs.GetData(), Checkpoint.Clock, Checkpoint.SimulationFrame, Checkpoint.StepAccumulator);
+	Frame = Checkpoint.Frame;
+	return true;
+}
+
+void UHLtC_CombatReplaySubsystem::VerifyCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint)
+{
+	NumCheckpointsVerified++;
+
+	CaptureCheckpoint(CapturedCheckpoint);
+	if (CapturedCheckpoint.Combatants.size() != Checkpoint.Combatants.size() || CapturedCheckpoint.Clock != Checkpoint.Clock || CapturedCheckpoint.SimulationFrame != Checkpoint.SimulationFrame)
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("Combat replay diverged before frame %u: the simulation is at step %u, recorded %u."), Checkpoint.Frame, CapturedCheckpoint.SimulationFrame, Checkpoint.SimulationFrame);
+		NumDivergences++;
+		return;
+	}
+
+	const float ToleranceSquared = FMath::Square(GHLtCReplayVerifyTolerance);
+	for (int32 Index = 0; Index < int32(Checkpoint.Combatants.size()); Index++)
+	{
+		const FHLtC_ReplayCombatant& Recorded = Checkpoint.Combatants[Index];
+		const FHLtC_ReplayCombatant& Played = CapturedCheckpoint.Combatants[Index];
+		const FVector RecordedLocation(Recorded.Body.X, Recorded.Body.Y, Recorded.Body.Z);
+		const FVector PlayedLocation(Played.Body.X, Played.Body.Y, Played.Body.Z);
+
+		const bool bStateDiverged = FMemory::Memcmp(&Recorded.State, &Played.State, sizeof(FHLtC_CombatantSnapshot)) != 0 || Recorded.Held != Played.Held;
+		const bool bBodyDiverged = FVector::DistSquared(RecordedLocation, PlayedLocation) > ToleranceSquared;
+		if (bStateDiverged || bBodyDiverged)
+		{
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("Combat replay diverged before frame %u: %s %s (%.1f cm off)."), Checkpoint.Frame, *GetSimulation()->GetCharacter(Index)->GetName(),
+				bStateDiverged ? TEXT("has a different combat state") : TEXT("is in a different place"), FVector::Dist(RecordedLocation, PlayedLocation));
+			NumDivergences++;
+		}
+	}
+}
+
+void UHLtC_CombatReplaySubsystem::SetFastForward(bool bEnable)
+{
+	if (bFastForward == bEnable)
+	{
+		return;
+	}
+
+	bFastForward = bEnable;
+	FApp::SetBenchmarking(bEnable); // Doesn't wait for the frame rate, the recorded delta times are used all the same
+	if (UGameViewportClient* Viewport = GetWorld()->GetGameViewport())
+	{
+		Viewport->bDisableWorldRendering = bEnable;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console commands
+
+static UHLtC_CombatReplaySubsystem* GetReplaySubsystem(UWorld* World)
+{
+	UHLtC_CombatReplaySubsystem* Replay = World ? World->GetSubsystem<UHLtC_CombatReplaySubsystem>() : nullptr;
+	if (!Replay)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("Combat replays need a game world."));
+	}
+	return Replay;
+}
+
+static void RecordCombatReplay(const TArray<FString>& Args, UWorld* World)
+{
+	if (UHLtC_CombatReplaySubsystem* Replay = GetReplaySubsystem(World))
+	{
+		const FString Path = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("Replays") / FString::Printf(TEXT("HLtCCombat-%s.hltcreplay"), *FDateTime::Now().ToString());
+		if (Replay->StartRecording(Path))
+		{
+			UE_LOG(LogTemplateCharacter, Display, TEXT("Recording combat replay to '%s'."), *Path);
+		}
+	}
+}
+
+static void StopCombatReplay(const TArray<FString>& Args, UWorld* World)
+{
+	if (UHLtC_CombatReplaySubsystem* Replay = GetReplaySubsystem(World))
+	{
+		Replay->Stop();
+	}
+}
+
+static void PlayCombatReplay(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("hltc.Replay.Play needs the path of a replay."));
+		return;
+	}
+
+	if (UHLtC_CombatReplaySubsystem* Replay = GetReplaySubsystem(World))
+	{
+		Replay->StartPlayback(Args[0], Args.Num() > 1 && FCString::Atoi(*Args[1]) != 0);
+	}
+}
+
+static void SeekCombatReplay(const TArray<FString>& Args, UWorld* World)
+{
+	UHLtC_CombatReplaySubsystem* Replay = GetReplaySubsystem(World);
+	if (Replay && (Args.Num() < 1 || !Replay->SeekPlayback(uint32(FMath::Max(FCString::Atoi(*Args[0]), 0)))))
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("hltc.Replay.Seek needs a playing replay and a frame in it."));
+	}
+}
+
+static FAutoConsoleCommand CmdHLtCReplayRecord(
+	TEXT("hltc.Replay.Record"),
+	TEXT("Records the combat input of the world to a replay file, starting with the next frame. Args: [Path=Saved/Replays/HLtCCombat-<time>.hltcreplay]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RecordCombatReplay));
+
+static FAutoConsoleCommand CmdHLtCReplayStop(
+	TEXT("hltc.Replay.Stop"),
+	TEXT("Finishes the combat replay being recorded, or stops the one playing."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StopCombatReplay));
+
+static FAutoConsoleCommand CmdHLtCReplayPlay(
+	TEXT("hltc.Replay.Play"),
+	TEXT("Plays a combat replay back through the characters input handlers, verifying it against its checkpoints. Args: <Path> [FastForward=0]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&PlayCombatReplay));
+
+static FAutoConsoleCommand CmdHLtCReplaySeek(
+	TEXT("hltc.Replay.Seek"),
+	TEXT("Jumps the playing combat replay to a frame, from the checkpoint before it. Args: <Frame>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SeekCombatReplay));
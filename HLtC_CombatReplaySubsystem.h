@@ -0,0 +1,123 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HLtC_CombatReplay.h"
+#include "HLtC_CombatReplaySubsystem.generated.h"
+
+class AHLtC_CombatSystemCharacter;
+class UHLtC_CombatSimulationSubsystem;
+class FHLtC_ReplayWriter;
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FInputActionValue;
+enum class EHLtC_InputAction : uint8;
+
+/**
+ * Records the combat input of a world to a replay file, and plays one back through the same input handlers.
+ * Every frame stores its delta time and the clock the simulation ticked at, so playback can run the simulation exactly as it ran while recording.
+ * Checkpoints of the combat state are stored every hltc.Replay.CheckpointInterval frames. Playback checks itself against them, and seeks start from them.
+ */
+UCLASS()
+class UHLtC_CombatReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts recording to Path with the next frame. Returns false if a replay is already recording or playing */
+	bool StartRecording(const FString& Path);
+
+	/** Starts playing the replay at Path with the next frame. The world must hold the same combat characters, registered in the same order, as when it was recorded */
+	bool StartPlayback(const FString& Path, bool bInFastForward);
+
+	/** Jumps a playing replay to Frame, restoring the checkpoint before it and fast-forwarding the rest of the way */
+	bool SeekPlayback(uint32 InFrame);
+
+	void Stop(); // Finishes a recording, or ends a playback and gives control back to the players
+
+	bool IsRecording() const { return Mode == EMode::Recording; }
+	bool IsPlaying() const { return Mode == EMode::Playing; }
+
+	/** Called by the characters input handlers. Records the input, and returns false if the handler should ignore it because a replay is in control */
+	bool FilterInput(AHLtC_CombatSystemCharacter* Character, EHLtC_InputAction Action, const FInputActionValue& Value);
+
+private:
+	enum class EMode : uint8
+	{
+		None,
+		Recording,
+		Playing,
+	};
+
+	struct FBufferedInput
+	{
+		TWeakObjectPtr<AHLtC_CombatSystemCharacter> Character;
+		FHLtC_ReplayInput Input; // Without its ActorId, which is only given out when the input is written
+	};
+
+	void OnPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	// Recording
+
+	void RecordFrame(float DeltaSeconds); // Writes the frame that just ended with its input, and a checkpoint when one is due
+	void WriteCheckpoint(uint32 InFrame);
+	void CaptureCheckpoint(FHLtC_ReplayCheckpoint& Out); // Saves the current state of every combatant, without actor ids
+	uint16 GetActorId(AHLtC_CombatSystemCharacter* Character); // Writes the actors name the first time it's used
+	int64 ToReplayTime(double Clock) const { return FMath::RoundToInt64((Clock - BaseClock) * 1000000.0); }
+
+	// Playback
+
+	void PlayFrame(); // Checks or restores the checkpoint before the frame, then feeds the frames input to the characters
+	bool ReadToNextFrame(); // Feeds the input up to the next frame record to the characters, keeping that record and any checkpoint before it. Returns false at the end of the replay
+	bool RestoreCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint);
+	void VerifyCheckpoint(const FHLtC_ReplayCheckpoint& Checkpoint);
+	bool MapCharacters(); // Finds the character of every actor id by name
+	double FromReplayTime(int64 Time) const { return BaseClock + Time / 1000000.0; }
+	void SetFastForward(bool bEnable);
+
+	UHLtC_CombatSimulationSubsystem* GetSimulation() const;
+
+	EMode Mode = EMode::None;
+	bool bStarted = false; // Recording starts on the frame after it's requested, so it covers whole frames
+	FString ReplayPath;
+	double BaseClock = 0.0; // Input clock replay times are relative to
+	uint32 Frame = 0; // Frame being recorded or played
+	FDelegateHandle PreActorTickHandle;
+	TArray<FHLtC_CombatantSnapshot> Snapshots; // Scratch space for checkpoints
+	TArray<uint8> HeldInputs;
+	FHLtC_ReplayCheckpoint CapturedCheckpoint;
+
+	// Recording
+	FHLtC_ReplayEncoder Encoder;
+	TUniquePtr<FHLtC_ReplayWriter> Writer;
+	TMap<TObjectKey<AHLtC_CombatSystemCharacter>, uint16> ActorIds;
+	TArray<FBufferedInput> BufferedInputs; // Input of the current frame, written once the frame has ended
+	float FrameDeltaTime = 0.0f; // Delta time of the current frame
+
+	// Playback
+	FHLtC_ReplayDecoder Decoder;
+	IMappedFileHandle* MappedFile = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+	TArray<uint8> LoadedFile; // Only used where the file couldn't be mapped
+	TArray<TWeakObjectPtr<AHLtC_CombatSystemCharacter>> ActorCharacters; // Character of each actor id
+	FHLtC_ReplayRecord PendingFrame; // Frame record of the next frame to play
+	FHLtC_ReplayCheckpoint PendingCheckpoint; // Checkpoint read ahead of the next frame, verified once the frame before it has run
+	bool bHasPendingCheckpoint = false;
+	bool bRestorePending = false; // The pending checkpoint starts the playback instead of being verified
+	bool bEndOfReplay = false;
+	bool bInjecting = false; // Set while input is fed to the characters, so FilterInput lets it through
+	bool bFastForward = false; // Playing without rendering and without waiting on the frame rate
+	bool bFastForwardWhole = false; // Fast-forward the whole playback rather than just up to SeekTarget
+	uint32 SeekTarget = 0;
+	int32 NumCheckpointsVerified = 0;
+	int32 NumDivergences = 0;
+	bool bSavedUseFixedTimeStep = false;
+	double SavedFixedDeltaTime = 0.0;
+};
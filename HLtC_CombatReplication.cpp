@@ -0,0 +1,13 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatReplication.h"
+
+bool FHLtC_ReplicatedCombatState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = State.Serialize([&Ar](uint32& Value, uint32 NumBits)
+	{
+		Ar.SerializeInt(Value, 1u << NumBits); // Exactly NumBits, whichever way the archive goes
+	});
+	bOutSuccess &= !Ar.IsError();
+	return true;
+}
@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HLtC_CombatNet.h"
+#include "HLtC_CombatReplication.generated.h"
+
+/**
+ * Replicated form of a combatants FHLtC_NetCombatState. Serialized bit-packed, and only sent when it differs from what the client last received.
+ * The server refreshes it whenever the simulation writes the combatant back, which is only when its state changed.
+ */
+USTRUCT()
+struct FHLtC_ReplicatedCombatState
+{
+	GENERATED_BODY()
+
+	FHLtC_NetCombatState State;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FHLtC_ReplicatedCombatState& Other) const { return State == Other.State; }
+};
+
+template<>
+struct TStructOpsTypeTraits<FHLtC_ReplicatedCombatState> : public TStructOpsTypeTraitsBase2<FHLtC_ReplicatedCombatState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true, // Unchanged states aren't sent
+	};
+};
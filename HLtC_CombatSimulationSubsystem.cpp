@@ -0,0 +1,1048 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatSimulationSubsystem.h"
+#include "HLtC_CombatSystemCharacter.h"
+#include "HLtC_AttackChainAsset.h"
+#include "HLtC_CameraRigComponent.h"
+#include "HLtC_CombatTrace.h"
+#include "HLtC_DodgeRootMotionSource.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include <algorithm>
+
+static int32 GHLtCCombatParallelTick = 0;
+static FAutoConsoleVariableRef CVarHLtCCombatParallelTick(
+	TEXT("hltc.Combat.ParallelTick"),
+	GHLtCCombatParallelTick,
+	TEXT("Advances the combat simulation across worker threads. Results are bit-identical to the single-threaded path.\n")
+	TEXT("0: game thread only (default), 1: ParallelFor"));
+
+static int32 GHLtCCombatParallelBatchSize = 256;
+static FAutoConsoleVariableRef CVarHLtCCombatParallelBatchSize(
+	TEXT("hltc.Combat.ParallelBatchSize"),
+	GHLtCCombatParallelBatchSize,
+	TEXT("Number of combatants advanced by each worker task when hltc.Combat.ParallelTick is on."));
+
+static float GHLtCCombatFixedTimestep = 1.0f / 60.0f;
+static FAutoConsoleVariableRef CVarHLtCCombatFixedTimestep(
+	TEXT("hltc.Combat.FixedTimestep"),
+	GHLtCCombatFixedTimestep,
+	TEXT("Duration in seconds of each combat simulation step, independent of the frame rate."));
+
+static int32 GHLtCCombatMaxStepsPerFrame = 8;
+static FAutoConsoleVariableRef CVarHLtCCombatMaxStepsPerFrame(
+	TEXT("hltc.Combat.MaxStepsPerFrame"),
+	GHLtCCombatMaxStepsPerFrame,
+	TEXT("Most combat simulation steps run in one frame. Time beyond that after a hitch is dropped."));
+
+static int32 GHLtCCombatRollbackFrames = 0;
+static FAutoConsoleVariableRef CVarHLtCCombatRollbackFrames(
+	TEXT("hltc.Combat.RollbackFrames"),
+	GHLtCCombatRollbackFrames,
+	TEXT("Number of recent combat steps kept so the simulation can be rolled back and resimulated. 0 disables recording."));
+
+static int32 GHLtCCombatBatchedHits = 1;
+static FAutoConsoleVariableRef CVarHLtCCombatBatchedHits(
+	TEXT("hltc.Combat.BatchedHits"),
+	GHLtCCombatBatchedHits,
+	TEXT("Resolves every attack of a frame in one batch against a grid of the combatants, and reports the hits through OnAttackHit.\n")
+	TEXT("0: off, attacks are left to listeners of OnHitWindowOpened (e.g. the Blueprint hitscan), 1: on (default)"));
+
+static float GHLtCCombatHitCellSize = 400.0f;
+static FAutoConsoleVariableRef CVarHLtCCombatHitCellSize(
+	TEXT("hltc.Combat.HitCellSize"),
+	GHLtCCombatHitCellSize,
+	TEXT("Width of the grid cells batched hits are resolved against. Best around the longest attack reach."));
+
+static int32 GHLtCCombatTickLOD = 1;
+static FAutoConsoleVariableRef CVarHLtCCombatTickLOD(
+	TEXT("hltc.Combat.TickLOD"),
+	GHLtCCombatTickLOD,
+	TEXT("Lowers the tick rate of combatants far from every player, and stops it for idle ones nobody can see.\n")
+	TEXT("0: every combatant ticks every frame, 1: tick buckets by significance (default)"));
+
+static float GHLtCCombatSignificanceInterval = 0.25f;
+static FAutoConsoleVariableRef CVarHLtCCombatSignificanceInterval(
+	TEXT("hltc.Combat.SignificanceInterval"),
+	GHLtCCombatSignificanceInterval,
+	TEXT("Seconds between re-sorting combatants into tick buckets. Input and hits wake combatants straight away regardless."));
+
+static float GHLtCCombatFullTickDistance = 2000.0f;
+static FAutoConsoleVariableRef CVarHLtCCombatFullTickDistance(
+	TEXT("hltc.Combat.FullTickDistance"),
+	GHLtCCombatFullTickDistance,
+	TEXT("Combatants closer than this to a player tick every frame."));
+
+static float GHLtCCombatReducedTickDistance = 6000.0f;
+static FAutoConsoleVariableRef CVarHLtCCombatReducedTickDistance(
+	TEXT("hltc.Combat.ReducedTickDistance"),
+	GHLtCCombatReducedTickDistance,
+	TEXT("Combatants further than this from every player, and not rendered, can go dormant once idle."));
+
+static float GHLtCCombatReducedTickInterval = 0.1f;
+static FAutoConsoleVariableRef CVarHLtCCombatReducedTickInterval(
+	TEXT("hltc.Combat.ReducedTickInterval"),
+	GHLtCCombatReducedTickInterval,
+	TEXT("Seconds between ticks of combatants in the reduced bucket."));
+
+static float GHLtCCombatInvolvementTime = 3.0f;
+static FAutoConsoleVariableRef CVarHLtCCombatInvolvementTime(
+	TEXT("hltc.Combat.InvolvementTime"),
+	GHLtCCombatInvolvementTime,
+	TEXT("Seconds a combatant stays on the full tick rate after its last input or hit."));
+
+static int32 GHLtCCombatHistograms = 1;
+static FAutoConsoleVariableRef CVarHLtCCombatHistograms(
+	TEXT("hltc.Combat.Histograms"),
+	GHLtCCombatHistograms,
+	TEXT("Records the simulation tick time and every combat counter of each frame into histograms, dumped with hltc.Combat.DumpHistograms. Works in Shipping, where only the tick time is recorded.\n")
+	TEXT("0: off, 1: on (default)"));
+
+static int32 GHLtCNetValidateInput = 1;
+static FAutoConsoleVariableRef CVarHLtCNetValidateInput(
+	TEXT("hltc.Net.ValidateInput"),
+	GHLtCNetValidateInput,
+	TEXT("Checks the claims clients send with their attack and block input against the servers timeline on worker threads, counting desyncs and cheats.\n")
+	TEXT("0: off, 1: on (default)"));
+
+static float GHLtCNetValidationTolerance = 0.1f;
+static FAutoConsoleVariableRef CVarHLtCNetValidationTolerance(
+	TEXT("hltc.Net.ValidationTolerance"),
+	GHLtCNetValidationTolerance,
+	TEXT("Seconds a client's claim may run ahead of the servers timeline, for jitter in when its input arrives, before it counts as a cheat rather than a desync."));
+
+static int32 GHLtCNetValidationBatchSize = 64;
+static FAutoConsoleVariableRef CVarHLtCNetValidationBatchSize(
+	TEXT("hltc.Net.ValidationBatchSize"),
+	GHLtCNetValidationBatchSize,
+	TEXT("Number of combatants whose claims each worker task checks."));
+
+//////////////////////////////////////////////////////////////////////////
+// Frame stats
+
+/** Per frame histograms of every simulation subsystem in the process, kept outside the subsystems so they survive map changes */
+struct FHLtC_CombatHistograms
+{
+	FHLtC_Histogram TickMicroseconds;
+	FHLtC_Histogram Counters[HLtC::Counter_Num];
+};
+
+static FHLtC_CombatHistograms GHLtCCombatFrameHistograms;
+
+/** Hands the counters gathered since the last call to the stat system and the histograms */
+static void RecordFrameStats(FHLtC_CombatFrameStats& Stats)
+{
+	const uint32 (&Counters)[HLtC::Counter_Num] = Stats.Counters;
+	HLtC::GetCombatCounters().TakeFrame(Stats.Counters);
+
+	SET_DWORD_STAT(STAT_HLtCCombat_AttacksStarted, Counters[HLtC::Counter_AttacksStarted]);
+	SET_DWORD_STAT(STAT_HLtCCombat_AttacksBuffered, Counters[HLtC::Counter_AttacksBuffered]);
+	SET_DWORD_STAT(STAT_HLtCCombat_AttacksDropped, Counters[HLtC::Counter_AttacksDropped]);
+	SET_DWORD_STAT(STAT_HLtCCombat_ChainResets, Counters[HLtC::Counter_ChainResets]);
+	SET_DWORD_STAT(STAT_HLtCCombat_ActionTransitions, Counters[HLtC::Counter_ActionTransitions]);
+	SET_DWORD_STAT(STAT_HLtCCombat_Allocations, Counters[HLtC::Counter_Allocations]);
+	SET_DWORD_STAT(STAT_HLtCCombat_NetCorrections, Counters[HLtC::Counter_NetCorrections]);
+	SET_DWORD_STAT(STAT_HLtCCombat_InputsValidated, Counters[HLtC::Counter_InputsValidated]);
+	SET_DWORD_STAT(STAT_HLtCCombat_NetDesyncs, Counters[HLtC::Counter_NetDesyncs]);
+	SET_DWORD_STAT(STAT_HLtCCombat_CheatsDetected, Counters[HLtC::Counter_CheatsDetected]);
+
+	if (GHLtCCombatHistograms == 0)
+	{
+		return;
+	}
+
+	GHLtCCombatFrameHistograms.TickMicroseconds.Add(static_cast<uint64>(Stats.TickSeconds * 1000000.0));
+#if HLTC_COMBAT_COUNTERS
+	for (int32 Counter = 0; Counter < HLtC::Counter_Num; Counter++)
+	{
+		GHLtCCombatFrameHistograms.Counters[Counter].Add(Counters[Counter]);
+	}
+#endif
+}
+
+static void AppendHistogramRow(FString& Csv, const TCHAR* Name, const FHLtC_Histogram& Histogram)
+{
+	const double Mean = Histogram.NumSamples > 0 ? static_cast<double>(Histogram.Sum) / static_cast<double>(Histogram.NumSamples) : 0.0;
+	Csv += FString::Printf(TEXT("%s,%llu,%.2f,%llu,%llu,%llu,%llu"), Name, static_cast<uint64>(Histogram.NumSamples), Mean,
+		static_cast<uint64>(Histogram.GetPercentile(0.5)), static_cast<uint64>(Histogram.GetPercentile(0.9)), static_cast<uint64>(Histogram.GetPercentile(0.99)), static_cast<uint64>(Histogram.Max));
+
+	for (int32 Bucket = 0; Bucket < FHLtC_Histogram::NumBuckets; Bucket++)
+	{
+		Csv += FString::Printf(TEXT(",%llu"), static_cast<uint64>(Histogram.Buckets[Bucket]));
+	}
+	Csv += TEXT("\n");
+}
+
+/** Writes every histogram to a CSV file, one row each, and starts them over. Console only, so it can be run on a dedicated server */
+static void DumpCombatHistograms(const TArray<FString>& Args)
+{
+	const FString Path = Args.IsValidIndex(0) ? Args[0] : FPaths::ProfilingDir() / FString::Printf(TEXT("HLtCCombatHistograms-%s.csv"), *FDateTime::Now().ToString());
+
+	FString Csv = TEXT("Histogram,Samples,Mean,P50,P90,P99,Max");
+	for (int32 Bucket = 0; Bucket < FHLtC_Histogram::NumBuckets; Bucket++) // Each bucket column is named after the smallest value it counts
+	{
+		Csv += FString::Printf(TEXT(",%llu"), static_cast<uint64>(FHLtC_Histogram::GetBucketMin(Bucket)));
+	}
+	Csv += TEXT("\n");
+
+	AppendHistogramRow(Csv, TEXT("TickMicroseconds"), GHLtCCombatFrameHistograms.TickMicroseconds);
+	for (int32 Counter = 0; Counter < HLtC::Counter_Num; Counter++)
+	{
+		AppendHistogramRow(Csv, ANSI_TO_TCHAR(HLtC::GetCounterName(static_cast<HLtC::ECombatCounter>(Counter))), GHLtCCombatFrameHistograms.Counters[Counter]);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Path))
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("Couldn't write the combat histograms to '%s'."), *Path);
+		return;
+	}
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("Wrote %llu frames of combat histograms to '%s'."), static_cast<uint64>(GHLtCCombatFrameHistograms.TickMicroseconds.NumSamples), *Path);
+	GHLtCCombatFrameHistograms = FHLtC_CombatHistograms();
+}
+
+static FAutoConsoleCommand CmdHLtCCombatDumpHistograms(
+	TEXT("hltc.Combat.DumpHistograms"),
+	TEXT("Writes the per frame combat histograms to a CSV file and resets them. Args: [Path=Saved/Profiling/HLtCCombatHistograms-<time>.csv]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpCombatHistograms));
+
+//////////////////////////////////////////////////////////////////////////
+// UHLtC_CombatSimulationSubsystem
+
+void UHLtC_CombatSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	World.MoveTable = &FHLtC_AttackChainRegistry::Get().GetMoveTable();
+}
+
+void UHLtC_CombatSimulationSubsystem::Deinitialize()
+{
+	ValidationTask.Wait(); // It reads the move table and the validator
+
+	Super::Deinitialize();
+}
+
+TStatId UHLtC_CombatSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHLtC_CombatSimulationSubsystem, STATGROUP_Tickables);
+}
+
+bool UHLtC_CombatSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHLtC_CombatSimulationSubsystem::RegisterCombatant(AHLtC_CombatSystemCharacter* Character)
+{
+	check(Character && Character->Hot.CombatantIndex == INDEX_NONE);
+
+	ValidationTask.Wait(); // A new weapon can grow the move table the validation reads
+	const uint8 Weapon = FHLtC_AttackChainRegistry::Get().RegisterWeapon(Character->AttackChains); // Compiles the weapons chains the first time any character uses them
+	Character->Hot.CombatantIndex = World.Add(Weapon);
+	PendingInputs.AddDefaulted();
+	Characters.Add(Character);
+	TickBuckets.Add(EHLtC_TickBucket::Full); // Actors start out ticking every frame
+	LastCombatTimes.Add(0.0);
+
+	WriteBack(Character->Hot.CombatantIndex);
+	SendNotifications();
+}
+
+void UHLtC_CombatSimulationSubsystem::UnregisterCombatant(AHLtC_CombatSystemCharacter* Character)
+{
+	const int32 Index = Character->Hot.CombatantIndex;
+	if (!Characters.IsValidIndex(Index) || Characters[Index] != Character)
+	{
+		return;
+	}
+
+	World.RemoveAtSwap(Index);
+	PendingInputs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Characters.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TickBuckets.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	LastCombatTimes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Character->Hot.CombatantIndex = INDEX_NONE;
+
+	if (Characters.IsValidIndex(Index)) // The last combatant now lives in the removed slot
+	{
+		Characters[Index]->Hot.CombatantIndex = Index;
+	}
+
+	// Attacks and claims waiting to be handled follow their combatant, the removed combatants are dropped along with its notifications
+	const int32 MovedFrom = Characters.Num();
+	DrainInputClaims();
+	PendingClaims.RemoveAll([Index](const FHLtC_InputClaim& Claim) { return Claim.Combatant == Index; });
+	for (FHLtC_InputClaim& Claim : PendingClaims)
+	{
+		Claim.Combatant = Claim.Combatant == MovedFrom ? Index : Claim.Combatant;
+	}
+
+	PendingAttacks.erase(std::remove_if(PendingAttacks.begin(), PendingAttacks.end(), [Index](const FHLtC_Attack& Attack) { return Attack.Attacker == Index; }), PendingAttacks.end());
+	for (FHLtC_Attack& Attack : PendingAttacks)
+	{
+		Attack.Attacker = Attack.Attacker == MovedFrom ? Index : Attack.Attacker;
+	}
+	PendingEvents.RemoveAll([Character](const TPair<AHLtC_CombatSystemCharacter*, FHLtC_CombatEvent>& Event) { return Event.Key == Character; });
+}
+
+void UHLtC_CombatSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_Tick);
+
+	const uint64 TickStartCycles = FPlatformTime::Cycles64();
+	const int32 NumCombatants = World.Num();
+	const float FixedTimestep = FMath::Max(GHLtCCombatFixedTimestep, 1.0f / 1000.0f);
+
+	SignificanceAccumulator += DeltaTime;
+	if (SignificanceAccumulator >= GHLtCCombatSignificanceInterval)
+	{
+		SignificanceAccumulator = 0.0f;
+		UpdateSignificance();
+	}
+
+	// Gather the one input that doesn't arrive through the input handlers. Touches actors, so stays on the game thread
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		if (TickBuckets[Index] == EHLtC_TickBucket::Dormant) // Dormant movement doesn't tick, so the velocity can't have changed
+		{
+			continue;
+		}
+
+		uint8& Held = PendingInputs[Index].Held;
+		Held = Characters[Index]->GetCharacterMovement()->Velocity.IsZero() ? (Held & ~HLtC::Input_Moving) : (Held | HLtC::Input_Moving);
+	}
+
+	const bool bRecordRollback = GHLtCCombatRollbackFrames > 0;
+	if (bRecordRollback && (Rollback.GetNumFrames() != GHLtCCombatRollbackFrames || Rollback.GetMaxCombatants() < NumCombatants))
+	{
+		Rollback.Init(GHLtCCombatRollbackFrames, FMath::RoundUpToPowerOfTwo(FMath::Max(NumCombatants, 1))); // Grows in powers of two, so recording only allocates when the combatant count doubles
+	}
+
+	// Fixed steps make the timing rules independent of the frame rate
+	StepAccumulator += DeltaTime;
+	LastTickClock = GetInputClock();
+	double StepStartTime = LastTickClock - StepAccumulator; // Input events are stamped on the input clock, so that's what steps are placed on
+	SyncValidation(StepStartTime); // Before the steps, so the batch starts from the world the claimed input is about to be stepped on
+	int32 NumSteps = 0;
+	while (StepAccumulator >= FixedTimestep && NumSteps < GHLtCCombatMaxStepsPerFrame)
+	{
+		for (int32 Index = 0; Index < NumCombatants; Index++) // Events land at the point in the step they happened at
+		{
+			HLtC::ConsumeInputEvents(Characters[Index]->InputEvents, PendingInputs[Index], StepStartTime, FixedTimestep);
+		}
+
+		if (bRecordRollback)
+		{
+			Rollback.SaveFrame(CurrentFrame, World, PendingInputs.GetData(), FixedTimestep);
+		}
+
+		StepWorld(World, PendingInputs.GetData(), FixedTimestep, GHLtCCombatParallelTick != 0); // Pure state advance, optionally across worker threads
+
+		HLtC::GatherStartedAttacks(World, PendingAttacks); // Announced whether hits are batched or not
+
+		for (FHLtC_CombatInput& Input : PendingInputs)
+		{
+			Input.NumPresses = 0; // Presses belong to the step they were consumed by
+		}
+
+		StepAccumulator -= FixedTimestep;
+		StepStartTime += FixedTimestep;
+		CurrentFrame++;
+		NumSteps++;
+	}
+	StepAccumulator = FMath::Min(StepAccumulator, FixedTimestep);
+
+	ResolveHits(); // Characters only move once a frame, so every step of it is resolved against the same positions
+
+	// Apply phase. Only characters whose state changed are touched, serialized on the game thread
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		if (World.Changed[Index])
+		{
+			WriteBack(Index);
+		}
+	}
+
+	SendNotifications(); // Last, so listeners see every character in its new state
+
+	LastFrameStats.TickSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - TickStartCycles);
+	RecordFrameStats(LastFrameStats);
+}
+
+void UHLtC_CombatSimulationSubsystem::UpdateSignificance()
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_UpdateSignificance);
+
+	const int32 NumCombatants = World.Num();
+	if (GHLtCCombatTickLOD == 0)
+	{
+		for (int32 Index = 0; Index < NumCombatants; Index++)
+		{
+			SetTickBucket(Index, EHLtC_TickBucket::Full);
+		}
+		return;
+	}
+
+	// Significance is measured from every player, so it works on a dedicated server as well as a client
+	TArray<FVector, TInlineAllocator<8>> ViewLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			if (const APawn* Pawn = PlayerController->GetPawn())
+			{
+				ViewLocations.Add(Pawn->GetActorLocation());
+			}
+		}
+	}
+
+	const double Now = GetInputClock();
+	const float FullDistanceSquared = FMath::Square(GHLtCCombatFullTickDistance);
+	const float ReducedDistanceSquared = FMath::Square(GHLtCCombatReducedTickDistance);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		const AHLtC_CombatSystemCharacter* Character = Characters[Index];
+
+		const bool bInvolved = Character->IsPlayerControlled() || Character->LockOnTarget != nullptr
+			|| (World.Flags[Index] & (HLtC::Flag_StaticAction | HLtC::Flag_AttackBuffered | HLtC::Flag_DodgeBuffered | HLtC::Flag_Blocking)) != 0
+			|| Now - LastCombatTimes[Index] < GHLtCCombatInvolvementTime;
+
+		float DistanceSquared = TNumericLimits<float>::Max();
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			DistanceSquared = FMath::Min(DistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Character->GetActorLocation())));
+		}
+
+		const bool bRendered = Character->WasRecentlyRendered(0.5f);
+		const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+		const bool bSettled = Movement->Velocity.IsZero() && !Movement->IsFalling(); // Anything still moving has to finish moving first
+
+		EHLtC_TickBucket Bucket = EHLtC_TickBucket::Dormant;
+		if (bInvolved || (bRendered && DistanceSquared <= FullDistanceSquared))
+		{
+			Bucket = EHLtC_TickBucket::Full;
+		}
+
+		else if (bRendered || DistanceSquared <= ReducedDistanceSquared || !bSettled)
+		{
+			Bucket = EHLtC_TickBucket::Reduced;
+		}
+
+		SetTickBucket(Index, Bucket);
+	}
+}
+
+void UHLtC_CombatSimulationSubsystem::SetTickBucket(int32 Index, EHLtC_TickBucket Bucket)
+{
+	if (TickBuckets[Index] == Bucket)
+	{
+		return;
+	}
+	TickBuckets[Index] = Bucket;
+
+	// Ticks at a reduced rate are handed all the time since their last tick, so anything integrated over DeltaTime stays correct
+	AHLtC_CombatSystemCharacter* Character = Characters[Index];
+	UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	const float Interval = Bucket == EHLtC_TickBucket::Reduced ? GHLtCCombatReducedTickInterval : 0.0f;
+	const bool bTicks = Bucket != EHLtC_TickBucket::Dormant;
+
+	Character->SetActorTickInterval(Interval);
+	Character->SetActorTickEnabled(bTicks);
+	Movement->SetComponentTickInterval(Interval);
+	Movement->SetComponentTickEnabled(bTicks);
+}
+
+void UHLtC_CombatSimulationSubsystem::WakeCombatant(int32 Index)
+{
+	if (TickBuckets.IsValidIndex(Index))
+	{
+		LastCombatTimes[Index] = GetInputClock();
+		SetTickBucket(Index, EHLtC_TickBucket::Full);
+	}
+}
+
+void UHLtC_CombatSimulationSubsystem::ResolveHits()
+{
+	Hits.clear();
+	HitCharacters.Reset();
+	if (PendingAttacks.empty() || GHLtCCombatBatchedHits == 0)
+	{
+		return;
+	}
+
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_ResolveHits);
+
+	const int32 NumCombatants = World.Num();
+	HitBounds.SetNum(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		const AHLtC_CombatSystemCharacter* Character = Characters[Index];
+		const FVector Location = Character->GetActorLocation();
+		const FVector Forward = Character->GetActorForwardVector().GetSafeNormal2D();
+
+		HitBounds.X[Index] = static_cast<float>(Location.X);
+		HitBounds.Y[Index] = static_cast<float>(Location.Y);
+		HitBounds.Z[Index] = static_cast<float>(Location.Z);
+		HitBounds.ForwardX[Index] = static_cast<float>(Forward.X);
+		HitBounds.ForwardY[Index] = static_cast<float>(Forward.Y);
+		HitBounds.Radius[Index] = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+		HitBounds.HalfHeight[Index] = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		HitBounds.Blocking[Index] = World.HasFlag(Index, HLtC::Flag_Blocking) ? 1 : 0;
+		HitBounds.Invulnerable[Index] = World.IsInvulnerable(Index) ? 1 : 0; // From the compiled dodge, the hit test never looks at an animation
+	}
+
+	HitResolver.CellSize = FMath::Max(GHLtCCombatHitCellSize, 1.0f);
+	HitResolver.Resolve(HitBounds, *World.MoveTable, PendingAttacks.data(), static_cast<int32>(PendingAttacks.size()), Hits);
+
+	// Listeners can destroy characters, which reorders the combatants, so the characters are looked up before anything is sent
+	HitCharacters.Reset();
+	for (const FHLtC_HitEvent& Hit : Hits)
+	{
+		HitCharacters.Emplace(Characters[Hit.Attacker], Characters[Hit.Target]);
+		WakeCombatant(Hit.Attacker); // Both sides of a hit are part of a fight now
+		WakeCombatant(Hit.Target);
+	}
+}
+
+void UHLtC_CombatSimulationSubsystem::QueueEvent(AHLtC_CombatSystemCharacter* Character, EHLtC_CombatEvent Type)
+{
+	FHLtC_CombatEvent Event;
+	Event.Type = Type;
+	Event.Action = Character->Hot.States.Action;
+	Event.AttackIndex = Character->Hot.States.AttackIndex;
+	Event.AttackType = Character->Hot.CurrentAttackType;
+	Event.ControlState = Character->Hot.States.ControlState;
+	Event.CameraState = Character->Hot.States.CameraState;
+	PendingEvents.Emplace(Character, Event);
+}
+
+void UHLtC_CombatSimulationSubsystem::SendNotifications()
+{
+	if (bSendingNotifications) // A listener changed a state, its notifications go out after the ones being sent
+	{
+		return;
+	}
+	TGuardValue<bool> SendingGuard(bSendingNotifications, true);
+
+	// Every move entered is announced, even when the chain restarts at the index it was already at, which the written back states can't show
+	for (const FHLtC_Attack& Attack : PendingAttacks)
+	{
+		AHLtC_CombatSystemCharacter* Character = Characters[Attack.Attacker];
+		const FHLtC_CompiledMove& Move = World.MoveTable->GetMove(Attack.Move);
+
+		if (Character->Hot.bInAttackChain && Move.ChainIndex == 0)
+		{
+			QueueEvent(Character, EHLtC_CombatEvent::ChainEnded);
+		}
+		Character->Hot.bInAttackChain = true;
+
+		FHLtC_CombatEvent Event;
+		Event.Type = EHLtC_CombatEvent::AttackStarted;
+		Event.Action = Move.Action;
+		Event.AttackIndex = Move.ChainIndex;
+		Event.AttackType = Move.Action == EHLtC_PlayerAction::HeavyAttack ? EHLtC_AttackType::Heavy : EHLtC_AttackType::Light;
+		Event.ControlState = Character->Hot.States.ControlState;
+		Event.CameraState = Character->Hot.States.CameraState;
+		PendingEvents.Emplace(Character, Event);
+
+		Event.Type = EHLtC_CombatEvent::HitWindowOpened;
+		PendingEvents.Emplace(Character, Event);
+	}
+	PendingAttacks.clear();
+
+	while (PendingEvents.Num() > 0) // Swapped out, as listeners can queue more
+	{
+		Swap(PendingEvents, SendingEvents);
+		for (const TPair<AHLtC_CombatSystemCharacter*, FHLtC_CombatEvent>& Event : SendingEvents)
+		{
+			if (IsValid(Event.Key))
+			{
+				Event.Key->NotifyCombatEvent(Event.Value);
+				OnCombatEvent.Broadcast(Event.Key, Event.Value);
+			}
+		}
+		SendingEvents.Reset();
+	}
+
+	for (int32 HitIndex = 0; HitIndex < HitCharacters.Num(); HitIndex++)
+	{
+		AHLtC_CombatSystemCharacter* Attacker = HitCharacters[HitIndex].Key;
+		AHLtC_CombatSystemCharacter* Target = HitCharacters[HitIndex].Value;
+		if (IsValid(Attacker) && IsValid(Target))
+		{
+			Attacker->OnAttackHit.Broadcast(Target, Hits[HitIndex].Damage, Hits[HitIndex].bBlocked);
+		}
+	}
+	HitCharacters.Reset();
+}
+
+void UHLtC_CombatSimulationSubsystem::StepWorld(FHLtC_CombatWorld& InWorld, const FHLtC_CombatInput* Inputs, float DeltaTime, bool bParallel)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_StepWorld);
+
+	const int32 NumCombatants = InWorld.Num();
+	const int32 BatchSize = FMath::Max(GHLtCCombatParallelBatchSize, 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(NumCombatants, BatchSize);
+
+	if (bParallel && NumBatches > 1)
+	{
+		// Every combatant is advanced by exactly the same instructions whichever batch or thread it lands on, so the split can't change the results
+		InWorld.BeginStep(DeltaTime);
+		ParallelFor(NumBatches, [&InWorld, Inputs, BatchSize, NumCombatants](int32 Batch)
+		{
+			const int32 Begin = Batch * BatchSize;
+			InWorld.StepRange(Begin, FMath::Min(Begin + BatchSize, NumCombatants), Inputs);
+		});
+		InWorld.EndStep(Inputs);
+	}
+
+	else
+	{
+		InWorld.Step(Inputs, DeltaTime);
+	}
+}
+
+bool UHLtC_CombatSimulationSubsystem::CorrectInput(uint32 Frame, int32 Index, const FHLtC_CombatInput& Input)
+{
+	FHLtC_CombatInput* FrameInputs = Rollback.GetInputs(Frame);
+	if (FrameInputs == nullptr || Index < 0 || Index >= World.Num())
+	{
+		return false;
+	}
+
+	if (FrameInputs[Index] == Input) // The prediction was right, nothing to replay
+	{
+		return true;
+	}
+
+	const FHLtC_CombatInput Predicted = FrameInputs[Index];
+	FrameInputs[Index] = Input;
+
+	if (Rollback.Resimulate(Frame, World, &PendingAttacks) == 0) // Attacks the corrected input started on any replayed step are announced and resolved like stepped ones
+	{
+		FrameInputs[Index] = Predicted;
+		return false;
+	}
+
+	ResolveHits();
+	for (int32 CombatantIndex = 0; CombatantIndex < World.Num(); CombatantIndex++) // Restoring marks every combatant changed
+	{
+		WriteBack(CombatantIndex);
+	}
+	SendNotifications();
+
+	return true;
+}
+
+void UHLtC_CombatSimulationSubsystem::RestoreState(const FHLtC_CombatantSnapshot* Snapshots, const uint8* Held, int64 Clock, uint32 Frame, float InStepAccumulator)
+{
+	World.RestoreSnapshot(Snapshots, Clock);
+	CurrentFrame = Frame;
+	StepAccumulator = InStepAccumulator;
+	Rollback = FHLtC_RollbackBuffer(); // Recorded frames belong to the timeline that was left, the next Tick starts recording afresh
+	PendingAttacks.clear();
+
+	for (int32 Index = 0; Index < World.Num(); Index++)
+	{
+		PendingInputs[Index] = FHLtC_CombatInput();
+		PendingInputs[Index].Held = Held[Index];
+
+		FHLtC_InputEventRing& InputEvents = Characters[Index]->InputEvents;
+		while (InputEvents.Peek())
+		{
+			InputEvents.Pop();
+		}
+
+		WriteBack(Index);
+	}
+	SendNotifications();
+}
+
+void UHLtC_CombatSimulationSubsystem::RequestAttack(int32 Index, EHLtC_AttackType Type)
+{
+	PendingInputs[Index].AddPress(Type == EHLtC_AttackType::Heavy ? HLtC::Input_HeavyAttack : HLtC::Input_LightAttack);
+	WakeCombatant(Index);
+}
+
+void UHLtC_CombatSimulationSubsystem::RequestDodge(int32 Index, EHLtC_DodgeDirection Direction)
+{
+	PendingInputs[Index].AddPress(HLtC::MakeDodgePress(Direction));
+	WakeCombatant(Index);
+}
+
+void UHLtC_CombatSimulationSubsystem::SetBlocking(int32 Index, bool bBlocking)
+{
+	PendingInputs[Index].AddPress(bBlocking ? HLtC::Input_BlockStarted : HLtC::Input_BlockCompleted);
+	WakeCombatant(Index);
+}
+
+void UHLtC_CombatSimulationSubsystem::SetSprinting(int32 Index, bool bSprinting)
+{
+	uint8& Held = PendingInputs[Index].Held;
+	Held = bSprinting ? (Held | HLtC::Input_Sprinting) : (Held & ~HLtC::Input_Sprinting);
+}
+
+void UHLtC_CombatSimulationSubsystem::SetControlState(int32 Index, EHLtC_ControlState NewState)
+{
+	World.SetControlState(Index, NewState);
+	WriteBack(Index);
+	SendNotifications();
+}
+
+void UHLtC_CombatSimulationSubsystem::SetCameraState(int32 Index, EHLtC_CameraState NewState)
+{
+	World.SetCameraState(Index, NewState);
+	WriteBack(Index);
+	SendNotifications();
+}
+
+bool UHLtC_CombatSimulationSubsystem::MakeDodgeRootMotion(int32 Index, FHLtC_RootMotionSource_Dodge& OutSource) const
+{
+	if (World.Action[Index] != EHLtC_PlayerAction::Dodge || !World.HasFlag(Index, HLtC::Flag_StaticAction))
+	{
+		return false;
+	}
+
+	const FHLtC_CompiledDodge& Dodge = World.MoveTable->GetDodge(World.Weapon[Index], static_cast<EHLtC_DodgeDirection>(World.AttackIndex[Index]));
+	OutSource.SetDodge(*World.MoveTable, Dodge);
+	OutSource.SetTime(FMath::Clamp(Dodge.Duration - World.GetStaticActionDurationTimer(Index) + StepAccumulator, 0.0f, Dodge.Duration));
+	return true;
+}
+
+void UHLtC_CombatSimulationSubsystem::WriteBack(int32 Index)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_WriteBack);
+
+	AHLtC_CombatSystemCharacter* Character = Characters[Index];
+	const uint8 Flags = World.Flags[Index];
+
+	const FHLtC_CombatStateMachine OldStates = Character->Hot.States;
+	const bool bWasBlocking = Character->Hot.bBlocking;
+
+	Character->Hot.bStaticAction = (Flags & HLtC::Flag_StaticAction) != 0;
+	if (Character->CameraRig) { Character->CameraRig->SetHeld(Character->Hot.bStaticAction); } // The camera stays put during static actions
+	Character->Hot.bBlocking = (Flags & HLtC::Flag_Blocking) != 0;
+	Character->Hot.CurrentAttackType = World.CurrentAttackType[Index];
+	Character->Hot.States.ControlState = World.ControlState[Index];
+	Character->Hot.States.CameraState = World.CameraState[Index];
+	Character->SetPlayerAction(World.Action[Index], World.AttackIndex[Index]); // Runs the characters exit and entry hooks
+
+	// Notifications for whatever changed, sent once the apply phase is over
+	if (Character->Hot.bBlocking != bWasBlocking)
+	{
+		QueueEvent(Character, Character->Hot.bBlocking ? EHLtC_CombatEvent::BlockStarted : EHLtC_CombatEvent::BlockEnded);
+	}
+	if (Character->Hot.States.ControlState != OldStates.ControlState)
+	{
+		QueueEvent(Character, EHLtC_CombatEvent::ControlStateChanged);
+	}
+	if (Character->Hot.States.CameraState != OldStates.CameraState)
+	{
+		QueueEvent(Character, EHLtC_CombatEvent::CameraStateChanged);
+	}
+	if (Character->Hot.bInAttackChain && World.AttackMove[Index] == HLtC::InvalidMove)
+	{
+		Character->Hot.bInAttackChain = false;
+		QueueEvent(Character, EHLtC_CombatEvent::ChainEnded);
+	}
+	if (Character->Hot.States.Action != OldStates.Action || Character->Hot.States.AttackIndex != OldStates.AttackIndex)
+	{
+		QueueEvent(Character, EHLtC_CombatEvent::ActionChanged);
+	}
+
+	if (!Character->Hot.bStaticAction) // Static actions keep the defaults they were entered with
+	{
+		Character->ApplyStateDefaults();
+	}
+
+	World.Changed[Index] = 0;
+
+	if (Character->HasAuthority() && GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		// Inputs still queued aren't acknowledged yet, so the combatant keeps being written back till they're consumed
+		const uint32 NumQueued = Character->InputEvents.Num();
+		Character->NetCombatState.State = GetNetState(Index, static_cast<uint8>(Character->Hot.ReceivedInputs - NumQueued));
+		World.Changed[Index] = NumQueued > 0;
+	}
+}
+
+FHLtC_NetCombatState UHLtC_CombatSimulationSubsystem::GetNetState(int32 Index, uint8 InputAck) const
+{
+	FHLtC_CombatantSnapshot Snapshot;
+	World.SaveCombatant(Index, Snapshot);
+	return FHLtC_NetCombatState::FromSnapshot(Snapshot, InputAck);
+}
+
+void UHLtC_CombatSimulationSubsystem::ApplyNetState(int32 Index, const FHLtC_NetCombatState& State, bool bCorrection)
+{
+	FHLtC_CombatantSnapshot Snapshot;
+	World.SaveCombatant(Index, Snapshot);
+	const uint16 OldMove = Snapshot.AttackMove;
+	State.ToSnapshot(Snapshot, *World.MoveTable);
+	World.RestoreCombatant(Index, Snapshot);
+
+	if (Snapshot.AttackMove != HLtC::InvalidMove && Snapshot.AttackMove != OldMove) // Moves entered on the server are announced like the ones stepped here
+	{
+		PendingAttacks.push_back({ Index, Snapshot.AttackMove });
+	}
+
+	uint8& Held = PendingInputs[Index].Held; // Remote combatants get no sprint input here, the replicated flag stands in for it
+	Held = (State.Flags & HLtC::Flag_Sprinting) ? (Held | HLtC::Input_Sprinting) : (Held & ~HLtC::Input_Sprinting);
+
+	if (bCorrection)
+	{
+		HLtC::IncrementCounter(HLtC::Counter_NetCorrections);
+	}
+
+	WriteBack(Index);
+	SendNotifications();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Validation
+
+bool UHLtC_CombatSimulationSubsystem::SubmitInputClaim(FHLtC_InputClaim Claim)
+{
+	Claim.Time = GetInputClock();
+	return GHLtCNetValidateInput != 0 && ClaimQueue.Push(Claim);
+}
+
+void UHLtC_CombatSimulationSubsystem::DrainInputClaims()
+{
+	FHLtC_InputClaim Claim;
+	while (ClaimQueue.Pop(Claim))
+	{
+		PendingClaims.Add(Claim);
+	}
+}
+
+void UHLtC_CombatSimulationSubsystem::SyncValidation(double WorldTime)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_ValidationSync);
+
+	// Verdicts of the batch started last frame. The workers have had the whole frame, so this rarely waits
+	ValidationTask.Wait();
+	const std::vector<EHLtC_InputVerdict>& Verdicts = Validator.GetVerdicts();
+	for (int32 Claim = 0; Claim < ValidatingCharacters.Num(); Claim++)
+	{
+		AHLtC_CombatSystemCharacter* Character = ValidatingCharacters[Claim].Get();
+		const EHLtC_InputVerdict Verdict = Verdicts[Claim];
+		if (Verdict == EHLtC_InputVerdict::Valid || Character == nullptr || Character->Hot.CombatantIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (HLtC::IsCheatVerdict(Verdict))
+		{
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("'%s' sent a %s claim for input %d."), *GetNameSafe(Character), ANSI_TO_TCHAR(HLtC::GetVerdictName(Verdict)),
+				static_cast<int32>(Validator.GetClaims()[Claim].Type));
+		}
+
+		MarkChanged(Character->Hot.CombatantIndex); // Sends the client the servers state, which corrects its prediction
+		OnInputRejected.Broadcast(Character, Verdict);
+	}
+	ValidatingCharacters.Reset();
+
+	DrainInputClaims();
+	if (PendingClaims.IsEmpty() || GHLtCNetValidateInput == 0)
+	{
+		PendingClaims.Reset();
+		return;
+	}
+
+	// The batch starts from copies, so the workers never touch the world while it steps
+	Validator.Tolerance = FMath::Max(GHLtCNetValidationTolerance, 0.0f);
+	Validator.BeginBatch(World, WorldTime, PendingClaims.GetData(), PendingClaims.Num());
+	PendingClaims.Reset();
+	for (const FHLtC_InputClaim& Claim : Validator.GetClaims())
+	{
+		ValidatingCharacters.Add(Characters[Claim.Combatant]);
+	}
+
+	const int32 BatchSize = FMath::Max(GHLtCNetValidationBatchSize, 1);
+	ValidationTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, BatchSize]()
+	{
+		HLTC_COMBAT_SCOPE(STAT_HLtCCombat_ValidateInputs);
+		const int32 NumGroups = Validator.NumGroups();
+		ParallelFor(FMath::DivideAndRoundUp(NumGroups, BatchSize), [this, NumGroups, BatchSize](int32 Batch)
+		{
+			Validator.ValidateRange(Batch * BatchSize, FMath::Min((Batch + 1) * BatchSize, NumGroups));
+		});
+	}, LowLevelTasks::ETaskPriority::BackgroundNormal);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Parallel tick verification
+
+#if !UE_BUILD_SHIPPING
+/** Drives two copies of the simulation with the same seeded random input, one serial and one parallel, and fails on the first step their state differs */
+static bool VerifyParallelCombatTick(int32 NumSteps, int32 NumCombatants, int32 Seed)
+{
+	const FHLtC_MoveTable& MoveTable = FHLtC_AttackChainRegistry::Get().GetMoveTable();
+	FHLtC_CombatWorld Serial(MoveTable);
+	FHLtC_CombatWorld Parallel(MoveTable);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		Serial.Add(0);
+		Parallel.Add(0);
+	}
+
+	TArray<FHLtC_CombatInput> Inputs;
+	Inputs.SetNum(NumCombatants);
+
+	FRandomStream Random(Seed);
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		for (FHLtC_CombatInput& Input : Inputs)
+		{
+			const int32 Roll = Random.RandHelper(24); // Most steps have no input
+			Input.NumPresses = 0;
+			if (Roll < 4) { Input.AddPress(static_cast<uint8>(1 << Roll), static_cast<uint8>(Random.RandHelper(256))); }
+			if (Roll == 6) { Input.AddPress(HLtC::MakeDodgePress(static_cast<EHLtC_DodgeDirection>(Random.RandHelper(HLtC::NumDodgeDirections))), static_cast<uint8>(Random.RandHelper(256))); }
+			Input.Held ^= Roll == 4 ? HLtC::Input_Sprinting : Roll == 5 ? HLtC::Input_Moving : 0;
+		}
+
+		const float DeltaTime = Random.FRandRange(1.0f / 240.0f, 1.0f / 15.0f); // Anything from a fast step to a hitch
+		UHLtC_CombatSimulationSubsystem::StepWorld(Serial, Inputs.GetData(), DeltaTime, false);
+		UHLtC_CombatSimulationSubsystem::StepWorld(Parallel, Inputs.GetData(), DeltaTime, true);
+
+		if (!Serial.HasSameState(Parallel))
+		{
+			UE_LOG(LogTemplateCharacter, Error, TEXT("Parallel combat tick diverged from the serial tick on step %d (%d combatants, seed %d)."), Step, NumCombatants, Seed);
+			return false;
+		}
+	}
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("Parallel combat tick matched the serial tick for %d steps of %d combatants (seed %d)."), NumSteps, NumCombatants, Seed);
+	return true;
+}
+
+static FAutoConsoleCommand CmdHLtCCombatVerifyParallelTick(
+	TEXT("hltc.Combat.VerifyParallelTick"),
+	TEXT("Compares the serial and parallel combat tick over randomized input. Args: [Steps=10000] [Combatants=2048] [Seed=1]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		VerifyParallelCombatTick(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 10000, Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 2048, Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 1);
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHLtC_CombatParallelTickTest, "HLtC.Combat.ParallelTick", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHLtC_CombatParallelTickTest::RunTest(const FString& Parameters)
+{
+	// Enough combatants for several batches at the default batch size, over a few seeds
+	for (int32 Seed = 1; Seed <= 3; Seed++)
+	{
+		if (!TestTrue(FString::Printf(TEXT("Parallel tick matches the serial tick (seed %d)"), Seed), VerifyParallelCombatTick(2000, 1024, Seed)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+/**
+ * Repeatedly rolls a simulation back and resimulates it with the inputs it already had, failing if that doesn't land on the same state,
+ * or if any resimulation after the first allocates. Logs the average resimulation time
+ */
+static bool VerifyCombatRollback(int32 NumSteps, int32 NumCombatants, int32 NumRollbackFrames, int32 Seed)
+{
+	NumRollbackFrames = FMath::Max(NumRollbackFrames, 1);
+	const float FixedTimestep = 1.0f / 60.0f;
+
+	FHLtC_CombatWorld World(FHLtC_AttackChainRegistry::Get().GetMoveTable());
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		World.Add(0);
+	}
+	FHLtC_CombatWorld Expected = World;
+
+	FHLtC_RollbackBuffer Rollback;
+	Rollback.Init(NumRollbackFrames, NumCombatants);
+
+	TArray<FHLtC_CombatInput> Inputs;
+	Inputs.SetNum(NumCombatants);
+
+	FRandomStream Random(Seed);
+	double ResimulateSeconds = 0.0;
+	int32 NumResimulations = 0;
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		for (FHLtC_CombatInput& Input : Inputs)
+		{
+			const int32 Roll = Random.RandHelper(24); // Most steps have no input
+			Input.NumPresses = 0;
+			if (Roll < 4) { Input.AddPress(static_cast<uint8>(1 << Roll), static_cast<uint8>(Random.RandHelper(256))); }
+			if (Roll == 6) { Input.AddPress(HLtC::MakeDodgePress(static_cast<EHLtC_DodgeDirection>(Random.RandHelper(HLtC::NumDodgeDirections))), static_cast<uint8>(Random.RandHelper(256))); }
+			Input.Held ^= Roll == 4 ? HLtC::Input_Sprinting : Roll == 5 ? HLtC::Input_Moving : 0;
+		}
+
+		Rollback.SaveFrame(Step, World, Inputs.GetData(), FixedTimestep);
+		World.Step(Inputs.GetData(), FixedTimestep);
+
+		if (Step + 1 < NumRollbackFrames)
+		{
+			continue;
+		}
+
+		Expected = World;
+
+#if HLTC_COMBAT_COUNTERS
+		const uint32 AllocationsBefore = HLtC::GetCombatCounters().Values[HLtC::Counter_Allocations].load();
+#endif
+		const double StartTime = FPlatformTime::Seconds();
+		const int32 NumReplayed = Rollback.Resimulate(Step + 1 - NumRollbackFrames, World);
+		ResimulateSeconds += FPlatformTime::Seconds() - StartTime;
+		NumResimulations++;
+#if HLTC_COMBAT_COUNTERS
+		if (NumResimulations > 1 && HLtC::GetCombatCounters().Values[HLtC::Counter_Allocations].load() != AllocationsBefore) // The first may still grow the timer pool
+		{
+			UE_LOG(LogTemplateCharacter, Error, TEXT("Combat rollback allocated while resimulating on step %d (%d combatants, %d frames, seed %d)."), Step, NumCombatants, NumRollbackFrames, Seed);
+			return false;
+		}
+#endif
+
+		// Restoring marks every combatant changed, which isn't part of the state being compared
+		FMemory::Memzero(World.Changed.data(), World.Changed.size());
+		FMemory::Memzero(Expected.Changed.data(), Expected.Changed.size());
+
+		if (NumReplayed != NumRollbackFrames || !World.HasSameState(Expected))
+		{
+			UE_LOG(LogTemplateCharacter, Error, TEXT("Combat rollback diverged on step %d (%d combatants, %d frames, seed %d)."), Step, NumCombatants, NumRollbackFrames, Seed);
+			return false;
+		}
+	}
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("Combat rollback matched for %d resimulations of %d frames of %d combatants, %.3f ms each (seed %d)."),
+		NumResimulations, NumRollbackFrames, NumCombatants, NumResimulations > 0 ? ResimulateSeconds * 1000.0 / NumResimulations : 0.0, Seed);
+	return true;
+}
+
+static FAutoConsoleCommand CmdHLtCCombatVerifyRollback(
+	TEXT("hltc.Combat.VerifyRollback"),
+	TEXT("Checks that rolling the combat simulation back and resimulating it reproduces the same state without allocating. Args: [Steps=1000] [Combatants=64] [RollbackFrames=8] [Seed=1]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		VerifyCombatRollback(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 1000, Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 64,
+			Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 8, Args.IsValidIndex(3) ? FCString::Atoi(*Args[3]) : 1);
+	}));
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHLtC_CombatRollbackTest, "HLtC.Combat.Rollback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHLtC_CombatRollbackTest::RunTest(const FString& Parameters)
+{
+	return TestTrue(TEXT("Resimulating reproduces the same state without allocating"), VerifyCombatRollback(1000, 64, 8, 1));
+}
+#endif
+#endif
@@ -0,0 +1,180 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HLtC_CombatCore.h"
+#include "HLtC_CombatHits.h"
+#include "HLtC_CombatNet.h"
+#include "HLtC_CombatStateMachine.h"
+#include "HLtC_CombatValidation.h"
+#include "Tasks/Task.h"
+#include "HLtC_CombatSimulationSubsystem.generated.h"
+
+class AHLtC_CombatSystemCharacter;
+struct FHLtC_RootMotionSource_Dodge;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FHLtC_OnCombatEvent, AHLtC_CombatSystemCharacter*, const FHLtC_CombatEvent&);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FHLtC_OnInputVerdict, AHLtC_CombatSystemCharacter*, EHLtC_InputVerdict);
+
+/** How often a combatants actor and movement tick, picked by its significance */
+enum class EHLtC_TickBucket : uint8
+{
+	Full, // Every frame
+	Reduced, // Every hltc.Combat.ReducedTickInterval seconds
+	Dormant, // Not at all, until something wakes it
+};
+
+/** What one Tick of the simulation cost and did, for profiling tools */
+struct FHLtC_CombatFrameStats
+{
+	double TickSeconds = 0.0;
+	uint32 Counters[HLtC::Counter_Num] = {}; // Always 0 where HLTC_COMBAT_COUNTERS is off
+};
+
+/**
+ * Adapter between the combat characters of a world and an FHLtC_CombatWorld.
+ * Input is collected from the characters, the world is advanced in fixed steps, and results are only written back to the characters whose state changed.
+ */
+UCLASS()
+class UHLtC_CombatSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UTickableWorldSubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void RegisterCombatant(AHLtC_CombatSystemCharacter* Character); // Adds a character to the simulation and sets its CombatantIndex
+	void UnregisterCombatant(AHLtC_CombatSystemCharacter* Character); // Removes a character, moving the last combatant into its slot
+
+	// Input without a timestamp, for callers other than the characters own input events. Presses are consumed at the start of the next fixed step, held inputs are sampled by every step
+
+	void RequestAttack(int32 Index, EHLtC_AttackType Type);
+	void RequestDodge(int32 Index, EHLtC_DodgeDirection Direction);
+	void SetBlocking(int32 Index, bool bBlocking);
+	void SetSprinting(int32 Index, bool bSprinting);
+
+	/** Puts a combatant back on the full tick rate straight away and keeps it there for a while, e.g. when it gets input or is hit */
+	void WakeCombatant(int32 Index);
+
+	EHLtC_TickBucket GetTickBucket(int32 Index) const { return TickBuckets[Index]; }
+
+	// Blueprint state changes, applied and written back straight away
+
+	void SetControlState(int32 Index, EHLtC_ControlState NewState);
+	void SetCameraState(int32 Index, EHLtC_CameraState NewState);
+
+	float GetStaticActionDurationTimer(int32 Index) const { return World.GetStaticActionDurationTimer(Index); }
+	float GetAdditionalAttackBufferTiming(int32 Index) const { return World.AdditionalAttackBufferTiming[Index]; }
+	FHLtC_AttackCursor GetAttackCursor(int32 Index) const { return World.GetAttackCursor(Index); }
+	bool IsInvulnerable(int32 Index) const { return World.IsInvulnerable(Index); }
+
+	/** Fills a root motion source with the combatants dodge, started as far in as the dodge is including the frame time not yet stepped. False if it isn't dodging */
+	bool MakeDodgeRootMotion(int32 Index, FHLtC_RootMotionSource_Dodge& OutSource) const;
+	int32 Num() const { return World.Num(); }
+
+	const FHLtC_CombatFrameStats& GetLastFrameStats() const { return LastFrameStats; }
+
+	/** Every notification of every combatant, after its characters own delegate. For listeners following the whole fight, e.g. UI, without binding to each character */
+	FHLtC_OnCombatEvent OnCombatEvent;
+
+	// Input clock. Input events are stamped on it and steps are placed on it, so whoever drives it decides how input lines up with the steps
+
+	/** The platform clock, unless a replay has taken it over */
+	double GetInputClock() const { return InputClockOverride >= 0.0 ? InputClockOverride : FPlatformTime::Seconds(); }
+	void SetInputClockOverride(double Seconds) { InputClockOverride = Seconds; } // Negative hands the clock back to the platform
+	double GetLastTickClock() const { return LastTickClock; } // Input clock the last Tick placed its steps from
+
+	// State for replays. Restoring needs the same combatants, in the same order, as when the state was saved
+
+	const FHLtC_CombatWorld& GetCombatWorld() const { return World; }
+	AHLtC_CombatSystemCharacter* GetCharacter(int32 Index) const { return Characters[Index]; }
+	uint8 GetHeldInput(int32 Index) const { return PendingInputs[Index].Held; }
+	float GetStepAccumulator() const { return StepAccumulator; }
+
+	/** Restores every combatant and the step timing, drops queued input and writes the result back to the characters. Held holds Num() entries */
+	void RestoreState(const FHLtC_CombatantSnapshot* Snapshots, const uint8* Held, int64 Clock, uint32 Frame, float InStepAccumulator);
+
+	// Replication
+
+	/** The combatants state as the server replicates it, acknowledging InputAck inputs of its owner */
+	FHLtC_NetCombatState GetNetState(int32 Index, uint8 InputAck) const;
+
+	/** Takes on a replicated state, keeping the timer it came with. bCorrection counts it as a corrected prediction */
+	void ApplyNetState(int32 Index, const FHLtC_NetCombatState& State, bool bCorrection);
+
+	void MarkChanged(int32 Index) { World.Changed[Index] = 1; } // Writes the combatant back at the end of the next Tick, whether its state changes or not
+
+	/** Number of the next fixed step to run. Steps are numbered from 0 when the world starts */
+	uint32 GetCurrentFrame() const { return CurrentFrame; }
+
+	/**
+	 * Replaces the input a combatant stepped Frame with, e.g. a remote players input that arrived late, and resimulates every step since.
+	 * Needs hltc.Combat.RollbackFrames to cover Frame. Returns false if it doesn't, or if combatants joined or left since
+	 */
+	bool CorrectInput(uint32 Frame, int32 Index, const FHLtC_CombatInput& Input);
+
+	// Server validation. Clients send a claim of what each attack and block input did along with it. Claims are checked off the game thread against
+	// the timeline of the combatant, and the verdicts come back at the start of the next Tick
+
+	/** Queues a claim for the next batch, stamped with the input clock as its input is. Any thread. False if the queue is full and the claim was dropped */
+	bool SubmitInputClaim(FHLtC_InputClaim Claim);
+
+	/** Every claim found to be a desync or a cheat, once its verdict is in. Desyncs are corrected already, what a cheat costs is up to the listener */
+	FHLtC_OnInputVerdict OnInputRejected;
+
+	/** Advances a world by one step, splitting the combatants across worker threads if bParallel. Results are identical either way */
+	static void StepWorld(FHLtC_CombatWorld& InWorld, const FHLtC_CombatInput* Inputs, float DeltaTime, bool bParallel);
+
+private:
+	void WriteBack(int32 Index); // Copies the combatants state to its character. Game thread only
+	void UpdateSignificance(); // Sorts every combatant into a tick bucket by distance, visibility and combat involvement. Game thread only
+	void SetTickBucket(int32 Index, EHLtC_TickBucket Bucket); // Applies a bucket to the combatants actor and movement ticks, if it changed
+	void ResolveHits(); // Resolves the attacks started this frame against every combatant. The hits are sent by SendNotifications. Game thread only
+	void QueueEvent(AHLtC_CombatSystemCharacter* Character, EHLtC_CombatEvent Type); // Queues a notification carrying the characters current states
+	void SendNotifications(); // Sends the queued notifications, then the attacks started since the last call and the hits they landed. Game thread only
+	void DrainInputClaims(); // Moves the submitted claims into PendingClaims. Game thread only
+	void SyncValidation(double WorldTime); // Applies the verdicts of the last batch and starts the next one, from the world as it stands at WorldTime. Game thread only
+
+	FHLtC_CombatWorld World;
+	TArray<FHLtC_CombatInput> PendingInputs; // Input for the next step, one per combatant
+	TArray<AHLtC_CombatSystemCharacter*> Characters; // Character of each combatant
+	TArray<EHLtC_TickBucket> TickBuckets; // Tick bucket of each combatant
+	TArray<double> LastCombatTimes; // When each combatant last had input or was part of a hit, keeps it on the full tick rate for a while after
+
+	float SignificanceAccumulator = 0.0f; // Time since the tick buckets were last updated
+
+	float StepAccumulator = 0.0f; // Frame time not yet consumed by a fixed step
+	uint32 CurrentFrame = 0;
+
+	FHLtC_CombatFrameStats LastFrameStats;
+
+	double InputClockOverride = -1.0;
+	double LastTickClock = 0.0;
+
+	// Hits, resolved once a frame for every attack started by its steps
+	FHLtC_HitResolver HitResolver;
+	FHLtC_CombatantBounds HitBounds;
+	std::vector<FHLtC_Attack> PendingAttacks; // Attacks started since the last notifications, whether hits are batched or not
+	std::vector<FHLtC_HitEvent> Hits;
+	TArray<TPair<AHLtC_CombatSystemCharacter*, AHLtC_CombatSystemCharacter*>> HitCharacters; // Attacker and target of each hit
+
+	TArray<TPair<AHLtC_CombatSystemCharacter*, FHLtC_CombatEvent>> PendingEvents; // Sent after the apply phase, as listeners can destroy characters and reorder the combatants
+	TArray<TPair<AHLtC_CombatSystemCharacter*, FHLtC_CombatEvent>> SendingEvents; // The notifications being sent, kept so neither array reallocates
+	bool bSendingNotifications = false;
+
+	FHLtC_RollbackBuffer Rollback; // State and input of the most recent steps, only recorded while hltc.Combat.RollbackFrames is above 0
+
+	// Validation, one batch in flight at a time
+	FHLtC_InputClaimQueue ClaimQueue;
+	TArray<FHLtC_InputClaim> PendingClaims; // Drained but not checked yet
+	FHLtC_InputValidator Validator; // Owned by ValidationTask while it runs
+	TArray<TWeakObjectPtr<AHLtC_CombatSystemCharacter>> ValidatingCharacters; // Character of each claim of the batch in flight, as combatants can leave before its verdicts are in
+	UE::Tasks::FTask ValidationTask;
+};
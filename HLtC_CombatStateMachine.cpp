@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatStateMachine.h"
+
+namespace HLtC
+{
+	// Names are created once, so reading a state name from Blueprint never allocates
+
+	static const FName ControlStateNames[NumControlStates] = { TEXT("Slow"), TEXT("Action") };
+	static const FName PlayerActionNames[NumPlayerActions] = { TEXT("Idle"), TEXT("Moving"), TEXT("Sprinting"), TEXT("LightAttack"), TEXT("HeavyAttack"), TEXT("Dodge") };
+	static const FName DodgeNames[NumDodgeDirections] = { TEXT("DodgeForward"), TEXT("DodgeBackward"), TEXT("DodgeLeft"), TEXT("DodgeRight") };
+	static const FName CameraStateNames[NumCameraStates] = { TEXT("Free"), TEXT("Focus") };
+	static const FName AttackTypeNames[static_cast<int32>(EHLtC_AttackType::Count)] = { NAME_None, TEXT("Light"), TEXT("Heavy") };
+
+	FName GetStateName(EHLtC_ControlState State)
+	{
+		return ControlStateNames[static_cast<int32>(State)];
+	}
+
+	FName GetStateName(EHLtC_CameraState State)
+	{
+		return CameraStateNames[static_cast<int32>(State)];
+	}
+
+	FName GetStateName(EHLtC_AttackType Type)
+	{
+		return AttackTypeNames[static_cast<int32>(Type)];
+	}
+
+	FName GetActionName(EHLtC_PlayerAction Action, int32 AttackIndex)
+	{
+		if (Action == EHLtC_PlayerAction::Dodge) // Dodges are named by their direction
+		{
+			return DodgeNames[AttackIndex & (NumDodgeDirections - 1)];
+		}
+
+		const FName& BaseName = PlayerActionNames[static_cast<int32>(Action)];
+		return IsAttackAction(Action) ? FName(BaseName, NAME_EXTERNAL_TO_INTERNAL(AttackIndex)) : BaseName; // Numbered names print as "LightAttack_0", matching the old FString actions
+	}
+
+	bool ParseStateName(FName Name, EHLtC_ControlState& OutState)
+	{
+		for (int32 Index = 0; Index < NumControlStates; Index++)
+		{
+			if (ControlStateNames[Index] == Name)
+			{
+				OutState = static_cast<EHLtC_ControlState>(Index);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ParseStateName(FName Name, EHLtC_CameraState& OutState)
+	{
+		for (int32 Index = 0; Index < NumCameraStates; Index++)
+		{
+			if (CameraStateNames[Index] == Name)
+			{
+				OutState = static_cast<EHLtC_CameraState>(Index);
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+FHLtC_StateTransition FHLtC_CombatStateMachine::MakeTransition(EHLtC_PlayerAction NewAction, uint8 NewAttackIndex) const
+{
+	FHLtC_StateTransition Transition;
+	Transition.From = Action;
+	Transition.FromAttackIndex = AttackIndex;
+	Transition.To = NewAction;
+	Transition.ToAttackIndex = HLtC::IsAttackAction(NewAction) || NewAction == EHLtC_PlayerAction::Dodge ? NewAttackIndex : 0;
+	return Transition;
+}
@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HLtC_CombatCore.h"
+
+namespace HLtC
+{
+	// State names, exposed to Blueprint in place of the old FString states. Attack names carry the chain index as their number ("LightAttack_0")
+
+	FName GetStateName(EHLtC_ControlState State);
+	FName GetStateName(EHLtC_CameraState State);
+	FName GetStateName(EHLtC_AttackType Type);
+	FName GetActionName(EHLtC_PlayerAction Action, int32 AttackIndex);
+
+	bool ParseStateName(FName Name, EHLtC_ControlState& OutState);
+	bool ParseStateName(FName Name, EHLtC_CameraState& OutState);
+}
+
+/** A single transition made by FHLtC_CombatStateMachine, passed to the owners entry/exit hooks */
+struct FHLtC_StateTransition
+{
+	EHLtC_PlayerAction From = EHLtC_PlayerAction::Idle;
+	EHLtC_PlayerAction To = EHLtC_PlayerAction::Idle;
+	uint8 FromAttackIndex = 0;
+	uint8 ToAttackIndex = 0;
+
+	bool IsValid() const { return From != To || FromAttackIndex != ToAttackIndex; }
+};
+
+/** What a combat notification announces */
+enum class EHLtC_CombatEvent : uint8
+{
+	ActionChanged, // Action and AttackIndex hold the new action
+	AttackStarted, // AttackType and AttackIndex hold the move entered, sent for every move, including a chain restarting at the same index
+	HitWindowOpened, // The move entered is tested for hits. Moves hit on the step they start, so this follows AttackStarted straight away
+	ChainEnded, // The attack chain ran out, was interrupted (e.g. by a dodge) or restarted
+	BlockStarted,
+	BlockEnded,
+	ControlStateChanged, // ControlState holds the new state
+	CameraStateChanged, // CameraState holds the new state
+};
+
+/** A change of a combat characters states, sent once when the simulation writes it back instead of being polled for */
+struct FHLtC_CombatEvent
+{
+	EHLtC_CombatEvent Type = EHLtC_CombatEvent::ActionChanged;
+	EHLtC_PlayerAction Action = EHLtC_PlayerAction::Idle;
+	uint8 AttackIndex = 0;
+	EHLtC_AttackType AttackType = EHLtC_AttackType::None;
+	EHLtC_ControlState ControlState = EHLtC_ControlState::Slow;
+	EHLtC_CameraState CameraState = EHLtC_CameraState::Free;
+};
+
+/** Enum backed control, action and camera states of a combat character */
+struct FHLtC_CombatStateMachine
+{
+	EHLtC_ControlState ControlState = EHLtC_ControlState::Slow; // The players current control/movement state
+	EHLtC_PlayerAction Action = EHLtC_PlayerAction::Idle; // The players current action
+	uint8 AttackIndex = 0; // Chain index of the current action for attacks, the EHLtC_DodgeDirection for dodges
+	EHLtC_CameraState CameraState = EHLtC_CameraState::Free; // The cameras current control/movement state
+
+	/**
+	 * Builds the transition to a new action. Returns an invalid transition if nothing would change.
+	 * There's no transition table: the combat core decides which action can follow which from its buffer windows, static actions and move table links,
+	 * and replicated corrections and rollbacks can move a character between any two actions, so a table would have to allow every transition
+	 */
+	FHLtC_StateTransition MakeTransition(EHLtC_PlayerAction NewAction, uint8 NewAttackIndex = 0) const;
+
+	/** Moves to the target action of a transition made by MakeTransition */
+	void ApplyTransition(const FHLtC_StateTransition& Transition) { Action = Transition.To; AttackIndex = Transition.ToAttackIndex; }
+
+	FName GetActionName() const { return HLtC::GetActionName(Action, AttackIndex); }
+};
@@ -0,0 +1,49 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatStats.h"
+
+#include <algorithm>
+
+HLtC::FCombatCounters& HLtC::GetCombatCounters()
+{
+	static FCombatCounters Counters;
+	return Counters;
+}
+
+const char* HLtC::GetCounterName(ECombatCounter Counter)
+{
+	static const char* const Names[Counter_Num] = { "AttacksStarted", "AttacksBuffered", "AttacksDropped", "ChainResets", "ActionTransitions", "Allocations", "NetCorrections", "InputsValidated", "NetDesyncs", "CheatsDetected" };
+	return Counter < Counter_Num ? Names[Counter] : "";
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_Histogram
+
+void FHLtC_Histogram::Add(uint64_t Sample)
+{
+	int32_t Bucket = 0;
+	while (Bucket < NumBuckets - 1 && Sample >= GetBucketMin(Bucket + 1))
+	{
+		Bucket++;
+	}
+
+	Buckets[Bucket]++;
+	NumSamples++;
+	Sum += Sample;
+	Max = std::max(Max, Sample);
+}
+
+uint64_t FHLtC_Histogram::GetPercentile(double Fraction) const
+{
+	const uint64_t Target = static_cast<uint64_t>(Fraction * static_cast<double>(NumSamples));
+	uint64_t Seen = 0;
+	for (int32_t Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		Seen += Buckets[Bucket];
+		if (Seen > Target)
+		{
+			return Bucket + 1 < NumBuckets ? std::min(GetBucketMin(Bucket + 1), Max) : Max; // Upper edge of the bucket
+		}
+	}
+	return Max;
+}
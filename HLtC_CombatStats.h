@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Counters and histograms of what the combat core does. Engine independent, like the rest of the core.
+// Counters are compiled out unless HLTC_COMBAT_COUNTERS is 1, which it is by default everywhere but Unreal Shipping builds.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if !defined(HLTC_COMBAT_COUNTERS)
+	#if defined(UE_BUILD_SHIPPING) && UE_BUILD_SHIPPING
+		#define HLTC_COMBAT_COUNTERS 0
+	#else
+		#define HLTC_COMBAT_COUNTERS 1
+	#endif
+#endif
+
+namespace HLtC
+{
+	enum ECombatCounter : uint8_t
+	{
+		Counter_AttacksStarted, // Moves entered
+		Counter_AttacksBuffered, // Presses held back till the buffer window opens
+		Counter_AttacksDropped, // Presses that didn't lead anywhere, or didn't fit in the input queue
+		Counter_ChainResets, // Chains that ran out and returned the combatant to locomotion
+		Counter_ActionTransitions, // Changes of action of any kind
+		Counter_Allocations, // Times a core container had to grow
+		Counter_NetCorrections, // Replicated states that overrode what a client had predicted
+		Counter_InputsValidated, // Client input claims checked against the servers timeline
+		Counter_NetDesyncs, // Claims the rules allow, but not when their input arrived
+		Counter_CheatsDetected, // Claims the rules can't give, whenever their input arrived
+		Counter_Num
+	};
+
+	/** Running totals of every counter, safe to bump from any thread. Relaxed, as only the totals matter */
+	struct FCombatCounters
+	{
+		std::atomic<uint32_t> Values[Counter_Num] = {};
+
+		/** Copies the totals since the last call into OutValues and starts counting from 0 again */
+		void TakeFrame(uint32_t (&OutValues)[Counter_Num])
+		{
+			for (int32_t Counter = 0; Counter < Counter_Num; Counter++)
+			{
+				OutValues[Counter] = Values[Counter].exchange(0, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	FCombatCounters& GetCombatCounters();
+
+	const char* GetCounterName(ECombatCounter Counter);
+
+#if HLTC_COMBAT_COUNTERS
+	inline void IncrementCounter(ECombatCounter Counter, uint32_t Amount = 1) { GetCombatCounters().Values[Counter].fetch_add(Amount, std::memory_order_relaxed); }
+
+	/** Counts an allocation if Vector had to grow past Capacity, its capacity before it was added to */
+	template <typename T>
+	inline void CountGrowth(const std::vector<T>& Vector, size_t Capacity) { if (Vector.capacity() != Capacity) { IncrementCounter(Counter_Allocations); } }
+#else
+	inline void IncrementCounter(ECombatCounter, uint32_t = 1) {}
+
+	template <typename T>
+	inline void CountGrowth(const std::vector<T>&, size_t) {}
+#endif
+}
+
+/**
+ * Power of two histogram of non-negative samples: bucket 0 counts zeros, bucket i counts [2^(i-1), 2^i).
+ * Adding a sample is a few dozen instructions at most and there's nothing to allocate, so it's cheap enough to leave running on a live server.
+ */
+struct FHLtC_Histogram
+{
+	static constexpr int32_t NumBuckets = 33;
+
+	uint64_t Buckets[NumBuckets] = {};
+	uint64_t NumSamples = 0;
+	uint64_t Sum = 0;
+	uint64_t Max = 0;
+
+	void Add(uint64_t Sample);
+	void Reset() { *this = FHLtC_Histogram(); }
+
+	static uint64_t GetBucketMin(int32_t Bucket) { return Bucket == 0 ? 0 : uint64_t(1) << (Bucket - 1); }
+
+	/** Value below which Fraction of the samples fall, to the precision of the buckets */
+	uint64_t GetPercentile(double Fraction) const;
+};
@@ -0,0 +1,466 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Headless stress benchmark of the combat characters. Spawns scripted combatants into the current world, records what every frame costs and writes it out as JSON.
+// Meant to run unattended on a machine without a GPU, e.g.
+//   UnrealEditor <Project> /Engine/Maps/Entry -game -nullrhi -nosound -unattended -benchmark -fps=60 -ExecCmds="hltc.Combat.StressTest 200 3600 1 1"
+
+#include "HLtC_CombatSystemCharacter.h"
+#include "HLtC_CombatSimulationSubsystem.h"
+#include "HLtC_CombatBotSubsystem.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "InputActionValue.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+
+static int32 GHLtCCombatStressTestBots = 0;
+static FAutoConsoleVariableRef CVarHLtCCombatStressTestBots(
+	TEXT("hltc.Combat.StressTestBots"),
+	GHLtCCombatStressTestBots,
+	TEXT("Hands the combatants of the next stress test to the combat bots, paired off against each other, instead of running the input scripts."));
+
+/** Input pattern a scripted combatant repeats, covering the ways players load the combat code */
+enum class EHLtC_StressScript : uint8
+{
+	Wander, // Walks in a new direction every few seconds
+	Sprint, // Sprints in bursts
+	LightChain, // Runs through light attack chains, pressing inside the buffer window
+	HeavyChain, // Same with heavy attacks
+	BlockSpam, // Toggles block every few frames
+	Count
+};
+
+/** One scripted combatant, stepped once a frame */
+struct FHLtC_StressCombatant
+{
+	TWeakObjectPtr<AHLtC_CombatSystemCharacter> Character;
+	EHLtC_StressScript Script = EHLtC_StressScript::Wander;
+	FRandomStream Random;
+	FVector2D MoveInput = FVector2D::ZeroVector;
+	int32 NextMoveFrame = 0; // Frame the move direction changes on
+	int32 NextActionFrame = 0; // Frame of the next press or toggle
+	int32 PressesLeft = 0; // Presses left in the current chain
+	bool bHeld = false; // Sprint or block currently held
+
+	void Step(int32 Frame);
+};
+
+void FHLtC_StressCombatant::Step(int32 Frame)
+{
+	AHLtC_CombatSystemCharacter* Pawn = Character.Get();
+	if (Pawn == nullptr)
+	{
+		return;
+	}
+
+	if (Frame >= NextMoveFrame) // Everyone moves, scripts only differ in what they press on top
+	{
+		const float Angle = Random.FRandRange(0.0f, UE_TWO_PI);
+		MoveInput = Script == EHLtC_StressScript::BlockSpam ? FVector2D::ZeroVector : FVector2D(FMath::Cos(Angle), FMath::Sin(Angle));
+		NextMoveFrame = Frame + Random.RandRange(60, 240);
+	}
+	Pawn->SimulateInput(EHLtC_InputAction::Move, FInputActionValue(MoveInput));
+
+	if (Frame < NextActionFrame)
+	{
+		if (bHeld && Script == EHLtC_StressScript::Sprint) // Sprint triggers every frame it's held, like the bound action does
+		{
+			Pawn->SimulateInput(EHLtC_InputAction::Sprint, FInputActionValue(true));
+		}
+		return;
+	}
+
+	switch (Script)
+	{
+	case EHLtC_StressScript::Wander:
+		NextActionFrame = MAX_int32;
+		break;
+
+	case EHLtC_StressScript::Sprint:
+		bHeld = !bHeld;
+		Pawn->SimulateInput(EHLtC_InputAction::Sprint, FInputActionValue(bHeld));
+		NextActionFrame = Frame + Random.RandRange(30, 180);
+		break;
+
+	case EHLtC_StressScript::LightChain:
+	case EHLtC_StressScript::HeavyChain:
+		if (PressesLeft == 0) // Start a new chain after a pause
+		{
+			PressesLeft = Random.RandRange(2, 5);
+		}
+
+		Pawn->SimulateInput(Script == EHLtC_StressScript::LightChain ? EHLtC_InputAction::LightAttack : EHLtC_InputAction::HeavyAttack, FInputActionValue(true));
+		PressesLeft--;
+		NextActionFrame = Frame + (PressesLeft > 0 ? Random.RandRange(10, 30) : Random.RandRange(60, 120));
+		break;
+
+	case EHLtC_StressScript::BlockSpam:
+		bHeld = !bHeld;
+		Pawn->SimulateInput(EHLtC_InputAction::Block, FInputActionValue(bHeld));
+		NextActionFrame = Frame + Random.RandRange(4, 12);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/** What one frame of the stress test cost */
+struct FHLtC_StressFrame
+{
+	double FrameMs = 0.0; // Wall time since the previous frame, which is game thread time when nothing else is the bottleneck, as under -nullrhi
+	double ActorTickMs = 0.0; // Time spent ticking actors and components, which is where the characters cost lives
+	double CombatTickMs = 0.0; // Time spent in the combat simulation subsystem. Tickable objects tick after the actors, so this and the counters trail by a frame
+	uint64 UsedPhysicalBytes = 0;
+	uint32 Counters[HLtC::Counter_Num] = {};
+};
+
+/**
+ * Runs the stress test over the frames of a world, through the world's actor tick delegates.
+ * Only one runs at a time. Everything it spawned is destroyed once it has written its report.
+ */
+class FHLtC_CombatStressTest
+{
+public:
+	FHLtC_CombatStressTest(UWorld* InWorld, int32 InNumCombatants, int32 InNumFrames, int32 InSeed, bool bInQuit, const FString& InPath);
+	~FHLtC_CombatStressTest();
+
+	bool OnPreActorTick(UWorld* InWorld);
+	bool OnPostActorTick(UWorld* InWorld); // Returns true once the test is over
+
+private:
+	void Spawn();
+	void Finish();
+	FString MakeReport() const;
+
+	TWeakObjectPtr<UWorld> World;
+	int32 NumCombatants;
+	int32 NumFrames;
+	int32 Seed;
+	bool bQuit;
+	bool bBots; // Driven by the bot subsystem rather than the scripts
+	FString Path;
+
+	TArray<FHLtC_StressCombatant> Combatants;
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors; // Characters, their controllers and the floor, destroyed at the end
+
+	TArray<FHLtC_StressFrame> Frames;
+	int32 Frame = 0;
+	uint64 UsedPhysicalBeforeSpawn = 0;
+	uint64 PreActorTickCycles = 0;
+	uint64 LastFrameCycles = 0;
+
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle PostActorTickHandle;
+};
+
+static TUniquePtr<FHLtC_CombatStressTest> GHLtCCombatStressTest;
+
+FHLtC_CombatStressTest::FHLtC_CombatStressTest(UWorld* InWorld, int32 InNumCombatants, int32 InNumFrames, int32 InSeed, bool bInQuit, const FString& InPath)
+	: World(InWorld)
+	, NumCombatants(InNumCombatants)
+	, NumFrames(InNumFrames)
+	, Seed(InSeed)
+	, bQuit(bInQuit)
+	, bBots(GHLtCCombatStressTestBots != 0)
+	, Path(InPath)
+{
+	Frames.Reserve(NumFrames); // Recording mustn't allocate as it goes, or it shows up in what it records
+
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddLambda([](UWorld* InWorld, ELevelTick, float)
+	{
+		if (GHLtCCombatStressTest && !GHLtCCombatStressTest->OnPreActorTick(InWorld))
+		{
+			GHLtCCombatStressTest.Reset();
+		}
+	});
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddLambda([](UWorld* InWorld, ELevelTick, float)
+	{
+		if (GHLtCCombatStressTest && GHLtCCombatStressTest->OnPostActorTick(InWorld))
+		{
+			GHLtCCombatStressTest.Reset();
+		}
+	});
+
+	Spawn();
+}
+
+FHLtC_CombatStressTest::~FHLtC_CombatStressTest()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	for (const TWeakObjectPtr<AActor>& Actor : SpawnedActors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->Destroy();
+		}
+	}
+}
+
+void FHLtC_CombatStressTest::Spawn()
+{
+	UWorld* InWorld = World.Get();
+	UsedPhysicalBeforeSpawn = FPlatformMemory::GetStats().UsedPhysical;
+
+	// Uses the game mode's pawn when it's a combat character, as its Blueprint carries the mesh, animation and attack chains
+	TSubclassOf<AHLtC_CombatSystemCharacter> CharacterClass = AHLtC_CombatSystemCharacter::StaticClass();
+	if (const AGameModeBase* GameMode = InWorld->GetAuthGameMode())
+	{
+		if (GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(AHLtC_CombatSystemCharacter::StaticClass()))
+		{
+			CharacterClass = *GameMode->DefaultPawnClass;
+		}
+	}
+
+	// Characters are laid out on a grid around the origin, close enough together for their attacks to land
+	const float Spacing = 300.0f;
+	const int32 Columns = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCombatants))), 1);
+	const float HalfExtent = Columns * Spacing * 0.5f;
+
+	FHitResult Floor;
+	if (!InWorld->LineTraceSingleByChannel(Floor, FVector(0.0f, 0.0f, 1000.0f), FVector(0.0f, 0.0f, -1000.0f), ECC_WorldStatic)) // An empty map has nothing to stand on
+	{
+		if (AStaticMeshActor* FloorActor = InWorld->SpawnActor<AStaticMeshActor>(FVector(0.0f, 0.0f, -50.0f), FRotator::ZeroRotator))
+		{
+			FloorActor->GetStaticMeshComponent()->SetStaticMesh(LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube")));
+			FloorActor->SetActorScale3D(FVector((HalfExtent + 2000.0f) / 50.0f, (HalfExtent + 2000.0f) / 50.0f, 1.0f)); // The cube is 100 units wide
+			SpawnedActors.Add(FloorActor);
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	FRandomStream Random(Seed);
+	Combatants.Reserve(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; Index++)
+	{
+		const FVector Location((Index % Columns) * Spacing - HalfExtent, (Index / Columns) * Spacing - HalfExtent, 100.0f);
+		AHLtC_CombatSystemCharacter* Character = InWorld->SpawnActor<AHLtC_CombatSystemCharacter>(CharacterClass, Location, FRotator(0.0f, Random.FRandRange(0.0f, 360.0f), 0.0f), SpawnParameters);
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		Character->SpawnDefaultController(); // Movement input needs a controller
+		SpawnedActors.Add(Character);
+		SpawnedActors.Add(Character->GetController());
+
+		FHLtC_StressCombatant& Combatant = Combatants.AddDefaulted_GetRef();
+		Combatant.Character = Character;
+		Combatant.Script = static_cast<EHLtC_StressScript>(Index % static_cast<int32>(EHLtC_StressScript::Count)); // Every script gets an equal share
+		Combatant.Random.Initialize(Random.GetUnsignedInt()); // Each combatant draws from its own stream, so one script's choices don't shift another's
+		Combatant.NextActionFrame = Combatant.Random.RandRange(0, 60); // Staggered, so the presses don't all land on the same frame
+	}
+
+	UHLtC_CombatBotSubsystem* Bots = InWorld->GetSubsystem<UHLtC_CombatBotSubsystem>();
+	if (bBots && Bots)
+	{
+		for (int32 Index = 0; Index < Combatants.Num(); Index++) // Neighbours fight each other, the odd one out of an odd count fights its left neighbour
+		{
+			const int32 Opponent = (Index ^ 1) < Combatants.Num() ? Index ^ 1 : Index - 1;
+			Bots->AddBot(Combatants[Index].Character.Get(), Opponent >= 0 ? Combatants[Opponent].Character.Get() : nullptr);
+		}
+	}
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("Combat stress test spawned %d %s, running %d frames (seed %d)."), Combatants.Num(), *CharacterClass->GetName(), NumFrames, Seed);
+}
+
+bool FHLtC_CombatStressTest::OnPreActorTick(UWorld* InWorld)
+{
+	if (!World.IsValid()) // The world went away under the test
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("Combat stress test aborted after %d frames, its world was destroyed."), Frame);
+		return false;
+	}
+
+	if (InWorld == World.Get())
+	{
+		for (int32 Index = 0; Index < Combatants.Num() && !bBots; Index++) // Input arrives before the actors tick, as it would from the player controllers. Bots give theirs from the bot subsystem's tick instead
+		{
+			Combatants[Index].Step(Frame);
+		}
+		PreActorTickCycles = FPlatformTime::Cycles64();
+	}
+	return true;
+}
+
+bool FHLtC_CombatStressTest::OnPostActorTick(UWorld* InWorld)
+{
+	if (InWorld != World.Get() || PreActorTickCycles == 0)
+	{
+		return false;
+	}
+
+	const uint64 Now = FPlatformTime::Cycles64();
+	if (LastFrameCycles != 0) // The first frame has nothing to measure from, and pays for the spawning
+	{
+		FHLtC_StressFrame& Stats = Frames.AddDefaulted_GetRef();
+		Stats.FrameMs = FPlatformTime::ToMilliseconds64(Now - LastFrameCycles);
+		Stats.ActorTickMs = FPlatformTime::ToMilliseconds64(Now - PreActorTickCycles);
+		Stats.UsedPhysicalBytes = FPlatformMemory::GetStats().UsedPhysical;
+
+		if (const UHLtC_CombatSimulationSubsystem* CombatSimulation = InWorld->GetSubsystem<UHLtC_CombatSimulationSubsystem>())
+		{
+			const FHLtC_CombatFrameStats& CombatStats = CombatSimulation->GetLastFrameStats();
+			Stats.CombatTickMs = CombatStats.TickSeconds * 1000.0;
+			FMemory::Memcpy(Stats.Counters, CombatStats.Counters, sizeof(Stats.Counters));
+		}
+	}
+	LastFrameCycles = Now;
+
+	if (++Frame <= NumFrames)
+	{
+		return false;
+	}
+
+	Finish();
+	return true;
+}
+
+/** Mean, percentiles and max of one per-frame metric, as a JSON object */
+static FString MakeStressSummary(TArray<double> Values)
+{
+	if (Values.IsEmpty())
+	{
+		return TEXT("{}");
+	}
+
+	Values.Sort();
+	double Sum = 0.0;
+	for (double Value : Values)
+	{
+		Sum += Value;
+	}
+
+	const auto Percentile = [&Values](double Fraction) { return Values[FMath::Min(static_cast<int32>(Fraction * Values.Num()), Values.Num() - 1)]; };
+	return FString::Printf(TEXT("{ \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }"),
+		Sum / Values.Num(), Percentile(0.5), Percentile(0.95), Percentile(0.99), Values.Last());
+}
+
+FString FHLtC_CombatStressTest::MakeReport() const
+{
+	const int32 NumCharacters = FMath::Max(Combatants.Num(), 1);
+
+	TArray<double> FrameMs;
+	TArray<double> ActorTickMs;
+	TArray<double> CombatTickMs;
+	TArray<double> TickUsPerCharacter;
+	uint64 CounterTotals[HLtC::Counter_Num] = {};
+	for (const FHLtC_StressFrame& Stats : Frames)
+	{
+		FrameMs.Add(Stats.FrameMs);
+		ActorTickMs.Add(Stats.ActorTickMs);
+		CombatTickMs.Add(Stats.CombatTickMs);
+		TickUsPerCharacter.Add((Stats.ActorTickMs + Stats.CombatTickMs) * 1000.0 / NumCharacters);
+		for (int32 Counter = 0; Counter < HLtC::Counter_Num; Counter++)
+		{
+			CounterTotals[Counter] += Stats.Counters[Counter];
+		}
+	}
+
+	const uint64 UsedPhysicalAfterSpawn = Frames.IsEmpty() ? UsedPhysicalBeforeSpawn : Frames[0].UsedPhysicalBytes;
+	const uint64 UsedPhysicalAtEnd = Frames.IsEmpty() ? UsedPhysicalBeforeSpawn : Frames.Last().UsedPhysicalBytes;
+
+	FString Json = TEXT("{\n");
+	Json += FString::Printf(TEXT("\t\"combatants\": %d,\n\t\"frames\": %d,\n\t\"seed\": %d,\n"), Combatants.Num(), Frames.Num(), Seed);
+	Json += FString::Printf(TEXT("\t\"parallel_tick\": %d,\n\t\"tick_lod\": %d,\n"),
+		IConsoleManager::Get().FindConsoleVariable(TEXT("hltc.Combat.ParallelTick"))->GetInt(), IConsoleManager::Get().FindConsoleVariable(TEXT("hltc.Combat.TickLOD"))->GetInt());
+	if (bBots)
+	{
+		const UWorld* InWorld = World.Get();
+		const UHLtC_CombatBotSubsystem* Bots = InWorld ? InWorld->GetSubsystem<UHLtC_CombatBotSubsystem>() : nullptr;
+		Json += FString::Printf(TEXT("\t\"bots\": %d,\n\t\"bot_decision_interval\": %d,\n"), Bots ? Bots->Num() : 0, Bots ? Bots->GetDecisionInterval() : 0);
+	}
+	Json += FString::Printf(TEXT("\t\"frame_ms\": %s,\n"), *MakeStressSummary(FrameMs));
+	Json += FString::Printf(TEXT("\t\"actor_tick_ms\": %s,\n"), *MakeStressSummary(ActorTickMs));
+	Json += FString::Printf(TEXT("\t\"combat_tick_ms\": %s,\n"), *MakeStressSummary(CombatTickMs));
+	Json += FString::Printf(TEXT("\t\"tick_us_per_character\": %s,\n"), *MakeStressSummary(TickUsPerCharacter));
+	Json += FString::Printf(TEXT("\t\"memory_bytes_per_character\": %lld,\n"), (static_cast<int64>(UsedPhysicalAfterSpawn) - static_cast<int64>(UsedPhysicalBeforeSpawn)) / NumCharacters);
+	Json += FString::Printf(TEXT("\t\"memory_growth_bytes\": %lld,\n"), static_cast<int64>(UsedPhysicalAtEnd) - static_cast<int64>(UsedPhysicalAfterSpawn));
+
+	Json += TEXT("\t\"counters\": {");
+	for (int32 Counter = 0; Counter < HLtC::Counter_Num; Counter++)
+	{
+		Json += FString::Printf(TEXT("%s \"%s\": %llu"), Counter == 0 ? TEXT("") : TEXT(","), ANSI_TO_TCHAR(HLtC::GetCounterName(static_cast<HLtC::ECombatCounter>(Counter))), CounterTotals[Counter]);
+	}
+	Json += TEXT(" },\n");
+
+	// Every frame, as columns, so regressions can be lined up against each other frame by frame
+	Json += TEXT("\t\"per_frame\": {\n");
+	const auto AppendColumn = [this, &Json](const TCHAR* Name, TFunctionRef<FString(const FHLtC_StressFrame&)> Format, bool bLast)
+	{
+		Json += FString::Printf(TEXT("\t\t\"%s\": ["), Name);
+		for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); FrameIndex++)
+		{
+			Json += (FrameIndex == 0 ? TEXT("") : TEXT(",")) + Format(Frames[FrameIndex]);
+		}
+		Json += bLast ? TEXT("]\n") : TEXT("],\n");
+	};
+	AppendColumn(TEXT("frame_ms"), [](const FHLtC_StressFrame& Stats) { return FString::Printf(TEXT("%.4f"), Stats.FrameMs); }, false);
+	AppendColumn(TEXT("actor_tick_ms"), [](const FHLtC_StressFrame& Stats) { return FString::Printf(TEXT("%.4f"), Stats.ActorTickMs); }, false);
+	AppendColumn(TEXT("combat_tick_ms"), [](const FHLtC_StressFrame& Stats) { return FString::Printf(TEXT("%.4f"), Stats.CombatTickMs); }, false);
+	AppendColumn(TEXT("allocations"), [](const FHLtC_StressFrame& Stats) { return FString::Printf(TEXT("%u"), Stats.Counters[HLtC::Counter_Allocations]); }, false);
+	AppendColumn(TEXT("used_physical_bytes"), [](const FHLtC_StressFrame& Stats) { return FString::Printf(TEXT("%llu"), Stats.UsedPhysicalBytes); }, true);
+	Json += TEXT("\t}\n}\n");
+	return Json;
+}
+
+void FHLtC_CombatStressTest::Finish()
+{
+	const FString Report = MakeReport();
+	if (FFileHelper::SaveStringToFile(Report, *Path))
+	{
+		UE_LOG(LogTemplateCharacter, Display, TEXT("Combat stress test finished, wrote '%s'."), *Path);
+	}
+
+	else
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("Combat stress test finished, but couldn't write '%s'."), *Path);
+	}
+
+	if (bQuit)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+static void StartCombatStressTest(const TArray<FString>& Args, UWorld* World)
+{
+	if (World == nullptr || !World->IsGameWorld())
+	{
+		UE_LOG(LogTemplateCharacter, Error, TEXT("hltc.Combat.StressTest needs a game world."));
+		return;
+	}
+
+	if (GHLtCCombatStressTest)
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("A combat stress test is already running."));
+		return;
+	}
+
+	const int32 NumCombatants = FMath::Max(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 100, 1);
+	const int32 NumFrames = FMath::Max(Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 3600, 1);
+	const int32 Seed = Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 1;
+	const bool bQuit = Args.IsValidIndex(3) && FCString::Atoi(*Args[3]) != 0;
+	const FString Path = Args.IsValidIndex(4) ? Args[4] : FPaths::ProfilingDir() / FString::Printf(TEXT("HLtCCombatStress-%s.json"), *FDateTime::Now().ToString());
+
+	GHLtCCombatStressTest = MakeUnique<FHLtC_CombatStressTest>(World, NumCombatants, NumFrames, Seed, bQuit, Path);
+}
+
+static FAutoConsoleCommand CmdHLtCCombatStressTest(
+	TEXT("hltc.Combat.StressTest"),
+	TEXT("Spawns scripted combat characters, records the cost of every frame and writes it to a JSON file. Args: [Combatants=100] [Frames=3600] [Seed=1] [QuitWhenDone=0] [Path=Saved/Profiling/HLtCCombatStress-<time>.json]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartCombatStressTest));
+
+#endif
@@ -3,16 +3,33 @@
 #include "HLtC_CombatSystemCharacter.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
+#include "Misc/AutomationTest.h"
+#include "Net/UnrealNetwork.h"
+#include "HLtC_CombatSimulationSubsystem.h"
+#include "HLtC_CombatReplaySubsystem.h"
+#include "HLtC_LockOnSubsystem.h"
+#include "HLtC_CameraRigComponent.h"
+#include "HLtC_CombatTrace.h"
+#include "HLtC_DodgeRootMotionSource.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
+static int32 GHLtCCombatMaxServerInputsPerFrame = 8;
+static FAutoConsoleVariableRef CVarHLtCCombatMaxServerInputsPerFrame(
+	TEXT("hltc.Combat.MaxServerInputsPerFrame"),
+	GHLtCCombatMaxServerInputsPerFrame,
+	TEXT("Combat inputs the server takes from a client per frame. The rest are acknowledged and dropped, so a flooding client can't fill the input queue."));
+
 //////////////////////////////////////////////////////////////////////////
 // AHLtC_CombatSystemCharacter
 
@@ -59,16 +76,55 @@ void AHLtC_CombatSystemCharacter::BeginPlay()
 	// Call the base class  
 	Super::BeginPlay();
 
-	PlayerControlState = "Slow";
-	PlayerAction = "Idle";
-	CameraState = "Free";
+	Hot = FHLtC_CharacterHotState();
+	MirrorStates();
+
+	CombatSimulation = GetWorld()->GetSubsystem<UHLtC_CombatSimulationSubsystem>();
+	Replay = GetWorld()->GetSubsystem<UHLtC_CombatReplaySubsystem>();
+	if (CombatSimulation)
+	{
+		CombatSimulation->RegisterCombatant(this); // The simulation advances the characters timers and states from now on
+
+		if (!HasAuthority())
+		{
+			OnRep_NetCombatState(); // The first replicated state can arrive before the character registers
+		}
+	}
+
+	LockOn = GetWorld()->GetSubsystem<UHLtC_LockOnSubsystem>();
+	if (LockOn && bTargetable)
+	{
+		LockOn->RegisterTarget(this);
+	}
+}
+
+void AHLtC_CombatSystemCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (LockOn)
+	{
+		LockOn->UnregisterTarget(this);
+		LockOn = nullptr;
+	}
+	LockOnTarget = nullptr;
+
+	if (CombatSimulation)
+	{
+		CombatSimulation->UnregisterCombatant(this);
+		CombatSimulation = nullptr;
+	}
+	Replay = nullptr;
 
-	isSprinting = false;
+	Super::EndPlay(EndPlayReason);
 }
 
 void AHLtC_CombatSystemCharacter::Tick(float DeltaTime)
 {
-	SetControlStateDefaults(DeltaTime); // Checks values every frame
+	if (AttackMechanicsTrigger && AttackMechanicsTriggerFrame != GFrameCounter) // A single frame pulse, which Blueprint can no longer reset itself
+	{
+		AttackMechanicsTrigger = false;
+	}
+
+	UpdateLockOn(DeltaTime); // The combat states are advanced by the combat simulation, the camera by its rig and dodges by the movement component, only the lock-on is left here
 	Super::Tick(DeltaTime);
 }
 
@@ -107,6 +163,13 @@ void AHLtC_CombatSystemCharacter::SetupPlayerInputComponent(UInputComponent* Pla
 		// Blocking
 		EnhancedInputComponent->BindAction(BlockAction, ETriggerEvent::Started, this, &AHLtC_CombatSystemCharacter::Block);
 		EnhancedInputComponent->BindAction(BlockAction, ETriggerEvent::Completed, this, &AHLtC_CombatSystemCharacter::Block);
+
+		// Dodging
+		EnhancedInputComponent->BindAction(DodgeAction, ETriggerEvent::Started, this, &AHLtC_CombatSystemCharacter::Dodge);
+
+		// Lock-on
+		EnhancedInputComponent->BindAction(LockOnCheckAction, ETriggerEvent::Started, this, &AHLtC_CombatSystemCharacter::LockOnCheck);
+		EnhancedInputComponent->BindAction(LockOnSwitchAction, ETriggerEvent::Started, this, &AHLtC_CombatSystemCharacter::LockOnSwitch);
 	}
 	else
 	{
@@ -114,136 +177,235 @@ void AHLtC_CombatSystemCharacter::SetupPlayerInputComponent(UInputComponent* Pla
 	}
 }
 
-void AHLtC_CombatSystemCharacter::SetControlStateDefaults(float DeltaTime) // Sets the default values associated with each control, action and camera state every frame
+void AHLtC_CombatSystemCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	UpdateCameraRig();
+}
+
+void AHLtC_CombatSystemCharacter::UpdateCameraRig()
 {
-	if (!StaticAction) // If the player isn't performing a static action (e.g. an attack)...
+	const bool bNeedsCamera = IsLocallyControlled() && !IsRunningDedicatedServer();
+	CameraBoom->SetComponentTickEnabled(bNeedsCamera); // Nobody sees the camera of a remote or AI pawn, so its boom doesn't need to chase it either
+
+	if (bNeedsCamera && CameraRig == nullptr)
 	{
-		if (GetCharacterMovement()->Velocity == FVector(0.0f, 0.0f, 0.0f)) // If the player is standing still...
-		{
-			PlayerAction = "Idle";
-		}
-	
-		else // If the player isn't standing still...
-		{
-			if (isSprinting) // If the player is sprinting...
-			{
-				PlayerAction = "Sprinting";
-			}
-
-			else // If the player isn't sprinting...
-			{
-				PlayerAction = "Moving";
-			}
-		}
-	
-		if (PlayerControlState == "Slow") // If the control state is "Slow"...
-		{
-			GetCharacterMovement()->MaxWalkSpeed = MoveSpeed_Slow; // Set the players move speed to the associated variable
-			DesiredBoomSocketOffset = BoomSocketOffset_Slow; // Set the target boom offset to the associated variable
-			CamShakeTiming = 0; // Reset CamShakeTiming
-			
-			if (PlayerAction == "Idle") { // If the player is standing still...
-				DesiredArmLength = ArmLengths_Slow[0]; // Set the target boom offset to the associated variable
-			}
-		
-			else if (PlayerAction == "Moving") { // If the player is moving...
-				DesiredArmLength = ArmLengths_Slow[1]; // Set the target boom offset to the associated variable
-			}
-		
-			else if (PlayerAction == "Sprinting") { // If the player is sprinting...
-				DesiredArmLength = ArmLengths_Slow[2]; // Set the target boom offset to the associated variable
-			}
-		}
-	
-		else if (PlayerControlState == "Action") // If the control state is "Action"...
-		{
-			GetCharacterMovement()->MaxWalkSpeed = MoveSpeed_Action; // Set the players move speed to the associated variable
-
-			if (CameraState == "Focus") // If the player is locked onto an enemy...
-			{
-				DesiredArmLength = ArmLengths_Action[1]; // Set the target boom length and offset to the associated variables
-				DesiredBoomSocketOffset = BoomSocketOffset_Action[1];
-			}
-
-			else // If the player isn't locked onto an enemy...
-			{
-				DesiredArmLength = ArmLengths_Action[0]; // Set the target boom length and offset to the associated variables
-				DesiredBoomSocketOffset = BoomSocketOffset_Action[0];
-			}
-		}
+		CameraRig = NewObject<UHLtC_CameraRigComponent>(this, TEXT("CameraRig"));
+		CameraRig->SetBoom(CameraBoom);
+		CameraRig->SetTuning(Tuning);
+		CameraRig->RegisterComponent();
+
+		Hot.AppliedStateDefaultsKey = MAX_uint32; // Hand the rig the current targets
+		ApplyStateDefaults();
+		CameraRig->SetHeld(Hot.bStaticAction);
+	}
 
-		if (isSprinting) { GetCharacterMovement()->MaxWalkSpeed += SprintSpeedAddition; } // If the player is sprinting, add the additional speed mod to the move speed
+	else if (!bNeedsCamera && CameraRig != nullptr)
+	{
+		CameraRig->DestroyComponent();
+		CameraRig = nullptr;
+	}
+}
 
-		CameraBoom->TargetArmLength = FMath::Lerp(CameraBoom->TargetArmLength, DesiredArmLength, DeltaTime * 2.5f); // Set the boom length to a value interpolated between its current and desired length
+void AHLtC_CombatSystemCharacter::SetPlayerAction(EHLtC_PlayerAction NewAction, uint8 NewAttackIndex)
+{
+	const FHLtC_StateTransition Transition = Hot.States.MakeTransition(NewAction, NewAttackIndex);
 
-		if (PlayerControlState == "Action" && CameraState == "Free") // If the control state is "Action" and the camera is open to player input...
-		{
-			float newCamShakeTiming = 0; // Define new value for later addition
-			if (PlayerAction == "Moving") { newCamShakeTiming = DeltaTime / CamShakeDeltaTimeDivision[0]; } // If player is moving, set newCamShakeTiming to the DeltaTime divided by the associated index in CamShakeDeltaTimeDivision
-			if (PlayerAction == "Sprinting") { newCamShakeTiming = DeltaTime / CamShakeDeltaTimeDivision[1]; } // If player is sprinting, set newCamShakeTiming to the DeltaTime divided by the associated index in CamShakeDeltaTimeDivision
+	if (Transition.IsValid()) // Hooks only run when the action actually changes
+	{
+		OnExitAction(Transition);
+		Hot.States.ApplyTransition(Transition);
+		OnEnterAction(Transition);
+	}
+}
+
+void AHLtC_CombatSystemCharacter::OnExitAction(const FHLtC_StateTransition& Transition)
+{
+	if (Transition.From == EHLtC_PlayerAction::Dodge && Hot.DodgeRootMotionID != 0) // Cancelled or finished, the rest of the root motion isn't wanted
+	{
+		GetCharacterMovement()->RemoveRootMotionSourceByID(Hot.DodgeRootMotionID);
+		Hot.DodgeRootMotionID = 0;
+	}
+}
 
-			if (!CamShakeRising) { newCamShakeTiming *= -1;} // If the camera should be dropping in the shake, invert newCamShakeTiming
+void AHLtC_CombatSystemCharacter::OnEnterAction(const FHLtC_StateTransition& Transition)
+{
+	if (Transition.To == EHLtC_PlayerAction::Dodge)
+	{
+		StartDodgeRootMotion();
+	}
+}
 
-			CamShakeTiming += newCamShakeTiming;
+void AHLtC_CombatSystemCharacter::NotifyCombatEvent(const FHLtC_CombatEvent& Event)
+{
+	MirrorStates(); // Before the delegates, so listeners reading the properties see the change
 
-			if (CamShakeTiming >= CamShakeTimingConstraint) { CamShakeTiming = CamShakeTimingConstraint; CamShakeRising = false; } // If CamShakeTiming is greater or equal to CamShakeTimingConstraint, set CamShakeTiming to CamShakeTimingConstraint and signal that the camera should drop
-			if (CamShakeTiming <= -CamShakeTimingConstraint) { CamShakeTiming = -CamShakeTimingConstraint; CamShakeRising = true; } // If CamShakeTiming is less or equal to negative CamShakeTimingConstraint, set CamShakeTiming to negative CamShakeTimingConstraint and signal that the camera should rise
+	if (Event.Type == EHLtC_CombatEvent::HitWindowOpened)
+	{
+		AttackMechanicsTrigger = true;
+		AttackMechanicsTriggerFrame = GFrameCounter;
+	}
 
-			FVector ShakenBoomSocketOffset = DesiredBoomSocketOffset;
-			
-			if (PlayerAction == "Moving" || PlayerAction == "Sprinting") { ShakenBoomSocketOffset += FVector(0,0,1); } // If the player is moving or sprinting, offset the vector
+	switch (Event.Type)
+	{
+	case EHLtC_CombatEvent::ActionChanged: OnActionChanged.Broadcast(HLtC::GetActionName(Event.Action, Event.AttackIndex)); break;
+	case EHLtC_CombatEvent::AttackStarted: OnAttackStarted.Broadcast(HLtC::GetStateName(Event.AttackType), Event.AttackIndex); break;
+	case EHLtC_CombatEvent::HitWindowOpened: OnHitWindowOpened.Broadcast(HLtC::GetStateName(Event.AttackType), Event.AttackIndex); break;
+	case EHLtC_CombatEvent::ChainEnded: OnChainEnded.Broadcast(); break;
+	case EHLtC_CombatEvent::BlockStarted: OnBlockingChanged.Broadcast(true); break;
+	case EHLtC_CombatEvent::BlockEnded: OnBlockingChanged.Broadcast(false); break;
+	case EHLtC_CombatEvent::ControlStateChanged: OnControlStateChanged.Broadcast(HLtC::GetStateName(Event.ControlState)); break;
+	case EHLtC_CombatEvent::CameraStateChanged: OnCameraStateChanged.Broadcast(HLtC::GetStateName(Event.CameraState)); break;
+	default: break;
+	}
+}
 
-			if (ShakenBoomSocketOffset != DesiredBoomSocketOffset) // If the shaken offset is different from the desired offset...
-			{
-				DesiredBoomSocketOffset = FMath::Lerp(ShakenBoomSocketOffset, -ShakenBoomSocketOffset, CamShakeTiming); // Set the desired offset to an interpolated vector between the shaken offset and the negative shaken offset, based on CamShakeTiming
-			}
+void AHLtC_CombatSystemCharacter::MirrorStates()
+{
+	// Called with the notifications rather than every frame, so the string copies stay cheap
+	PlayerControlState = GetPlayerControlState().ToString();
+	PlayerAction = GetPlayerAction().ToString();
+	CameraState = GetCameraState().ToString();
+	CurrentAttackType = Hot.CurrentAttackType != EHLtC_AttackType::None ? GetCurrentAttackType().ToString() : FString(); // Empty without an attack, like the old variable
+	StaticAction = Hot.bStaticAction;
+	Blocking = Hot.bBlocking;
+}
 
-			else // If the player isn't moving or sprinting...
-			{
-				CamShakeTiming = 0;
-			}
-		}
-		
-		CameraBoom->SocketOffset = FMath::Lerp(CameraBoom->SocketOffset, DesiredBoomSocketOffset, DeltaTime * 10.0f); // Set the camera offset to an interpolated vector between its current and desired location
+void AHLtC_CombatSystemCharacter::ApplyStateDefaults()
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_ApplyStateDefaults);
+
+	const uint32 Key = static_cast<uint32>(Hot.States.ControlState)
+		| static_cast<uint32>(Hot.States.Action) << 8
+		| static_cast<uint32>(Hot.States.CameraState) << 16
+		| static_cast<uint32>(Hot.bSprinting) << 24;
+
+	if (Key == Hot.AppliedStateDefaultsKey) // Nothing to do if the states haven't changed since last frame
+	{
+		return;
 	}
+	Hot.AppliedStateDefaultsKey = Key;
+
+	const UHLtC_CombatTuningAsset& Tune = GetTuning();
+	const FHLtC_StateDefaults& Defaults = Tune.GetStateDefaults(Hot.States);
 
-	else // If the player is performing a static action (e.g. an attack)
+	GetCharacterMovement()->MaxWalkSpeed = Defaults.MoveSpeed; // Set the players move speed to the associated value
+	if (Hot.bSprinting) { GetCharacterMovement()->MaxWalkSpeed += Tune.SprintSpeedAddition; } // If the player is sprinting, add the additional speed mod to the move speed
+
+	if (CameraRig) // Set the target boom length and offset to the associated values. Only "Action" with a free camera shakes while moving
 	{
-		StaticActionDurationTimer -= DeltaTime; // Countdown of the action duration
+		const bool bShakes = Hot.States.ControlState == EHLtC_ControlState::Action && Hot.States.CameraState == EHLtC_CameraState::Free;
+		const int32 ShakeSpeed = !bShakes ? INDEX_NONE
+			: Hot.States.Action == EHLtC_PlayerAction::Moving ? 0
+			: Hot.States.Action == EHLtC_PlayerAction::Sprinting ? 1
+			: INDEX_NONE;
+		CameraRig->SetTargets(Defaults.ArmLength, Defaults.SocketOffset, ShakeSpeed);
+	}
+}
 
-		if (StaticActionDurationTimer <= 0.0f) // If the timer is less than or equal to 0...
-		{
-			// Set variables ready for the player to move freely again
-			StaticAction = false;
-			StaticActionDurationTimer = 0.0f;
-			LightAttackIndex = 0;
-			HeavyAttackIndex = 0;
-
-			AdditionalAttackBufferTiming = 0.0f;
-			AdditionalAttackBuffer = false;
-		}
+bool AHLtC_CombatSystemCharacter::SetPlayerControlState(FName NewState)
+{
+	EHLtC_ControlState State;
+	if (!HLtC::ParseStateName(NewState, State))
+	{
+		return false;
+	}
 
-		else if (StaticActionDurationTimer <= AdditionalAttackBufferTiming && AdditionalAttackBuffer) // If the remaining action duration is less than the current AdditionalAttackBufferTiming, and an additional attack has been buffered...
-		{
-			if (CurrentAttackType == "Light") // If the prior attack was "Light"...
-			{
-				LightAttack(false); // Trigger an additional light attack
-			}
-
-			else if (CurrentAttackType == "Heavy") // If the prior attack was "Heavy"...
-			{
-				HeavyAttack(false); // Trigger an additional heavy attack
-			}
-		}
+	ApplyControlState(State);
+
+	if (GetLocalRole() == ROLE_AutonomousProxy) // Predicted here, replicated from the server like the rest of the combat state
+	{
+		ServerSetPlayerControlState(static_cast<uint8>(State));
+		Hot.SentInputs++;
 	}
+	return true;
+}
+
+bool AHLtC_CombatSystemCharacter::SetCameraState(FName NewState)
+{
+	EHLtC_CameraState State;
+	if (!HLtC::ParseStateName(NewState, State))
+	{
+		return false;
+	}
+
+	ApplyCameraState(State);
+	return true;
+}
+
+void AHLtC_CombatSystemCharacter::ApplyControlState(EHLtC_ControlState State)
+{
+	if (CombatSimulation && Hot.CombatantIndex != INDEX_NONE) // The simulation writes it back and announces the change
+	{
+		CombatSimulation->SetControlState(Hot.CombatantIndex, State);
+	}
+
+	else
+	{
+		Hot.States.ControlState = State;
+		MirrorStates();
+	}
+}
+
+void AHLtC_CombatSystemCharacter::ApplyCameraState(EHLtC_CameraState State)
+{
+	if (CombatSimulation && Hot.CombatantIndex != INDEX_NONE) // The simulation writes it back and announces the change
+	{
+		CombatSimulation->SetCameraState(Hot.CombatantIndex, State);
+	}
+
+	else
+	{
+		Hot.States.CameraState = State;
+		MirrorStates();
+	}
+}
+
+float AHLtC_CombatSystemCharacter::GetStaticActionDurationTimer() const
+{
+	return CombatSimulation ? CombatSimulation->GetStaticActionDurationTimer(Hot.CombatantIndex) : 0.0f;
+}
+
+void AHLtC_CombatSystemCharacter::SimulateInput(EHLtC_InputAction Action, const FInputActionValue& Value)
+{
+	switch (Action)
+	{
+	case EHLtC_InputAction::Move: Move(Value); break;
+	case EHLtC_InputAction::Look: Look(Value); break;
+	case EHLtC_InputAction::Sprint: SprintingFlag(Value); break;
+	case EHLtC_InputAction::LightAttack: LightAttack(Value); break;
+	case EHLtC_InputAction::HeavyAttack: HeavyAttack(Value); break;
+	case EHLtC_InputAction::Block: Block(Value); break;
+	case EHLtC_InputAction::Dodge: Dodge(Value); break;
+	default: break;
+	}
+}
+
+bool AHLtC_CombatSystemCharacter::AcceptInput(EHLtC_InputAction Action, const FInputActionValue& Value)
+{
+	return !Replay || Replay->FilterInput(this, Action, Value);
 }
 
 void AHLtC_CombatSystemCharacter::Move(const FInputActionValue& Value)
 {
+	if (!AcceptInput(EHLtC_InputAction::Move, Value))
+	{
+		return;
+	}
+
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
+	Hot.LastMoveInput = FVector2f(MovementVector);
+	Hot.LastMoveInputFrame = static_cast<uint32>(GFrameCounter);
 
-	if (Controller != nullptr && !StaticAction)
+	// A dormant combatants movement doesn't tick, so stick input has to wake it. Reduced combatants still move, and moving keeps them from going dormant
+	if (CombatSimulation && Hot.CombatantIndex != INDEX_NONE && !MovementVector.IsZero() && CombatSimulation->GetTickBucket(Hot.CombatantIndex) == EHLtC_TickBucket::Dormant)
+	{
+		CombatSimulation->WakeCombatant(Hot.CombatantIndex);
+	}
+
+	if (Controller != nullptr && !Hot.bStaticAction)
 	{
 		// find out which way is forward
 		const FRotator Rotation = Controller->GetControlRotation();
@@ -263,6 +425,11 @@ void AHLtC_CombatSystemCharacter::Move(const FInputActionValue& Value)
 
 void AHLtC_CombatSystemCharacter::Look(const FInputActionValue& Value)
 {
+	if (!AcceptInput(EHLtC_InputAction::Look, Value))
+	{
+		return;
+	}
+
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
 
@@ -276,75 +443,356 @@ void AHLtC_CombatSystemCharacter::Look(const FInputActionValue& Value)
 
 void AHLtC_CombatSystemCharacter::SprintingFlag(const FInputActionValue& Value)
 {
-	isSprinting = Value.Get<bool>(); // Set the value to if the input it being pressed or released
+	if (!AcceptInput(EHLtC_InputAction::Sprint, Value))
+	{
+		return;
+	}
+
+	const bool bSprinting = Value.Get<bool>();
+	if (bSprinting != Hot.bSprinting) // Triggers every frame the input is held, only the changes are events
+	{
+		PushInputEvent(bSprinting ? EHLtC_InputEvent::SprintStarted : EHLtC_InputEvent::SprintCompleted);
+	}
+	Hot.bSprinting = bSprinting; // Set the value to if the input it being pressed or released
 }
 
 void AHLtC_CombatSystemCharacter::LightAttack(const FInputActionValue& Value)
 {
-	if (HeavyAttackIndex == 0 && LightAttackIndex < LightAttackChainLength) // If not using the heavy attack and the current light attack is not the last in the chain...
+	if (!AcceptInput(EHLtC_InputAction::LightAttack, Value))
 	{
-		if (StaticActionDurationTimer <= AdditionalAttackBufferTiming) // If the remaining duration on the current attack is less or equal to the AdditionalAttackBufferTiming...
-		{
-			// Set variables to trigger an attack
-			StaticAction = true;
-			Blocking = false;
-			CurrentAttackType = "Light";
-			AttackMechanicsTrigger = true;
-
-			PlayerAction = "LightAttack_" + FString::FromInt(LightAttackIndex);
-			StaticActionDurationTimer = LightAttackTimings[LightAttackIndex]; // Set the attack duration based on what attack it is
-			AdditionalAttackBufferTiming = StaticActionDurationTimer * AttackBufferTimingMulti; // Set the attack buffer based on StaticActionDurationTimer
-			AdditionalAttackBuffer = false;
-			LightAttackIndex++;	// Update the index so it reflects the current attack being used
-		}
-
-		else // If the user attempts to attack too soon after a prior attack...
-		{
-			CurrentAttackType = "Light";
-			AdditionalAttackBuffer = true; // Buffer an attack to use as soon as it can be
-		}
+		return;
 	}
+
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_AttackInput);
+	PushInputEvent(EHLtC_InputEvent::LightAttack);
 }
 
 void AHLtC_CombatSystemCharacter::HeavyAttack(const FInputActionValue& Value)
 {
-	if (LightAttackIndex == 0 && HeavyAttackIndex < HeavyAttackChainLength) // If not using the light attack and the current heavy attack is not the last in the chain...
+	if (!AcceptInput(EHLtC_InputAction::HeavyAttack, Value))
+	{
+		return;
+	}
+
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_AttackInput);
+	PushInputEvent(EHLtC_InputEvent::HeavyAttack);
+}
+
+void AHLtC_CombatSystemCharacter::Block(const FInputActionValue& Value)
+{
+	if (!AcceptInput(EHLtC_InputAction::Block, Value))
+	{
+		return;
+	}
+
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_BlockInput);
+	PushInputEvent(Value.Get<bool>() ? EHLtC_InputEvent::BlockStarted : EHLtC_InputEvent::BlockCompleted); // Only changes while the player isn't doing an action
+}
+
+void AHLtC_CombatSystemCharacter::Dodge(const FInputActionValue& Value)
+{
+	if (!AcceptInput(EHLtC_InputAction::Dodge, Value))
+	{
+		return;
+	}
+
+	const EHLtC_DodgeDirection Direction = GetDodgeDirection(Value);
+	PushInputEvent(static_cast<EHLtC_InputEvent>(static_cast<uint8>(EHLtC_InputEvent::DodgeForward) + static_cast<uint8>(Direction)));
+}
+
+EHLtC_DodgeDirection AHLtC_CombatSystemCharacter::GetDodgeDirection(const FInputActionValue& Value) const
+{
+	const FVector2D Input = Value.GetValueType() == EInputActionValueType::Axis2D ? Value.Get<FVector2D>()
+		: static_cast<uint32>(GFrameCounter) - Hot.LastMoveInputFrame <= 1 ? FVector2D(Hot.LastMoveInput)
+		: FVector2D::ZeroVector;
+
+	if (Input.IsNearlyZero())
+	{
+		return EHLtC_DodgeDirection::Backward;
+	}
+
+	// Input is relative to the camera, like movement, and the dodge to the character
+	const FRotator YawRotation(0.0f, Controller ? Controller->GetControlRotation().Yaw : GetActorRotation().Yaw, 0.0f);
+	const FVector WorldDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X) * Input.Y + FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y) * Input.X;
+	const FVector LocalDirection = GetActorRotation().UnrotateVector(WorldDirection);
+
+	if (FMath::Abs(LocalDirection.X) >= FMath::Abs(LocalDirection.Y))
+	{
+		return LocalDirection.X >= 0.0 ? EHLtC_DodgeDirection::Forward : EHLtC_DodgeDirection::Backward;
+	}
+	return LocalDirection.Y >= 0.0 ? EHLtC_DodgeDirection::Right : EHLtC_DodgeDirection::Left;
+}
+
+void AHLtC_CombatSystemCharacter::StartDodgeRootMotion()
+{
+	if (GetLocalRole() == ROLE_SimulatedProxy || !CombatSimulation || Hot.CombatantIndex == INDEX_NONE) // Simulated proxies follow the movement the server replicates
+	{
+		return;
+	}
+
+	const TSharedPtr<FHLtC_RootMotionSource_Dodge> Source = MakeShared<FHLtC_RootMotionSource_Dodge>();
+	if (!CombatSimulation->MakeDodgeRootMotion(Hot.CombatantIndex, *Source))
 	{
-		if (StaticActionDurationTimer <= AdditionalAttackBufferTiming) // If the remaining duration on the current attack is less or equal to the AdditionalAttackBufferTiming...
+		return;
+	}
+
+	Source->Yaw = static_cast<float>(GetActorRotation().Yaw); // Dodges move relative to where the character faced when they started
+	Hot.DodgeRootMotionID = GetCharacterMovement()->ApplyRootMotionSource(Source);
+}
+
+void AHLtC_CombatSystemCharacter::LockOnCheck(const FInputActionValue& Value)
+{
+	if (LockOnTarget) // Pressing again releases the lock
+	{
+		SetLockOnTarget(nullptr);
+	}
+
+	else if (LockOn && Controller)
+	{
+		SetLockOnTarget(LockOn->FindTarget(this, Controller->GetControlRotation().Vector()));
+	}
+}
+
+void AHLtC_CombatSystemCharacter::LockOnSwitch(const FInputActionValue& Value)
+{
+	const float Direction = Value.Get<float>();
+	if (LockOnTarget && LockOn && Controller && Direction != 0.0f)
+	{
+		if (AActor* NewTarget = LockOn->SwitchTarget(this, Controller->GetControlRotation().Vector(), LockOnTarget, Direction > 0.0f)) // Keeps the current target if there's nothing on that side
 		{
-			// Set variables to trigger an attack
-			StaticAction = true;
-			Blocking = false;
-			CurrentAttackType = "Heavy";
-			AttackMechanicsTrigger = true;
-
-			PlayerAction = "HeavyAttack_" + FString::FromInt(HeavyAttackIndex);
-			StaticActionDurationTimer = HeavyAttackTimings[HeavyAttackIndex]; // Set the attack duration based on what attack it is
-			AdditionalAttackBufferTiming = StaticActionDurationTimer * AttackBufferTimingMulti; // Set the attack buffer based on StaticActionDurationTimer
-			AdditionalAttackBuffer = false;
-			HeavyAttackIndex++;	// Update the index so it reflects the current attack being used
+			SetLockOnTarget(NewTarget);
 		}
+	}
+}
+
+void AHLtC_CombatSystemCharacter::SetLockOnTarget(AActor* NewTarget)
+{
+	LockOnTarget = NewTarget;
+
+	// Focus picks the arm length and socket offset of the "Action" camera defaults
+	const EHLtC_CameraState NewCameraState = NewTarget ? EHLtC_CameraState::Focus : EHLtC_CameraState::Free;
+	if (Hot.States.CameraState != NewCameraState)
+	{
+		ApplyCameraState(NewCameraState);
+	}
+}
+
+void AHLtC_CombatSystemCharacter::UpdateLockOn(float DeltaTime)
+{
+	if (LockOnTarget == nullptr)
+	{
+		return;
+	}
 
-		else // If the user attempts to attack too soon after a prior attack...
+	if (!LockOn || !LockOn->IsTargetValid(this, LockOnTarget)) // Out of range or gone, so the camera is freed
+	{
+		SetLockOnTarget(nullptr);
+		return;
+	}
+
+	if (Controller != nullptr) // Turns the view to keep the target in front of the camera
+	{
+		const FRotator ControlRotation = Controller->GetControlRotation();
+		const FRotator TargetRotation = (LockOnTarget->GetActorLocation() - GetActorLocation()).Rotation();
+		Controller->SetControlRotation(FMath::RInterpTo(ControlRotation, FRotator(ControlRotation.Pitch, TargetRotation.Yaw, ControlRotation.Roll), DeltaTime, 10.0f));
+	}
+}
+
+void AHLtC_CombatSystemCharacter::PushInputEvent(EHLtC_InputEvent Type)
+{
+	if (InputEvents.Push({ CombatSimulation ? CombatSimulation->GetInputClock() : FPlatformTime::Seconds(), Type }))
+	{
+		bInputQueueOverflowed = false;
+	}
+
+	else
+	{
+		if (!bInputQueueOverflowed) // Once per overflow, the counter keeps the total
 		{
-			CurrentAttackType = "Heavy";
-			AdditionalAttackBuffer = true; // Buffer an attack to use as soon as it can be
+			UE_LOG(LogTemplateCharacter, Warning, TEXT("'%s' Input event queue is full, dropping input till it drains."), *GetNameSafe(this));
+			bInputQueueOverflowed = true;
 		}
+		HLtC::IncrementCounter(HLtC::Counter_AttacksDropped);
+	}
+
+	if (CombatSimulation) { CombatSimulation->WakeCombatant(Hot.CombatantIndex); } // Input always gets a response on the next frame, whatever the tick bucket
+
+	if (GetLocalRole() == ROLE_AutonomousProxy) // Predicted here, simulated for real on the server
+	{
+		const bool bClaim = CombatSimulation && Hot.CombatantIndex != INDEX_NONE && HLtC::IsValidatedInput(Type);
+		const FHLtC_InputClaim Claim = bClaim ? HLtC::MakeInputClaim(CombatSimulation->GetCombatWorld(), Hot.CombatantIndex, Type) : FHLtC_InputClaim();
+		ServerPushInputEvent(static_cast<uint8>(Type), Claim.Move, Claim.bChanged != 0);
+		Hot.SentInputs++;
 	}
 }
 
-void AHLtC_CombatSystemCharacter::Block(const FInputActionValue& Value)
+bool AHLtC_CombatSystemCharacter::ReceiveServerInput()
+{
+	Hot.ReceivedInputs++;
+	if (ServerInputFrame != GFrameCounter)
+	{
+		ServerInputFrame = GFrameCounter;
+		ServerInputsThisFrame = 0;
+	}
+
+	if (++ServerInputsThisFrame > GHLtCCombatMaxServerInputsPerFrame) // More than anyone could press in a frame. Still acknowledged, so the clients prediction gets corrected
+	{
+		UE_LOG(LogTemplateCharacter, Verbose, TEXT("'%s' Sent more than %d inputs this frame, dropping input."), *GetNameSafe(this), GHLtCCombatMaxServerInputsPerFrame);
+		HLtC::IncrementCounter(HLtC::Counter_AttacksDropped);
+		if (CombatSimulation) { CombatSimulation->MarkChanged(Hot.CombatantIndex); }
+		return false;
+	}
+	return true;
+}
+
+void AHLtC_CombatSystemCharacter::ServerPushInputEvent_Implementation(uint8 Type, uint16 ClaimedMove, bool bClaimedChange)
+{
+	if (Type >= static_cast<uint8>(EHLtC_InputEvent::Count) || !ReceiveServerInput())
+	{
+		return;
+	}
+
+	PushInputEvent(static_cast<EHLtC_InputEvent>(Type));
+	if (!CombatSimulation)
+	{
+		return;
+	}
+
+	CombatSimulation->MarkChanged(Hot.CombatantIndex); // Acknowledges the input even if it changes nothing
+	if (HLtC::IsValidatedInput(static_cast<EHLtC_InputEvent>(Type)))
+	{
+		FHLtC_InputClaim Claim;
+		Claim.Combatant = Hot.CombatantIndex;
+		Claim.Move = ClaimedMove;
+		Claim.Type = static_cast<EHLtC_InputEvent>(Type);
+		Claim.bChanged = bClaimedChange ? 1 : 0;
+		CombatSimulation->SubmitInputClaim(Claim); // Checked against the servers timeline, never changes what the input does
+	}
+}
+
+void AHLtC_CombatSystemCharacter::ServerSetPlayerControlState_Implementation(uint8 State)
+{
+	if (State >= HLtC::NumControlStates || !ReceiveServerInput())
+	{
+		return;
+	}
+
+	ApplyControlState(static_cast<EHLtC_ControlState>(State)); // Marks the combatant changed, which acknowledges the input
+}
+
+void AHLtC_CombatSystemCharacter::OnRep_NetCombatState()
 {
-	if (!StaticAction) // If the player isn't doing an action...
+	if (!CombatSimulation || Hot.CombatantIndex == INDEX_NONE) // Applied once the character registers
 	{
-		if (Value.Get<bool>()) // If the blocking input is being pressed or held...
+		return;
+	}
+
+	const FHLtC_NetCombatState& State = NetCombatState.State;
+	if (IsLocallyControlled())
+	{
+		// Inputs the server hasn't seen yet would be undone, so a prediction is only checked once every input it used is acknowledged
+		if (State.InputAck == Hot.SentInputs && !CombatSimulation->GetNetState(Hot.CombatantIndex, Hot.SentInputs).HasSameStates(State))
 		{
-			Blocking = true;
+			CombatSimulation->ApplyNetState(Hot.CombatantIndex, State, true);
 		}
+	}
+
+	else
+	{
+		CombatSimulation->ApplyNetState(Hot.CombatantIndex, State, false);
+	}
+}
+
+void AHLtC_CombatSystemCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AHLtC_CombatSystemCharacter, NetCombatState);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Layout report
+
+#if !UE_BUILD_SHIPPING
+/** Logs the size and offset of every member of the per frame state, and how much of the character it makes up */
+static void ReportCombatCharacterLayout()
+{
+	using FHot = FHLtC_CharacterHotState;
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("FHLtC_CharacterHotState: %d bytes, aligned to %d, at offset %d of the %d byte AHLtC_CombatSystemCharacter."),
+		static_cast<int32>(sizeof(FHot)), static_cast<int32>(alignof(FHot)), static_cast<int32>(STRUCT_OFFSET(AHLtC_CombatSystemCharacter, Hot)), static_cast<int32>(sizeof(AHLtC_CombatSystemCharacter)));
+
+	const auto ReportMember = [](const TCHAR* Name, int32 Offset, int32 Size)
+	{
+		UE_LOG(LogTemplateCharacter, Display, TEXT("  %-24s offset %2d, %2d bytes"), Name, Offset, Size);
+	};
+#define HLTC_REPORT_MEMBER(Member) ReportMember(TEXT(#Member), STRUCT_OFFSET(FHot, Member), sizeof(FHot::Member))
+	HLTC_REPORT_MEMBER(States);
+	HLTC_REPORT_MEMBER(CombatantIndex);
+	HLTC_REPORT_MEMBER(AppliedStateDefaultsKey);
+	HLTC_REPORT_MEMBER(LastMoveInputFrame);
+	HLTC_REPORT_MEMBER(LastMoveInput);
+	HLTC_REPORT_MEMBER(DodgeRootMotionID);
+	HLTC_REPORT_MEMBER(CurrentAttackType);
+	HLTC_REPORT_MEMBER(SentInputs);
+	HLTC_REPORT_MEMBER(ReceivedInputs);
+#undef HLTC_REPORT_MEMBER
+	ReportMember(TEXT("Flags (bitfields)"), STRUCT_OFFSET(FHot, ReceivedInputs) + 1, 1); // Bitfields have no address, they share the byte after ReceivedInputs
+
+	UE_LOG(LogTemplateCharacter, Display, TEXT("UHLtC_CombatTuningAsset: %d bytes, one per archetype."), static_cast<int32>(sizeof(UHLtC_CombatTuningAsset)));
+}
+
+static FAutoConsoleCommand CmdHLtCCombatLayoutReport(
+	TEXT("hltc.Combat.LayoutReport"),
+	TEXT("Logs the size and member offsets of the per frame state of combat characters."),
+	FConsoleCommandDelegate::CreateStatic(&ReportCombatCharacterLayout));
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// State notification test
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHLtC_CombatStateNotificationTest, "HLtC.Combat.StateNotifications", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 
-		else // If the blocking input is being released...
+/** Control state changes and lock-ons must be announced, and show up in the Blueprint readable properties */
+bool FHLtC_CombatStateNotificationTest::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(TestWorld);
+	TestWorld->InitializeActorsForPlay(FURL());
+	TestWorld->BeginPlay();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AHLtC_CombatSystemCharacter* Player = TestWorld->SpawnActor<AHLtC_CombatSystemCharacter>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+	AHLtC_CombatSystemCharacter* Target = TestWorld->SpawnActor<AHLtC_CombatSystemCharacter>(FVector(300.0f, 0.0f, 0.0f), FRotator::ZeroRotator, SpawnParameters);
+	UHLtC_CombatSimulationSubsystem* Simulation = TestWorld->GetSubsystem<UHLtC_CombatSimulationSubsystem>();
+
+	// The simulation wide delegate is broadcast right after the characters own one, for the same events
+	TArray<EHLtC_CombatEvent> Events;
+	if (Simulation)
+	{
+		Simulation->OnCombatEvent.AddLambda([Player, &Events](AHLtC_CombatSystemCharacter* Character, const FHLtC_CombatEvent& Event)
 		{
-			Blocking = false;
-		}
+			if (Character == Player) { Events.Add(Event.Type); }
+		});
+	}
+
+	bool bPassed = TestNotNull(TEXT("Combat simulation"), Simulation) && TestNotNull(TEXT("Player"), Player) && TestNotNull(TEXT("Target"), Target);
+	if (bPassed)
+	{
+		bPassed &= TestTrue(TEXT("Control state accepted"), Player->SetPlayerControlState(HLtC::GetStateName(EHLtC_ControlState::Action)));
+		bPassed &= TestTrue(TEXT("Control state change announced"), Events.Contains(EHLtC_CombatEvent::ControlStateChanged));
+		bPassed &= TestEqual(TEXT("Control state mirrored"), Player->PlayerControlState, HLtC::GetStateName(EHLtC_ControlState::Action).ToString());
+
+		Player->SetLockOnTarget(Target);
+		bPassed &= TestTrue(TEXT("Lock-on camera change announced"), Events.Contains(EHLtC_CombatEvent::CameraStateChanged));
+		bPassed &= TestEqual(TEXT("Camera state mirrored"), Player->CameraState, HLtC::GetStateName(EHLtC_CameraState::Focus).ToString());
 	}
+
+	GEngine->DestroyWorldContext(TestWorld);
+	TestWorld->DestroyWorld(false);
+	return bPassed;
 }
+#endif
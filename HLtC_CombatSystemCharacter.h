@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Logging/LogMacros.h"
+#include "HLtC_CombatStateMachine.h"
+#include "HLtC_AttackChainAsset.h"
+#include "HLtC_CombatReplication.h"
+#include "HLtC_CombatTuningAsset.h"
 #include "HLtC_CombatSystemCharacter.generated.h"
 
 class USpringArmComponent;
@@ -12,9 +16,60 @@ class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
 struct FInputActionValue;
+class UHLtC_CombatSimulationSubsystem;
+class UHLtC_LockOnSubsystem;
+class UHLtC_CameraRigComponent;
+class UHLtC_CombatReplaySubsystem;
+class AHLtC_CombatSystemCharacter;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/** Input actions the character handles, for input that doesn't come from a player's input component */
+enum class EHLtC_InputAction : uint8
+{
+	Move, // FVector2D
+	Look, // FVector2D
+	Sprint, // bool, held
+	LightAttack,
+	HeavyAttack,
+	Block, // bool, true when pressed and false when released
+	Dodge, // Optional FVector2D direction, in the same space as Move. Otherwise the latest movement input picks it
+	Count
+};
+
+/**
+ * Everything the character reads or writes every frame, packed into a single cache line.
+ * Tuning lives in the shared UHLtC_CombatTuningAsset of the characters archetype, and what's only touched on setup or by Blueprint stays on the character.
+ * Floats replace doubles where the precision isn't needed and the flags are bitfields, hltc.Combat.LayoutReport prints the layout.
+ */
+struct alignas(64) FHLtC_CharacterHotState // 64 rather than PLATFORM_CACHE_LINE_SIZE: never straddles two lines either way, and doesn't pad out to 128 bytes where lines are that long
+{
+	FHLtC_CombatStateMachine States; // The players current control/movement, action and camera states
+	int32 CombatantIndex = INDEX_NONE; // Index of the character in the combat simulation, whose arrays hold its timers, attack cursor and buffered attack
+	uint32 AppliedStateDefaultsKey = MAX_uint32; // Packed control/action/camera/sprint states the current defaults were applied for
+	uint32 LastMoveInputFrame = 0; // Frame LastMoveInput arrived on, truncated. Older input counts as none
+	FVector2f LastMoveInput = FVector2f::ZeroVector; // Latest movement input, which picks the direction of a dodge
+	uint16 DodgeRootMotionID = 0; // Root motion source of the current dodge on the movement component, 0 when none is applied
+	EHLtC_AttackType CurrentAttackType = EHLtC_AttackType::None; // Type of attack currently being used (Light/Heavy)
+	uint8 SentInputs = 0; // Owning client: combat inputs sent to the server, wrapping. Predictions are only corrected once the server has acknowledged all of them
+	uint8 ReceivedInputs = 0; // Server: combat inputs received from the owning client, wrapping
+	uint8 bStaticAction : 1; // If the player can't currently move (static actions freeze player movement)
+	uint8 bBlocking : 1; // Signals if the simulation has the player blocking
+	uint8 bSprinting : 1; // Signals if the user is holding the sprint input
+	uint8 bInAttackChain : 1; // An attack chain has been announced and hasn't been announced ended yet
+
+	FHLtC_CharacterHotState() : bStaticAction(false), bBlocking(false), bSprinting(false), bInAttackChain(false) {}
+};
+
+static_assert(sizeof(FHLtC_CharacterHotState) == 64, "The per frame state of a combat character has to fit a 64 byte cache line");
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FHLtC_OnAttackHit, AHLtC_CombatSystemCharacter*, Target, float, Damage, bool, bBlocked);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHLtC_OnActionChanged, FName, Action);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FHLtC_OnAttackEvent, FName, AttackType, int32, ChainIndex);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FHLtC_OnChainEnded);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHLtC_OnBlockingChanged, bool, bBlocking);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHLtC_OnStateChanged, FName, NewState);
+
 UCLASS(config=Game)
 class AHLtC_CombatSystemCharacter : public ACharacter
 {
@@ -52,6 +107,10 @@ class AHLtC_CombatSystemCharacter : public ACharacter
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	UInputAction* LockOnCheckAction;
 
+	/** LockOn Switch Input Action, an axis whose sign picks the next target to the right or left */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
+	UInputAction* LockOnSwitchAction;
+
 	/** Block Input Action */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	UInputAction* BlockAction;
@@ -72,75 +131,153 @@ public:
 	AHLtC_CombatSystemCharacter();
 
 	// States
-	
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	FString PlayerControlState; // The players current control/movement state
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	FString PlayerAction; // The players current action
+	FHLtC_CharacterHotState Hot; // Per frame state, read and written by the combat simulation every frame
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	bool StaticAction = false; // If the player can currently move (static actions freeze player movement)
-	
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	double StaticActionDurationTimer = 0.0f; // Countdown till a static action concludes
+	/** Returns the players current control/movement state ("Slow" or "Action") */
+	UFUNCTION(BlueprintPure, Category = States)
+	FName GetPlayerControlState() const { return HLtC::GetStateName(Hot.States.ControlState); }
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	FString CameraState; // The cameras current control/movement state
+	/** Returns the players current action ("Idle", "Moving", "Sprinting", "LightAttack_N", "HeavyAttack_N" or "DodgeForward/Backward/Left/Right") */
+	UFUNCTION(BlueprintPure, Category = States)
+	FName GetPlayerAction() const { return Hot.States.GetActionName(); }
+
+	/** Returns the cameras current control/movement state ("Free" or "Focus") */
+	UFUNCTION(BlueprintPure, Category = States)
+	FName GetCameraState() const { return HLtC::GetStateName(Hot.States.CameraState); }
+
+	/** Sets the players control/movement state by name. Returns false if the name isn't a control state */
+	UFUNCTION(BlueprintCallable, Category = States)
+	bool SetPlayerControlState(FName NewState);
+
+	/** Sets the cameras control/movement state by name. Returns false if the name isn't a camera state */
+	UFUNCTION(BlueprintCallable, Category = States)
+	bool SetCameraState(FName NewState);
+
+	// Read-only copies of the states with the old variables names and types, so animation Blueprints that read and compare them keep compiling. Updated with every notification
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = States)
+	FString PlayerControlState; // As GetPlayerControlState returns
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = States)
+	FString PlayerAction; // As GetPlayerAction returns
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = States)
+	FString CameraState; // As GetCameraState returns
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = States)
+	bool StaticAction = false; // As IsStaticAction returns
+
+	// Notifications, sent once per change after the simulation writes it back, so animation and UI don't have to poll the states every frame
+
+	/** Called when the action changes, with the name GetPlayerAction returns */
+	UPROPERTY(BlueprintAssignable, Category = States)
+	FHLtC_OnActionChanged OnActionChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = States)
+	FHLtC_OnStateChanged OnControlStateChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = States)
+	FHLtC_OnStateChanged OnCameraStateChanged;
+
+	/** Returns if the player is in a static action, which freezes player movement */
+	UFUNCTION(BlueprintPure, Category = States)
+	bool IsStaticAction() const { return Hot.bStaticAction; }
+
+	/** Returns the countdown till the current static action concludes */
+	UFUNCTION(BlueprintPure, Category = States)
+	float GetStaticActionDurationTimer() const;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
 	int ControlSchemeIndex = 1; // The currently selected control scheme as an index
 
-	// Movement
+	// Tuning
 
-	float MoveSpeed_Slow = 200.0f; // Move speed of player during "Slow" control state
-	
-	float MoveSpeed_Action = 400.0f; // Move speed of player during "Active" control state
+	/** Move speeds, camera defaults and camera rig rates, shared by every character of the archetype. The built-in tuning is used when this is empty */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tuning)
+	UHLtC_CombatTuningAsset* Tuning = nullptr;
 
-	bool isSprinting; // Signals if the user is holding the sprint input
-	float SprintSpeedAddition = 200.0f; // Added to player speed when sprinting
+	const UHLtC_CombatTuningAsset& GetTuning() const { return UHLtC_CombatTuningAsset::Get(Tuning); }
 	
 	// Attack
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	FString CurrentAttackType; // Type of attack currently being used (Light/Heavy)
+	/** Returns the type of attack currently being used ("Light", "Heavy" or None) */
+	UFUNCTION(BlueprintPure, Category = Attack)
+	FName GetCurrentAttackType() const { return HLtC::GetStateName(Hot.CurrentAttackType); }
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	bool AttackMechanicsTrigger = false; // Pulse to activate associated attack mechanics (currently hitscan) for a single instance
-	
-	int LightAttackIndex; // Index of the light attack in the chain currently being used
-	int HeavyAttackIndex; // Index of the heavy attack in the chain currently being used
-	
-	int LightAttackChainLength = 5; // Length of the light attack chain
-	int HeavyAttackChainLength = 3; // Length of the heavy attack chain
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Attack)
+	FString CurrentAttackType; // Read-only copy of GetCurrentAttackType
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Attack)
+	bool AttackMechanicsTrigger = false; // Pulse to activate associated attack mechanics (currently hitscan), true for the frame OnHitWindowOpened is called on
+
+	/** Called for every move entered, with its type ("Light" or "Heavy") and chain index */
+	UPROPERTY(BlueprintAssignable, Category = Attack)
+	FHLtC_OnAttackEvent OnAttackStarted;
+
+	/** Called once per move when its hit should be tested. Drives the attack mechanics (e.g. the Blueprint hitscan) while hltc.Combat.BatchedHits is off */
+	UPROPERTY(BlueprintAssignable, Category = Attack)
+	FHLtC_OnAttackEvent OnHitWindowOpened;
+
+	/** Called when an attack chain runs out, is interrupted or restarts */
+	UPROPERTY(BlueprintAssignable, Category = Attack)
+	FHLtC_OnChainEnded OnChainEnded;
+
+	/** Called once for every combatant an attack of this character hits, after the simulation resolves the frames attacks in one batch. Replaces the per-attack hitscan while hltc.Combat.BatchedHits is on */
+	UPROPERTY(BlueprintAssignable, Category = Attack)
+	FHLtC_OnAttackHit OnAttackHit;
 	
-	double LightAttackTimings[5] = { 1.0f, 0.7f, 0.7f, 0.7f, 0.7f }; // Duration of each attack in the light attack chain
-	double HeavyAttackTimings[3] = { 1.5f, 1.0f, 1.0f }; // Duration of each attack in the heavy attack chain
+	/** Attack chains of the characters weapon. The built-in light and heavy chains are used when this is empty */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Attack)
+	UHLtC_AttackChainAsset* AttackChains;
+
+	// Simulation
 
-	bool AdditionalAttackBuffer; // Signals if the next attack in the chain should trigger as soon as possible. Set to true if the user tries attacking too soon after a prior attack
-	double AdditionalAttackBufferTiming; // The duration of time needed to pass after an attack is triggered for a followup attack to be triggered. Based on the complete duration of the prior attack
-	double AttackBufferTimingMulti = 0.5f; // The multiplier that determines the initial length of AdditionalAttackBufferTiming
+	FHLtC_InputEventRing InputEvents; // Timestamped combat input waiting for the simulation. Can be pushed to from any one thread
+
+	/** Feeds an input through the same handler its bound input action would, e.g. for scripted or AI input. Game thread only */
+	void SimulateInput(EHLtC_InputAction Action, const FInputActionValue& Value);
+
+	void SetLockOnTarget(AActor* NewTarget); // Focuses the camera on a target, or frees it when null
+
+	UPROPERTY(Transient)
+	UHLtC_CombatSimulationSubsystem* CombatSimulation; // The simulation the character is registered with
+
+	UPROPERTY(Transient)
+	UHLtC_CombatReplaySubsystem* Replay = nullptr; // Records the characters input, or replaces it while a replay plays
+
+	// Replication. The server simulates every character from the input its owner sends, the owning client predicts its own character and everyone else follows the server
+
+	UPROPERTY(ReplicatedUsing = OnRep_NetCombatState)
+	FHLtC_ReplicatedCombatState NetCombatState; // Set by the server whenever the simulation writes the character back
 
 	// Blocking
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
-	bool Blocking; // Signals if the user is holding the block input
+	/** Returns if the player is blocking */
+	UFUNCTION(BlueprintPure, Category = Blocking)
+	bool IsBlocking() const { return Hot.bBlocking; }
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Blocking)
+	bool Blocking = false; // Read-only copy of IsBlocking
+
+	UPROPERTY(BlueprintAssignable, Category = Blocking)
+	FHLtC_OnBlockingChanged OnBlockingChanged;
 	
+	// Lock-on
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = LockOn)
+	AActor* LockOnTarget = nullptr; // Actor the camera is focused on, null while not locked on
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LockOn)
+	bool bTargetable = true; // If other characters can lock on to this one
+
+	UPROPERTY(Transient)
+	UHLtC_LockOnSubsystem* LockOn; // The lock-on index the character is registered with
+
 	// Camera
-	
-	float ArmLengths_Slow[3] = { 175.0f, 225.0f, 275.0f }; // Array of boom arm lengths, defining said lengths for when the control state is "Slow", and PlayerAction is "Idle", "Moving", or "Sprinting" respectively
-	FVector BoomSocketOffset_Slow = { 0.0f, 50.0f, 75.0f }; // The cameras offset from the player on the end of the camera boom when the control state is "Slow"
-	
-	float ArmLengths_Action[2] = { 300.0f, 350.0f }; // Array of boom arm lengths, defining said lengths for when the control state is "Action", and CameraState isn't "Free", and is "Free" respectively
-	FVector BoomSocketOffset_Action[2] = { { 0, 0, 50.0f }, { 0, 0, 100.0f } }; // The cameras offset from the player on the end of the camera boom when the control state is "Action"
-	
-	float DesiredArmLength; // The target boom arm length at any instance, needed for when the actual boom arm length is between values
-	FVector DesiredBoomSocketOffset; // The target camera offset at any instance, needed for when the actual camera offset is between values
 
-	bool CamShakeRising = true; // Signals if the camera is currently positively rising during the camera shake
-	double CamShakeTiming = 0; // The current timing of the camera shake used in the interpolation to determine the cameras current offset
-	double CamShakeTimingConstraint = 0.1f; // Constraints CamShakeTiming. If CamShakeTiming is greater than the constraint, of less than the constraints inverse, then flip CamShakeRising so that camera shake moves in the opposite direction
-	float CamShakeDeltaTimeDivision[2] = { 2.0f, 1.2f }; // An array containing the values that divide the amount added to CamShakeTiming every frame, to vary the timing of the camera shake. They are for "Moving" and "Sprinting" respectively
+	UPROPERTY(Transient)
+	UHLtC_CameraRigComponent* CameraRig = nullptr; // Blends the camera boom between the state defaults. Only exists while the character is locally controlled, never on a dedicated server
 
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
@@ -151,9 +288,37 @@ protected:
 	// To add mapping context
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaTime) override;
 
-	void SetControlStateDefaults(float DeltaTime); // Sets the default values associated with each control, action and camera state every frame
+	virtual void NotifyControllerChanged() override;
+
+	void UpdateCameraRig(); // Creates the camera rig when the character becomes locally controlled, and removes it when it stops being
+
+	friend class UHLtC_CombatSimulationSubsystem; // Writes the simulated states back through the hooks below
+
+	void SetPlayerAction(EHLtC_PlayerAction NewAction, uint8 NewAttackIndex = 0); // Moves the state machine to a new action, calling the exit and entry hooks if it changed
+
+	virtual void OnExitAction(const FHLtC_StateTransition& Transition); // Called before leaving an action
+	virtual void OnEnterAction(const FHLtC_StateTransition& Transition); // Called after entering an action
+
+	void NotifyCombatEvent(const FHLtC_CombatEvent& Event); // Calls the delegate the event belongs to
+
+	void MirrorStates(); // Copies the states into their Blueprint readable properties
+
+	void ApplyControlState(EHLtC_ControlState State); // Hands a control state to the simulation, whose write back updates the states and announces the change
+	void ApplyCameraState(EHLtC_CameraState State); // Same for the camera state
+
+	uint64 AttackMechanicsTriggerFrame = 0; // Frame AttackMechanicsTrigger was set on, it's cleared on any later one
+
+	uint64 ServerInputFrame = 0; // Server: frame ServerInputsThisFrame counts the inputs of
+	int32 ServerInputsThisFrame = 0; // Server: inputs received from the owning client on ServerInputFrame, past hltc.Combat.MaxServerInputsPerFrame they're dropped
+	bool bInputQueueOverflowed = false; // Drops are logged once per overflow, till an input fits again
+
+	bool ReceiveServerInput(); // Server: counts an input from the owning client towards its acknowledgement. False if it's past the per frame limit and has to be dropped
+
+	void ApplyStateDefaults(); // Applies the move speed and camera targets of the current states, only when the states have changed since they were last applied
 
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
@@ -162,7 +327,7 @@ protected:
 	void Look(const FInputActionValue& Value);
 
 	/** Called for sprinting input */
-	void SprintingFlag(const FInputActionValue& Value); // Executes when sprint input action is triggered. Sets isSprinting
+	void SprintingFlag(const FInputActionValue& Value); // Executes when sprint input action is triggered. Sets bSprinting
 
 	/** Called for light attack input */
 	void LightAttack(const FInputActionValue& Value); // Executes when light attack input action is triggered. Determines what light attack should be used and when
@@ -170,8 +335,44 @@ protected:
 	/** Called for heavy attack input */
 	void HeavyAttack(const FInputActionValue& Value); // Executes when heavy attack input action is triggered. Determines what heavy attack should be used and when
 
+
 	/** Called for block input */
 	void Block(const FInputActionValue& Value); // Executes when sprint input action is triggered. Sets Blocking
+
+	/** Called for dodge input */
+	void Dodge(const FInputActionValue& Value);
+
+	EHLtC_DodgeDirection GetDodgeDirection(const FInputActionValue& Value) const; // Picks the dodge relative to the facing of the character, backwards without any direction
+
+	void StartDodgeRootMotion(); // Hands the baked root motion of the dodge just entered to the movement component, which predicts and replicates it
+
+	/** Called for lock-on input */
+	void LockOnCheck(const FInputActionValue& Value); // Locks on to the best target in view, or releases the current one
+
+	/** Called for lock-on switch input */
+	void LockOnSwitch(const FInputActionValue& Value); // Moves the lock to the next target to the right or left
+
+	void UpdateLockOn(float DeltaTime); // Drops targets that went out of range and turns the view towards the current one
+
+	void PushInputEvent(EHLtC_InputEvent Type); // Queues an input for the combat simulation, stamped with the time it arrived
+
+	bool AcceptInput(EHLtC_InputAction Action, const FInputActionValue& Value); // Hands an input to the replay first. False while a replay is playing, unless the input comes from it
+
+	/**
+	 * Sends a combat input of the owning client to the server, which queues it for its own simulation. Type is an EHLtC_InputEvent.
+	 * Attack and block inputs carry what the clients prediction says they did, which the server checks off the game thread
+	 */
+	UFUNCTION(Server, Reliable)
+	void ServerPushInputEvent(uint8 Type, uint16 ClaimedMove, bool bClaimedChange);
+
+	/** Sends a control state change of the owning client to the server, which replicates it back. State is an EHLtC_ControlState. Counts as an input, so the prediction isn't corrected before the server has it */
+	UFUNCTION(Server, Reliable)
+	void ServerSetPlayerControlState(uint8 State);
+
+	UFUNCTION()
+	void OnRep_NetCombatState(); // Follows the server, or corrects the prediction of the owning client
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
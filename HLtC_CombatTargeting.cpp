@@ -0,0 +1,351 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatTargeting.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define HLTC_TARGETING_SSE 1
+	#include <emmintrin.h>
+#else
+	#define HLTC_TARGETING_SSE 0
+#endif
+
+namespace
+{
+	/**
+	 * FindBest's score of Target at Delta from the seeker, -FLT_MAX if it can't be picked. Being looked at counts for more than being close.
+	 * The SSE path does the same operations in the same order, so both pick the same target
+	 */
+	inline float ScoreBest(const FHLtC_TargetQuery& Query, float InvMaxDistance, int32_t Target, float DeltaX, float DeltaY, float DeltaZ)
+	{
+		const float HorizontalDistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY;
+		const float DistanceSquared = HorizontalDistanceSquared + DeltaZ * DeltaZ;
+
+		const float Facing = (Query.ViewX * DeltaX + Query.ViewY * DeltaY) / std::max(std::sqrt(HorizontalDistanceSquared), 1.e-3f); // Cosine of the angle off the view direction
+		const bool bValid = (DistanceSquared <= Query.MaxDistance * Query.MaxDistance) & (Facing >= Query.CosHalfCone) & (Target != Query.Ignore);
+
+		return bValid ? Facing * 2.0f - std::sqrt(DistanceSquared) * InvMaxDistance : -FLT_MAX;
+	}
+
+	/**
+	 * FindNext's score of Target at Delta from the seeker, -FLT_MAX if it isn't to Side of the reference direction. The smallest turn wins.
+	 * Turns are pseudo angles, 1 - cos scaled by |sin| + |cos| rather than by the length, which grow from 0 to 2 over half a turn like the angle does without needing atan2.
+	 * Targets straight behind count as being on both sides. The SSE path does the same operations in the same order
+	 */
+	inline float ScoreNext(const FHLtC_TargetQuery& Query, float ReferenceX, float ReferenceY, float Side, int32_t Target, int32_t Current, float DeltaX, float DeltaY, float DeltaZ)
+	{
+		const float DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ;
+
+		// Positive crosses are to the right, as Unreal's left-handed coordinates put Y to the right of X
+		const float Cross = (ReferenceX * DeltaY - ReferenceY * DeltaX) * Side;
+		const float Dot = ReferenceX * DeltaX + ReferenceY * DeltaY;
+		const float Turn = 1.0f - Dot / std::max(std::fabs(Cross) + std::fabs(Dot), FLT_MIN);
+
+		const bool bToSide = (Cross > 0.0f) | ((Cross == 0.0f) & (Dot < 0.0f));
+		const bool bValid = (DistanceSquared <= Query.MaxDistance * Query.MaxDistance) & bToSide & (Target != Query.Ignore) & (Target != Current);
+
+		return bValid ? -Turn : -FLT_MAX;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_TargetIndex
+
+uint64_t FHLtC_TargetIndex::GetCellKey(float InX, float InY) const
+{
+	const float InvCellSize = 1.0f / CellSize;
+	return GetCellKey(static_cast<int32_t>(std::floor(InX * InvCellSize)), static_cast<int32_t>(std::floor(InY * InvCellSize)));
+}
+
+int32_t FHLtC_TargetIndex::Add(float InX, float InY, float InZ)
+{
+	int32_t Target;
+	if (!FreeHandles.empty())
+	{
+		Target = FreeHandles.back();
+		FreeHandles.pop_back();
+	}
+
+	else
+	{
+		Target = static_cast<int32_t>(Active.size());
+		X.push_back(0.0f);
+		Y.push_back(0.0f);
+		Z.push_back(0.0f);
+		Active.push_back(0);
+		CellKey.push_back(0);
+		CellSlot.push_back(-1);
+	}
+
+	X[Target] = InX;
+	Y[Target] = InY;
+	Z[Target] = InZ;
+	Active[Target] = 1;
+	InsertIntoCell(Target, GetCellKey(InX, InY));
+	NumActive++;
+	return Target;
+}
+
+void FHLtC_TargetIndex::Remove(int32_t Target)
+{
+	if (!IsValid(Target))
+	{
+		return;
+	}
+
+	RemoveFromCell(Target);
+	Active[Target] = 0;
+	FreeHandles.push_back(Target);
+	NumActive--;
+}
+
+void FHLtC_TargetIndex::Update(int32_t Target, float InX, float InY, float InZ)
+{
+	X[Target] = InX;
+	Y[Target] = InY;
+	Z[Target] = InZ;
+
+	const uint64_t NewCellKey = GetCellKey(InX, InY);
+	if (NewCellKey != CellKey[Target]) // Most moves stay within the cell, which leaves the grid alone
+	{
+		RemoveFromCell(Target);
+		InsertIntoCell(Target, NewCellKey);
+	}
+}
+
+void FHLtC_TargetIndex::InsertIntoCell(int32_t Target, uint64_t InCellKey)
+{
+	std::vector<int32_t>& Cell = Cells[InCellKey];
+	CellKey[Target] = InCellKey;
+	CellSlot[Target] = static_cast<int32_t>(Cell.size());
+	Cell.push_back(Target);
+}
+
+void FHLtC_TargetIndex::RemoveFromCell(int32_t Target)
+{
+	const auto FoundCell = Cells.find(CellKey[Target]);
+	std::vector<int32_t>& Cell = FoundCell->second;
+	const int32_t Slot = CellSlot[Target];
+
+	Cell[Slot] = Cell.back(); // Swap the last target of the cell into the gap
+	CellSlot[Cell[Slot]] = Slot;
+	Cell.pop_back();
+	CellSlot[Target] = -1;
+
+	if (Cell.empty()) // Only occupied cells are kept, so targets roaming a large level don't leave a trail of cells behind
+	{
+		Cells.erase(FoundCell);
+	}
+}
+
+bool FHLtC_TargetIndex::IsInRange(const FHLtC_TargetQuery& Query, int32_t Target, float BreakDistance) const
+{
+	if (!IsValid(Target) || Target == Query.Ignore)
+	{
+		return false;
+	}
+
+	const float DeltaX = X[Target] - Query.X;
+	const float DeltaY = Y[Target] - Query.Y;
+	const float DeltaZ = Z[Target] - Query.Z;
+	return DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ <= BreakDistance * BreakDistance;
+}
+
+void FHLtC_TargetIndex::GetNextReference(const FHLtC_TargetQuery& Query, int32_t Current, float& OutX, float& OutY) const
+{
+	// Angles are measured from the direction to the current target, or the view if there isn't one
+	OutX = Query.ViewX;
+	OutY = Query.ViewY;
+	if (IsValid(Current))
+	{
+		OutX = X[Current] - Query.X;
+		OutY = Y[Current] - Query.Y;
+	}
+}
+
+int32_t FHLtC_TargetIndex::GatherCandidates(const FHLtC_TargetQuery& Query)
+{
+	const float InvCellSize = 1.0f / CellSize;
+	const int32_t MinX = static_cast<int32_t>(std::floor((Query.X - Query.MaxDistance) * InvCellSize));
+	const int32_t MaxX = static_cast<int32_t>(std::floor((Query.X + Query.MaxDistance) * InvCellSize));
+	const int32_t MinY = static_cast<int32_t>(std::floor((Query.Y - Query.MaxDistance) * InvCellSize));
+	const int32_t MaxY = static_cast<int32_t>(std::floor((Query.Y + Query.MaxDistance) * InvCellSize));
+
+	Candidates.clear();
+	for (int32_t QueryY = MinY; QueryY <= MaxY; QueryY++)
+	{
+		for (int32_t QueryX = MinX; QueryX <= MaxX; QueryX++)
+		{
+			const auto Cell = Cells.find(GetCellKey(QueryX, QueryY));
+			if (Cell != Cells.end())
+			{
+				Candidates.insert(Candidates.end(), Cell->second.begin(), Cell->second.end());
+			}
+		}
+	}
+
+	std::sort(Candidates.begin(), Candidates.end()); // Ties go to the lowest handle, whatever order the cells were visited in
+
+	// Copy the candidates positions into the scratch columns, padded to whole groups of four whose lanes past the end are never picked
+	const int32_t NumCandidates = static_cast<int32_t>(Candidates.size());
+	const size_t NumPadded = (Candidates.size() + 3) & ~static_cast<size_t>(3);
+	Candidates.resize(NumPadded, -1);
+	CandidateX.resize(NumPadded);
+	CandidateY.resize(NumPadded);
+	CandidateZ.resize(NumPadded);
+	Scores.resize(NumPadded);
+	for (int32_t Candidate = 0; Candidate < NumCandidates; Candidate++)
+	{
+		const int32_t Target = Candidates[Candidate];
+		CandidateX[Candidate] = X[Target];
+		CandidateY[Candidate] = Y[Target];
+		CandidateZ[Candidate] = Z[Target];
+	}
+	return NumCandidates;
+}
+
+int32_t FHLtC_TargetIndex::PickBest(int32_t NumCandidates) const
+{
+	const auto Best = std::max_element(Scores.begin(), Scores.begin() + NumCandidates);
+	return Best != Scores.begin() + NumCandidates && *Best > -FLT_MAX ? Candidates[Best - Scores.begin()] : -1;
+}
+
+int32_t FHLtC_TargetIndex::FindBest(const FHLtC_TargetQuery& Query)
+{
+	const int32_t NumCandidates = GatherCandidates(Query);
+	const float InvMaxDistance = 1.0f / std::max(Query.MaxDistance, 1.0f);
+
+#if HLTC_TARGETING_SSE
+	// Four candidates a lane each, with the same operations as ScoreBest
+	const __m128 QueryX4 = _mm_set1_ps(Query.X);
+	const __m128 QueryY4 = _mm_set1_ps(Query.Y);
+	const __m128 QueryZ4 = _mm_set1_ps(Query.Z);
+	const __m128 ViewX4 = _mm_set1_ps(Query.ViewX);
+	const __m128 ViewY4 = _mm_set1_ps(Query.ViewY);
+	const __m128 MaxDistanceSquared4 = _mm_set1_ps(Query.MaxDistance * Query.MaxDistance);
+	const __m128 CosHalfCone4 = _mm_set1_ps(Query.CosHalfCone);
+	const __m128 InvMaxDistance4 = _mm_set1_ps(InvMaxDistance);
+	const __m128 MinDistance4 = _mm_set1_ps(1.e-3f);
+	const __m128 Two4 = _mm_set1_ps(2.0f);
+	const __m128 Lowest4 = _mm_set1_ps(-FLT_MAX);
+	const __m128i Ignore4 = _mm_set1_epi32(Query.Ignore);
+	for (int32_t First = 0; First < NumCandidates; First += 4)
+	{
+		const __m128 DeltaX = _mm_sub_ps(_mm_loadu_ps(CandidateX.data() + First), QueryX4);
+		const __m128 DeltaY = _mm_sub_ps(_mm_loadu_ps(CandidateY.data() + First), QueryY4);
+		const __m128 DeltaZ = _mm_sub_ps(_mm_loadu_ps(CandidateZ.data() + First), QueryZ4);
+		const __m128 HorizontalDistanceSquared = _mm_add_ps(_mm_mul_ps(DeltaX, DeltaX), _mm_mul_ps(DeltaY, DeltaY));
+		const __m128 DistanceSquared = _mm_add_ps(HorizontalDistanceSquared, _mm_mul_ps(DeltaZ, DeltaZ));
+
+		const __m128 Facing = _mm_div_ps(_mm_add_ps(_mm_mul_ps(ViewX4, DeltaX), _mm_mul_ps(ViewY4, DeltaY)), _mm_max_ps(_mm_sqrt_ps(HorizontalDistanceSquared), MinDistance4));
+		const __m128 Ignored = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Candidates.data() + First)), Ignore4));
+		const __m128 Valid = _mm_andnot_ps(Ignored, _mm_and_ps(_mm_cmple_ps(DistanceSquared, MaxDistanceSquared4), _mm_cmpge_ps(Facing, CosHalfCone4)));
+
+		const __m128 Score = _mm_sub_ps(_mm_mul_ps(Facing, Two4), _mm_mul_ps(_mm_sqrt_ps(DistanceSquared), InvMaxDistance4));
+		_mm_storeu_ps(Scores.data() + First, _mm_or_ps(_mm_and_ps(Valid, Score), _mm_andnot_ps(Valid, Lowest4)));
+	}
+#else
+	for (int32_t Candidate = 0; Candidate < NumCandidates; Candidate++)
+	{
+		Scores[Candidate] = ScoreBest(Query, InvMaxDistance, Candidates[Candidate], CandidateX[Candidate] - Query.X, CandidateY[Candidate] - Query.Y, CandidateZ[Candidate] - Query.Z);
+	}
+#endif
+
+	return PickBest(NumCandidates);
+}
+
+int32_t FHLtC_TargetIndex::FindNext(const FHLtC_TargetQuery& Query, int32_t Current, bool bRight)
+{
+	float ReferenceX;
+	float ReferenceY;
+	GetNextReference(Query, Current, ReferenceX, ReferenceY);
+
+	const int32_t NumCandidates = GatherCandidates(Query);
+	const float Side = bRight ? 1.0f : -1.0f;
+
+#if HLTC_TARGETING_SSE
+	// Four candidates a lane each, with the same operations as ScoreNext
+	const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 SignMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(0x80000000u)));
+	const __m128 QueryX4 = _mm_set1_ps(Query.X);
+	const __m128 QueryY4 = _mm_set1_ps(Query.Y);
+	const __m128 QueryZ4 = _mm_set1_ps(Query.Z);
+	const __m128 ReferenceX4 = _mm_set1_ps(ReferenceX);
+	const __m128 ReferenceY4 = _mm_set1_ps(ReferenceY);
+	const __m128 Side4 = _mm_set1_ps(Side);
+	const __m128 MaxDistanceSquared4 = _mm_set1_ps(Query.MaxDistance * Query.MaxDistance);
+	const __m128 Zero4 = _mm_setzero_ps();
+	const __m128 One4 = _mm_set1_ps(1.0f);
+	const __m128 Smallest4 = _mm_set1_ps(FLT_MIN);
+	const __m128 Lowest4 = _mm_set1_ps(-FLT_MAX);
+	const __m128i Ignore4 = _mm_set1_epi32(Query.Ignore);
+	const __m128i Current4 = _mm_set1_epi32(Current);
+	for (int32_t First = 0; First < NumCandidates; First += 4)
+	{
+		const __m128 DeltaX = _mm_sub_ps(_mm_loadu_ps(CandidateX.data() + First), QueryX4);
+		const __m128 DeltaY = _mm_sub_ps(_mm_loadu_ps(CandidateY.data() + First), QueryY4);
+		const __m128 DeltaZ = _mm_sub_ps(_mm_loadu_ps(CandidateZ.data() + First), QueryZ4);
+		const __m128 DistanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(DeltaX, DeltaX), _mm_mul_ps(DeltaY, DeltaY)), _mm_mul_ps(DeltaZ, DeltaZ));
+
+		const __m128 Cross = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ReferenceX4, DeltaY), _mm_mul_ps(ReferenceY4, DeltaX)), Side4);
+		const __m128 Dot = _mm_add_ps(_mm_mul_ps(ReferenceX4, DeltaX), _mm_mul_ps(ReferenceY4, DeltaY));
+		const __m128 Turn = _mm_sub_ps(One4, _mm_div_ps(Dot, _mm_max_ps(_mm_add_ps(_mm_and_ps(Cross, AbsMask), _mm_and_ps(Dot, AbsMask)), Smallest4)));
+
+		const __m128i Handles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Candidates.data() + First));
+		const __m128 Excluded = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(Handles, Ignore4), _mm_cmpeq_epi32(Handles, Current4)));
+		const __m128 ToSide = _mm_or_ps(_mm_cmpgt_ps(Cross, Zero4), _mm_and_ps(_mm_cmpeq_ps(Cross, Zero4), _mm_cmplt_ps(Dot, Zero4)));
+		const __m128 Valid = _mm_andnot_ps(Excluded, _mm_and_ps(_mm_cmple_ps(DistanceSquared, MaxDistanceSquared4), ToSide));
+
+		_mm_storeu_ps(Scores.data() + First, _mm_or_ps(_mm_and_ps(Valid, _mm_xor_ps(Turn, SignMask)), _mm_andnot_ps(Valid, Lowest4)));
+	}
+#else
+	for (int32_t Candidate = 0; Candidate < NumCandidates; Candidate++)
+	{
+		Scores[Candidate] = ScoreNext(Query, ReferenceX, ReferenceY, Side, Candidates[Candidate], Current,
+			CandidateX[Candidate] - Query.X, CandidateY[Candidate] - Query.Y, CandidateZ[Candidate] - Query.Z);
+	}
+#endif
+
+	return PickBest(NumCandidates);
+}
+
+int32_t FHLtC_TargetIndex::FindBestBruteForce(const FHLtC_TargetQuery& Query) const
+{
+	const float InvMaxDistance = 1.0f / std::max(Query.MaxDistance, 1.0f);
+	int32_t Best = -1;
+	float BestScore = -FLT_MAX;
+	for (int32_t Target = 0; Target < static_cast<int32_t>(Active.size()); Target++)
+	{
+		const float Score = Active[Target] != 0 ? ScoreBest(Query, InvMaxDistance, Target, X[Target] - Query.X, Y[Target] - Query.Y, Z[Target] - Query.Z) : -FLT_MAX;
+		if (Score > BestScore) // Ties go to the lowest handle, like FindBest
+		{
+			Best = Target;
+			BestScore = Score;
+		}
+	}
+	return Best;
+}
+
+int32_t FHLtC_TargetIndex::FindNextBruteForce(const FHLtC_TargetQuery& Query, int32_t Current, bool bRight) const
+{
+	float ReferenceX;
+	float ReferenceY;
+	GetNextReference(Query, Current, ReferenceX, ReferenceY);
+
+	const float Side = bRight ? 1.0f : -1.0f;
+	int32_t Best = -1;
+	float BestScore = -FLT_MAX;
+	for (int32_t Target = 0; Target < static_cast<int32_t>(Active.size()); Target++)
+	{
+		const float Score = Active[Target] != 0 ? ScoreNext(Query, ReferenceX, ReferenceY, Side, Target, Current, X[Target] - Query.X, Y[Target] - Query.Y, Z[Target] - Query.Z) : -FLT_MAX;
+		if (Score > BestScore)
+		{
+			Best = Target;
+			BestScore = Score;
+		}
+	}
+	return Best;
+}
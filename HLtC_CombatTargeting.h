@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Lock-on target selection. Engine independent, like the rest of the core.
+// Targets live in a spatial hash that's updated incrementally as they move, so a query only scores the targets around the seeker, four at a time with SSE where it's available.
+
+#include "HLtC_CombatCore.h"
+
+#include <unordered_map>
+
+/** Where and how a seeker looks for a target */
+struct FHLtC_TargetQuery
+{
+	float X = 0.0f;
+	float Y = 0.0f;
+	float Z = 0.0f;
+	float ViewX = 1.0f; // Horizontal view direction, normalized
+	float ViewY = 0.0f;
+	float MaxDistance = 1500.0f; // Targets further than this are never picked
+	float CosHalfCone = 0.5f; // Cosine of half the view cone new targets are picked from
+	int32_t Ignore = -1; // Target that can't be picked, usually the seekers own
+};
+
+/**
+ * Targetable positions in a spatial hash grid. Targets keep the handle they were added with until they're removed.
+ * Moving a target only touches the grid when it crosses into another cell, and queries don't allocate once the scratch buffers have grown.
+ */
+class FHLtC_TargetIndex
+{
+public:
+	float CellSize = 1000.0f; // Width of a grid cell. Best around the lock-on distance, and only changeable while the index is empty
+
+	int32_t Add(float X, float Y, float Z); // Returns the new targets handle
+	void Remove(int32_t Target);
+	void Update(int32_t Target, float X, float Y, float Z);
+
+	bool IsValid(int32_t Target) const { return Target >= 0 && Target < static_cast<int32_t>(Active.size()) && Active[Target] != 0; }
+	int32_t Num() const { return NumActive; }
+
+	/** Whether a target is still close enough to stay locked on to. Doesn't need the grid, so it's cheap enough to run every frame */
+	bool IsInRange(const FHLtC_TargetQuery& Query, int32_t Target, float BreakDistance) const;
+
+	/** Returns the best target in the queries cone, favouring targets close to the view direction and then close to the seeker. -1 if there's none */
+	int32_t FindBest(const FHLtC_TargetQuery& Query);
+
+	/** Returns the closest target by angle to the right (or left) of Current, as seen from the seeker. The cone doesn't apply. -1 if there's none */
+	int32_t FindNext(const FHLtC_TargetQuery& Query, int32_t Current, bool bRight);
+
+	/** Reference versions that score every target one at a time, for checking FindBest and FindNext */
+	int32_t FindBestBruteForce(const FHLtC_TargetQuery& Query) const;
+	int32_t FindNextBruteForce(const FHLtC_TargetQuery& Query, int32_t Current, bool bRight) const;
+
+private:
+	static uint64_t GetCellKey(int32_t CellX, int32_t CellY) { return static_cast<uint64_t>(static_cast<uint32_t>(CellX)) << 32 | static_cast<uint32_t>(CellY); }
+	uint64_t GetCellKey(float X, float Y) const;
+
+	void InsertIntoCell(int32_t Target, uint64_t CellKey);
+	void RemoveFromCell(int32_t Target);
+
+	/** Fills Candidates and the scratch columns with every target in the cells the query reaches, in handle order. Returns how many there are */
+	int32_t GatherCandidates(const FHLtC_TargetQuery& Query);
+	int32_t PickBest(int32_t NumCandidates) const; // Candidate with the highest score, -1 if none can be picked
+
+	void GetNextReference(const FHLtC_TargetQuery& Query, int32_t Current, float& OutX, float& OutY) const; // Direction FindNext measures turns from
+
+	// Targets, one array per field indexed by handle
+	std::vector<float> X;
+	std::vector<float> Y;
+	std::vector<float> Z;
+	std::vector<uint8_t> Active;
+	std::vector<uint64_t> CellKey; // Cell each target is in
+	std::vector<int32_t> CellSlot; // Index of each target in its cells list
+	std::vector<int32_t> FreeHandles;
+	int32_t NumActive = 0;
+
+	std::unordered_map<uint64_t, std::vector<int32_t>> Cells; // Targets of each occupied cell. Cells are erased when their last target leaves
+
+	// Per query scratch
+	std::vector<int32_t> Candidates; // Padded to whole groups of four with invalid handles
+	std::vector<float> CandidateX; // The candidates positions, one column per field, so groups of four load straight into SIMD registers
+	std::vector<float> CandidateY;
+	std::vector<float> CandidateZ;
+	std::vector<float> Scores;
+};
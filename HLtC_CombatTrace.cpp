@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatTrace.h"
+
+DEFINE_STAT(STAT_HLtCCombat_Tick);
+DEFINE_STAT(STAT_HLtCCombat_StepWorld);
+DEFINE_STAT(STAT_HLtCCombat_ResolveHits);
+DEFINE_STAT(STAT_HLtCCombat_UpdateSignificance);
+DEFINE_STAT(STAT_HLtCCombat_WriteBack);
+DEFINE_STAT(STAT_HLtCCombat_ApplyStateDefaults);
+DEFINE_STAT(STAT_HLtCCombat_AttackInput);
+DEFINE_STAT(STAT_HLtCCombat_BlockInput);
+DEFINE_STAT(STAT_HLtCCombat_LockOnUpdate);
+DEFINE_STAT(STAT_HLtCCombat_LockOnQuery);
+DEFINE_STAT(STAT_HLtCCombat_BotDecisions);
+DEFINE_STAT(STAT_HLtCCombat_BotInput);
+DEFINE_STAT(STAT_HLtCCombat_ValidationSync);
+DEFINE_STAT(STAT_HLtCCombat_ValidateInputs);
+
+DEFINE_STAT(STAT_HLtCCombat_AttacksStarted);
+DEFINE_STAT(STAT_HLtCCombat_AttacksBuffered);
+DEFINE_STAT(STAT_HLtCCombat_AttacksDropped);
+DEFINE_STAT(STAT_HLtCCombat_ChainResets);
+DEFINE_STAT(STAT_HLtCCombat_ActionTransitions);
+DEFINE_STAT(STAT_HLtCCombat_Allocations);
+DEFINE_STAT(STAT_HLtCCombat_NetCorrections);
+DEFINE_STAT(STAT_HLtCCombat_InputsValidated);
+DEFINE_STAT(STAT_HLtCCombat_NetDesyncs);
+DEFINE_STAT(STAT_HLtCCombat_CheatsDetected);
+
+#if !UE_BUILD_SHIPPING
+	UE_TRACE_CHANNEL_DEFINE(CombatChannel);
+#endif
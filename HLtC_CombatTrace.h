@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Stat group and trace channel of the combat code, for stat HLtCCombat and Unreal Insights (-trace=cpu,counters,combat).
+// Everything here compiles out of Shipping builds.
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("HLtC Combat"), STATGROUP_HLtCCombat, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulation Tick"), STAT_HLtCCombat_Tick, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Step World"), STAT_HLtCCombat_StepWorld, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Hits"), STAT_HLtCCombat_ResolveHits, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Significance"), STAT_HLtCCombat_UpdateSignificance, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write Back"), STAT_HLtCCombat_WriteBack, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply State Defaults"), STAT_HLtCCombat_ApplyStateDefaults, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Attack Input"), STAT_HLtCCombat_AttackInput, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Block Input"), STAT_HLtCCombat_BlockInput, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lock-On Update"), STAT_HLtCCombat_LockOnUpdate, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lock-On Query"), STAT_HLtCCombat_LockOnQuery, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bot Decisions"), STAT_HLtCCombat_BotDecisions, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bot Input"), STAT_HLtCCombat_BotInput, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Validation Sync"), STAT_HLtCCombat_ValidationSync, STATGROUP_HLtCCombat, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Validate Inputs"), STAT_HLtCCombat_ValidateInputs, STATGROUP_HLtCCombat, );
+
+// One per HLtC::ECombatCounter, reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Attacks Started"), STAT_HLtCCombat_AttacksStarted, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Attacks Buffered"), STAT_HLtCCombat_AttacksBuffered, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Attacks Dropped"), STAT_HLtCCombat_AttacksDropped, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Chain Resets"), STAT_HLtCCombat_ChainResets, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Action Transitions"), STAT_HLtCCombat_ActionTransitions, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Allocations"), STAT_HLtCCombat_Allocations, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Corrections"), STAT_HLtCCombat_NetCorrections, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Inputs Validated"), STAT_HLtCCombat_InputsValidated, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Desyncs"), STAT_HLtCCombat_NetDesyncs, STATGROUP_HLtCCombat, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cheats Detected"), STAT_HLtCCombat_CheatsDetected, STATGROUP_HLtCCombat, );
+
+#if !UE_BUILD_SHIPPING
+	UE_TRACE_CHANNEL_EXTERN(CombatChannel);
+
+	/** Stat cycle counter plus an Insights CPU scope on the combat channel, so the scope only costs anything in a trace when the channel is on */
+	#define HLTC_COMBAT_SCOPE(Stat) \
+		SCOPE_CYCLE_COUNTER(Stat); \
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, CombatChannel)
+#else
+	#define HLTC_COMBAT_SCOPE(Stat)
+#endif
@@ -0,0 +1,18 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatTuningAsset.h"
+
+const FHLtC_StateDefaults& UHLtC_CombatTuningAsset::GetStateDefaults(EHLtC_ControlState ControlState, EHLtC_PlayerAction Action, EHLtC_CameraState CameraState) const
+{
+	if (ControlState == EHLtC_ControlState::Action)
+	{
+		return CameraState == EHLtC_CameraState::Focus ? ActionFocus : ActionFree;
+	}
+
+	switch (Action)
+	{
+	case EHLtC_PlayerAction::Moving: return SlowMoving;
+	case EHLtC_PlayerAction::Sprinting: return SlowSprinting;
+	default: return SlowIdle;
+	}
+}
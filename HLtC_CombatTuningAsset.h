@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "HLtC_CombatStateMachine.h"
+#include "HLtC_CombatTuningAsset.generated.h"
+
+/** The values applied to the character and camera boom whenever a control/action/camera state combination is entered */
+USTRUCT(BlueprintType)
+struct FHLtC_StateDefaults
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = State, meta = (ClampMin = "0"))
+	float MoveSpeed = 400.0f; // Move speed of the player in this state
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = State, meta = (ClampMin = "0"))
+	float ArmLength = 300.0f; // Target boom arm length in this state
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = State)
+	FVector SocketOffset = FVector(0.0f, 0.0f, 50.0f); // Target camera offset on the end of the camera boom in this state
+};
+
+/**
+ * Tuning shared by every character of an archetype. Characters only point at it and never write to it, so a crowd of the same archetype shares one copy.
+ * Characters without an asset use the class default object, which holds the built-in values.
+ */
+UCLASS(BlueprintType)
+class UHLtC_CombatTuningAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// "Slow" picks the defaults by action and ignores the camera, "Action" picks them by camera state and ignores the action
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States)
+	FHLtC_StateDefaults SlowIdle = { 200.0f, 175.0f, FVector(0.0f, 50.0f, 75.0f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States)
+	FHLtC_StateDefaults SlowMoving = { 200.0f, 225.0f, FVector(0.0f, 50.0f, 75.0f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States)
+	FHLtC_StateDefaults SlowSprinting = { 200.0f, 275.0f, FVector(0.0f, 50.0f, 75.0f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States)
+	FHLtC_StateDefaults ActionFree = { 400.0f, 300.0f, FVector(0.0f, 0.0f, 50.0f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States)
+	FHLtC_StateDefaults ActionFocus = { 400.0f, 350.0f, FVector(0.0f, 0.0f, 100.0f) };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = States, meta = (ClampMin = "0"))
+	float SprintSpeedAddition = 200.0f; // Added to player speed when sprinting
+
+	// Camera rig
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "0"))
+	float ArmLengthSmoothing = 2.5f; // Rate the arm length closes in on its target, per second
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "0"))
+	float SocketOffsetSmoothing = 10.0f; // Rate the socket offset closes in on its target, per second
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "0"))
+	float ShakeAmplitude = 0.1f; // Fraction of the socket offset the shake swings it by either way, doubled
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	float ShakeDeltaTimeDivision[2] = { 2.0f, 1.2f }; // Slow down the shake while "Moving" and "Sprinting" respectively. Larger values shake slower
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "0"))
+	float SettleTolerance = 0.5f; // How close the boom has to get to its targets before the rig goes to sleep
+
+	/** Returns the defaults of a state combination. Actions other than the locomotion ones use the "Idle" defaults */
+	const FHLtC_StateDefaults& GetStateDefaults(EHLtC_ControlState ControlState, EHLtC_PlayerAction Action, EHLtC_CameraState CameraState) const;
+
+	const FHLtC_StateDefaults& GetStateDefaults(const FHLtC_CombatStateMachine& States) const { return GetStateDefaults(States.ControlState, States.Action, States.CameraState); }
+
+	/** Returns the shared tuning of an archetype, the built-in tuning for null */
+	static const UHLtC_CombatTuningAsset& Get(const UHLtC_CombatTuningAsset* Asset) { return Asset ? *Asset : *GetDefault<UHLtC_CombatTuningAsset>(); }
+};
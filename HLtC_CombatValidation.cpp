@@ -0,0 +1,371 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_CombatValidation.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr EHLtC_AttackType GetClaimAttackType(EHLtC_InputEvent Type)
+	{
+		return Type == EHLtC_InputEvent::HeavyAttack ? EHLtC_AttackType::Heavy : EHLtC_AttackType::Light;
+	}
+
+	constexpr bool IsAttackEvent(EHLtC_InputEvent Type) { return Type == EHLtC_InputEvent::LightAttack || Type == EHLtC_InputEvent::HeavyAttack; }
+}
+
+const char* HLtC::GetVerdictName(EHLtC_InputVerdict Verdict)
+{
+	static const char* const Names[static_cast<int32_t>(EHLtC_InputVerdict::Count)] = { "Valid", "Desync", "CheatMove", "CheatChainOrder", "CheatTiming" };
+	return Verdict < EHLtC_InputVerdict::Count ? Names[static_cast<int32_t>(Verdict)] : "";
+}
+
+FHLtC_InputClaim HLtC::MakeInputClaim(const FHLtC_CombatWorld& World, int32_t Index, EHLtC_InputEvent Type)
+{
+	FHLtC_InputClaim Claim;
+	Claim.Type = Type;
+
+	if (IsAttackEvent(Type)) // Entered now or once the buffer window opens, the cursor moves on to the same move
+	{
+		Claim.Move = World.MoveTable->GetNextMove(World.GetAttackCursor(Index), GetClaimAttackType(Type));
+	}
+
+	else if (IsValidatedInput(Type))
+	{
+		const bool bBlock = Type == EHLtC_InputEvent::BlockStarted;
+		Claim.bChanged = !World.HasFlag(Index, Flag_StaticAction) && World.HasFlag(Index, Flag_Blocking) != bBlock;
+	}
+
+	return Claim;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_InputClaimQueue
+
+FHLtC_InputClaimQueue::FHLtC_InputClaimQueue(uint32_t InCapacity)
+{
+	uint32_t Capacity = 2;
+	while (Capacity < InCapacity && Capacity < (1u << 30))
+	{
+		Capacity <<= 1;
+	}
+
+	Slots.reset(new FSlot[Capacity]);
+	Mask = Capacity - 1;
+	for (uint32_t Slot = 0; Slot < Capacity; Slot++)
+	{
+		Slots[Slot].Sequence.store(Slot, std::memory_order_relaxed); // A slot is free to write while its sequence equals the position writing it
+	}
+}
+
+bool FHLtC_InputClaimQueue::Push(const FHLtC_InputClaim& Claim)
+{
+	uint32_t Position = Head.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		FSlot& Slot = Slots[Position & Mask];
+		const int32_t Lag = static_cast<int32_t>(Slot.Sequence.load(std::memory_order_acquire) - Position);
+		if (Lag == 0)
+		{
+			if (Head.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) // The slot is ours once the head moves past it
+			{
+				Slot.Claim = Claim;
+				Slot.Sequence.store(Position + 1, std::memory_order_release); // Publishes the claim
+				return true;
+			}
+		}
+
+		else if (Lag < 0) // The consumer hasn't freed the slot from the previous lap yet
+		{
+			return false;
+		}
+
+		else // Another producer took the slot, try the next one
+		{
+			Position = Head.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool FHLtC_InputClaimQueue::Pop(FHLtC_InputClaim& OutClaim)
+{
+	FSlot& Slot = Slots[Tail & Mask];
+	if (Slot.Sequence.load(std::memory_order_acquire) != Tail + 1) // Empty, or its producer is still writing
+	{
+		return false;
+	}
+
+	OutClaim = Slot.Claim;
+	Slot.Sequence.store(Tail + Mask + 1, std::memory_order_release); // Hands the slot to the producer of the next lap
+	Tail++;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_InputValidator
+
+void FHLtC_InputValidator::UpdateLinks()
+{
+	if (static_cast<int32_t>(LinkedBy.size()) == MoveTable->NumMoves() && NumLinkedWeapons == MoveTable->NumWeapons())
+	{
+		return;
+	}
+
+	// Moves only ever lead to moves of the same weapon, so every move belongs to the weapon whose entries reach it
+	LinkedBy.assign(MoveTable->NumMoves(), 0);
+	MoveWeapons.assign(MoveTable->NumMoves(), 0xFF);
+	std::vector<uint16_t> Pending;
+	for (int32_t Weapon = 0; Weapon < MoveTable->NumWeapons(); Weapon++)
+	{
+		Pending.clear();
+		const FHLtC_AttackCursor Entry = { HLtC::InvalidMove, static_cast<uint8_t>(Weapon) };
+		for (const EHLtC_AttackType Type : { EHLtC_AttackType::Light, EHLtC_AttackType::Heavy })
+		{
+			const uint16_t Move = MoveTable->GetNextMove(Entry, Type);
+			if (Move != HLtC::InvalidMove)
+			{
+				LinkedBy[Move] |= static_cast<uint8_t>(1 << HLtC::GetLinkIndex(Type));
+				Pending.push_back(Move);
+			}
+		}
+
+		for (size_t Cursor = 0; Cursor < Pending.size(); Cursor++)
+		{
+			const uint16_t Move = Pending[Cursor];
+			if (MoveWeapons[Move] != 0xFF)
+			{
+				continue;
+			}
+
+			MoveWeapons[Move] = static_cast<uint8_t>(Weapon);
+			for (int32_t Link = 0; Link < 2; Link++)
+			{
+				const uint16_t Next = MoveTable->GetMove(Move).Next[Link];
+				if (Next != HLtC::InvalidMove)
+				{
+					LinkedBy[Next] |= static_cast<uint8_t>(1 << Link);
+					Pending.push_back(Next);
+				}
+			}
+		}
+	}
+	NumLinkedWeapons = MoveTable->NumWeapons();
+}
+
+void FHLtC_InputValidator::BeginBatch(const FHLtC_CombatWorld& World, double WorldTime, const FHLtC_InputClaim* InClaims, int32_t NumClaims)
+{
+	MoveTable = World.MoveTable;
+	UpdateLinks();
+
+	Claims.clear();
+	for (int32_t Index = 0; Index < NumClaims; Index++)
+	{
+		if (InClaims[Index].Combatant >= 0 && InClaims[Index].Combatant < World.Num() && HLtC::IsValidatedInput(InClaims[Index].Type))
+		{
+			Claims.push_back(InClaims[Index]);
+		}
+	}
+	std::stable_sort(Claims.begin(), Claims.end(), [](const FHLtC_InputClaim& A, const FHLtC_InputClaim& B) { return A.Combatant < B.Combatant; }); // Arrival order within each combatant
+	Verdicts.assign(Claims.size(), EHLtC_InputVerdict::Valid);
+
+	GroupStarts.clear();
+	Timelines.clear();
+	for (int32_t Claim = 0; Claim < static_cast<int32_t>(Claims.size()); Claim++)
+	{
+		const int32_t Index = Claims[Claim].Combatant;
+		if (Claim > 0 && Claims[Claim - 1].Combatant == Index)
+		{
+			continue;
+		}
+
+		GroupStarts.push_back(Claim);
+
+		FTimeline& Timeline = Timelines.emplace_back();
+		Timeline.bStatic = World.HasFlag(Index, HLtC::Flag_StaticAction);
+		Timeline.StaticEnd = WorldTime + static_cast<double>(World.StaticActionEnd[Index] - World.Clock) / HLtC::TimeUnitsPerSecond;
+		Timeline.BufferOpen = Timeline.StaticEnd - World.AdditionalAttackBufferTiming[Index];
+		Timeline.Move = World.AttackMove[Index];
+		Timeline.Weapon = World.Weapon[Index];
+		Timeline.bBlocking = World.HasFlag(Index, HLtC::Flag_Blocking);
+		Timeline.bPendingDodge = World.HasFlag(Index, HLtC::Flag_DodgeBuffered);
+		Timeline.PendingDodge = World.BufferedDodge[Index];
+		Timeline.PendingMove = World.HasFlag(Index, HLtC::Flag_AttackBuffered) ? MoveTable->GetNextMove(World.GetAttackCursor(Index), World.CurrentAttackType[Index]) : HLtC::InvalidMove;
+	}
+	GroupStarts.push_back(static_cast<int32_t>(Claims.size()));
+}
+
+void FHLtC_InputValidator::StartMove(FTimeline& Timeline, uint16_t MoveIndex, double Time) const
+{
+	const FHLtC_CompiledMove& Move = MoveTable->GetMove(MoveIndex);
+	Timeline.Move = MoveIndex;
+	Timeline.StaticEnd = Time + Move.Duration;
+	Timeline.BufferOpen = Timeline.StaticEnd - Move.BufferTime;
+	Timeline.PendingMove = HLtC::InvalidMove;
+	Timeline.bStatic = true;
+	Timeline.bPendingDodge = false;
+	Timeline.bBlocking = false; // Attacking drops the guard
+}
+
+void FHLtC_InputValidator::AdvanceTo(FTimeline& Timeline, double Time) const
+{
+	// Follows FHLtC_CombatWorld::ResolveCombatant through every deadline before Time
+	while (Timeline.bStatic)
+	{
+		if (Timeline.BufferOpen <= Time && Timeline.BufferOpen < Timeline.StaticEnd && Timeline.bPendingDodge)
+		{
+			const FHLtC_CompiledDodge& Dodge = MoveTable->GetDodge(Timeline.Weapon, Timeline.PendingDodge);
+			const double Start = Timeline.BufferOpen;
+			Timeline.Move = HLtC::InvalidMove; // A dodge ends the chain
+			Timeline.StaticEnd = Start + Dodge.Duration;
+			Timeline.BufferOpen = Timeline.StaticEnd - Dodge.BufferTime;
+			Timeline.bPendingDodge = false;
+			Timeline.bBlocking = false;
+		}
+
+		else if (Timeline.BufferOpen <= Time && Timeline.BufferOpen < Timeline.StaticEnd && Timeline.PendingMove != HLtC::InvalidMove)
+		{
+			StartMove(Timeline, Timeline.PendingMove, Timeline.BufferOpen);
+		}
+
+		else
+		{
+			if (Timeline.StaticEnd <= Time)
+			{
+				Timeline.bStatic = false;
+				Timeline.Move = HLtC::InvalidMove;
+				Timeline.PendingMove = HLtC::InvalidMove;
+				Timeline.bPendingDodge = false;
+			}
+			break;
+		}
+	}
+}
+
+uint16_t FHLtC_InputValidator::ApplyAttack(FTimeline& Timeline, EHLtC_AttackType Type, double Time) const
+{
+	// Follows FHLtC_CombatWorld::TryAttackAt
+	AdvanceTo(Timeline, Time);
+	const uint16_t NextMove = MoveTable->GetNextMove({ Timeline.Move, Timeline.Weapon }, Type);
+	if (NextMove == HLtC::InvalidMove)
+	{
+		return NextMove;
+	}
+
+	if (!Timeline.bStatic || Timeline.BufferOpen <= Time)
+	{
+		StartMove(Timeline, NextMove, Time);
+	}
+
+	else
+	{
+		Timeline.PendingMove = NextMove;
+		Timeline.bPendingDodge = false;
+	}
+	return NextMove;
+}
+
+bool FHLtC_InputValidator::ApplyBlock(FTimeline& Timeline, bool bBlock, double Time) const
+{
+	// Follows FHLtC_CombatWorld::SetBlocking
+	AdvanceTo(Timeline, Time);
+	if (Timeline.bStatic || Timeline.bBlocking == bBlock)
+	{
+		return false;
+	}
+
+	Timeline.bBlocking = bBlock;
+	return true;
+}
+
+EHLtC_InputVerdict FHLtC_InputValidator::Check(FTimeline& Timeline, const FHLtC_InputClaim& Claim) const
+{
+	// The timeline moves on with the rules. A copy of it Tolerance later is what an honest client running a little ahead could have seen
+	FTimeline Late = Timeline;
+	const double LateTime = Claim.Time + Tolerance;
+
+	if (!IsAttackEvent(Claim.Type))
+	{
+		const bool bBlock = Claim.Type == EHLtC_InputEvent::BlockStarted;
+		AdvanceTo(Timeline, Claim.Time);
+		const bool bStaticBefore = Timeline.bStatic;
+		const bool bChanged = ApplyBlock(Timeline, bBlock, Claim.Time);
+		if ((Claim.bChanged != 0) == bChanged)
+		{
+			return EHLtC_InputVerdict::Valid;
+		}
+
+		if ((Claim.bChanged != 0) == ApplyBlock(Late, bBlock, LateTime))
+		{
+			return EHLtC_InputVerdict::Desync;
+		}
+
+		return Claim.bChanged && bStaticBefore && Late.bStatic ? EHLtC_InputVerdict::CheatTiming : EHLtC_InputVerdict::Desync; // Blocking out of the middle of an attack
+	}
+
+	const EHLtC_AttackType Type = GetClaimAttackType(Claim.Type);
+	const uint16_t Expected = ApplyAttack(Timeline, Type, Claim.Time);
+	if (Claim.Move == Expected)
+	{
+		return EHLtC_InputVerdict::Valid;
+	}
+
+	if (Claim.Move == HLtC::InvalidMove) // Claims less than the rules gave it
+	{
+		return EHLtC_InputVerdict::Desync;
+	}
+
+	if (Claim.Move >= MoveTable->NumMoves() || MoveTable->GetMove(Claim.Move).Action != HLtC::GetAttackAction(Type) || (LinkedBy[Claim.Move] & (1 << HLtC::GetLinkIndex(Type))) == 0)
+	{
+		return EHLtC_InputVerdict::CheatMove;
+	}
+
+	AdvanceTo(Late, LateTime);
+	const uint16_t LateCurrent = Late.Move;
+	const uint16_t LateExpected = ApplyAttack(Late, Type, LateTime);
+	if (Claim.Move == LateExpected)
+	{
+		return EHLtC_InputVerdict::Desync;
+	}
+
+	if (MoveWeapons[Claim.Move] != Timeline.Weapon)
+	{
+		return EHLtC_InputVerdict::CheatChainOrder;
+	}
+
+	// How deep into the chain the press could have got by the time the tolerance runs out
+	const int32_t ClaimedDepth = MoveTable->GetMove(Claim.Move).ChainIndex;
+	if (LateExpected == HLtC::InvalidMove) // The chain has no move for this press, whatever the client says
+	{
+		const int32_t CurrentDepth = LateCurrent != HLtC::InvalidMove ? MoveTable->GetMove(LateCurrent).ChainIndex : -1;
+		return ClaimedDepth > CurrentDepth ? EHLtC_InputVerdict::CheatChainOrder : EHLtC_InputVerdict::Desync;
+	}
+
+	const int32_t ReachableDepth = MoveTable->GetMove(LateExpected).ChainIndex;
+	return ClaimedDepth > ReachableDepth + 1 ? EHLtC_InputVerdict::CheatChainOrder // Skips moves
+		: ClaimedDepth > ReachableDepth ? EHLtC_InputVerdict::CheatTiming // A press ahead, through a buffer window that hadn't opened
+		: EHLtC_InputVerdict::Desync; // Behind, e.g. the client let its chain run out early
+}
+
+void FHLtC_InputValidator::ValidateRange(int32_t Begin, int32_t End)
+{
+	uint32_t NumDesyncs = 0;
+	uint32_t NumCheats = 0;
+	for (int32_t Group = Begin; Group < End; Group++)
+	{
+		FTimeline& Timeline = Timelines[Group];
+		for (int32_t Claim = GroupStarts[Group]; Claim < GroupStarts[Group + 1]; Claim++)
+		{
+			const EHLtC_InputVerdict Verdict = Check(Timeline, Claims[Claim]);
+			Verdicts[Claim] = Verdict;
+			NumDesyncs += Verdict == EHLtC_InputVerdict::Desync;
+			NumCheats += HLtC::IsCheatVerdict(Verdict);
+		}
+	}
+
+	if (Begin < End) // Once per range rather than per claim, so the threads checking a batch don't all contend on the counters
+	{
+		HLtC::IncrementCounter(HLtC::Counter_InputsValidated, static_cast<uint32_t>(GroupStarts[End] - GroupStarts[Begin]));
+		HLtC::IncrementCounter(HLtC::Counter_NetDesyncs, NumDesyncs);
+		HLtC::IncrementCounter(HLtC::Counter_CheatsDetected, NumCheats);
+	}
+}
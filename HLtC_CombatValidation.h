@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Server side checks of what clients claim their attack and block input did. Engine independent, like the rest of the core.
+// The server simulates every input itself, so a claim never changes the fight. It tells an honest client that drifted (a desync) apart from one that
+// claims what the rules can't give it (a cheat). Claims are checked in batches, each combatants in the order they arrived, so batches of different
+// combatants can be checked on any thread.
+
+#include "HLtC_CombatCore.h"
+
+#include <atomic>
+#include <memory>
+
+/** What a client claims one of its inputs did, as its own prediction saw it when the input was given */
+struct FHLtC_InputClaim
+{
+	double Time = 0.0; // When the server received the input, on the clock its input events are stamped with
+	int32_t Combatant = -1;
+	uint16_t Move = HLtC::InvalidMove; // Attacks: move the press entered or buffered, HLtC::InvalidMove if it was dropped
+	EHLtC_InputEvent Type = EHLtC_InputEvent::LightAttack; // Attack and block events only
+	uint8_t bChanged = 0; // Blocks: the press started or ended blocking
+};
+
+/** Outcome of checking a claim */
+enum class EHLtC_InputVerdict : uint8_t
+{
+	Valid,
+	Desync, // The rules allow the claim, but not at the time the input arrived. The clients prediction is off and gets corrected
+	CheatMove, // The claim names a move that doesn't exist, or one the press can't lead to (a light press entering a heavy move)
+	CheatChainOrder, // The claimed move isn't the next one of any chain from where the combatant is, e.g. skipping moves or running past the end of the chain
+	CheatTiming, // The claim is ahead of the timeline by more than the tolerance: a move entered before the previous one's buffer window opened, or a block changed during a static action
+	Count
+};
+
+namespace HLtC
+{
+	constexpr bool IsValidatedInput(EHLtC_InputEvent Type) { return Type <= EHLtC_InputEvent::BlockCompleted; }
+	constexpr bool IsCheatVerdict(EHLtC_InputVerdict Verdict) { return Verdict >= EHLtC_InputVerdict::CheatMove; }
+
+	const char* GetVerdictName(EHLtC_InputVerdict Verdict);
+
+	/** Claim for an input the combatant gets now, as the owning client sends it along with the input. Time and Combatant are left to the server */
+	FHLtC_InputClaim MakeInputClaim(const FHLtC_CombatWorld& World, int32_t Index, EHLtC_InputEvent Type);
+}
+
+/**
+ * Fixed capacity, lock-free queue of claims. Any number of threads may push while one thread drains it. Nothing allocates after construction.
+ * Each slot carries a sequence number, so producers claim slots with a single compare-and-swap and the consumer never waits on a producer that's still writing.
+ */
+class FHLtC_InputClaimQueue
+{
+public:
+	explicit FHLtC_InputClaimQueue(uint32_t InCapacity = 4096); // Rounded up to a power of two
+
+	/** Any thread. Returns false and drops the claim if the queue is full */
+	bool Push(const FHLtC_InputClaim& Claim);
+
+	/** Consumer only. Removes the oldest claim into OutClaim, returns false if the queue is empty */
+	bool Pop(FHLtC_InputClaim& OutClaim);
+
+	uint32_t GetCapacity() const { return Mask + 1; }
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint32_t> Sequence;
+		FHLtC_InputClaim Claim;
+	};
+
+	std::unique_ptr<FSlot[]> Slots;
+	uint32_t Mask;
+	alignas(64) std::atomic<uint32_t> Head{ 0 }; // Next slot a producer claims. Kept on its own cache line from Tail
+	alignas(64) uint32_t Tail = 0; // Next slot the consumer reads
+};
+
+/**
+ * Checks a batch of claims against the authoritative timeline of each combatant.
+ * The timeline starts from the world as it was before the inputs of the batch were stepped, and moves on through every claimed input the way the
+ * simulation would, deadlines and buffered moves included. It always follows the rules rather than the claim, so a bad claim can't throw off the next ones.
+ */
+class FHLtC_InputValidator
+{
+public:
+	float Tolerance = 0.1f; // Seconds a claim may run ahead of the timeline, for jitter in when inputs arrive, before it counts as a cheat
+
+	/**
+	 * Starts a batch. Groups the claims by combatant, keeping the order each one's arrived in, and takes the timeline of every combatant with a claim
+	 * from World, whose clock lines up with WorldTime on the claims clock. Claims of combatants the world doesn't have are dropped. Not during ValidateRange
+	 */
+	void BeginBatch(const FHLtC_CombatWorld& World, double WorldTime, const FHLtC_InputClaim* InClaims, int32_t NumClaims);
+
+	int32_t NumGroups() const { return static_cast<int32_t>(GroupStarts.size()) - 1; } // Combatants with claims in the batch
+
+	/** Checks the claims of groups [Begin, End). Disjoint ranges can be checked concurrently, with the same results as checking them in one go */
+	void ValidateRange(int32_t Begin, int32_t End);
+
+	void Validate() { ValidateRange(0, NumGroups()); }
+
+	// The batch, grouped by combatant. Verdicts are only meaningful once every group has been checked
+	const std::vector<FHLtC_InputClaim>& GetClaims() const { return Claims; }
+	const std::vector<EHLtC_InputVerdict>& GetVerdicts() const { return Verdicts; }
+
+private:
+	/** Where a combatant is, on the claims clock */
+	struct FTimeline
+	{
+		double StaticEnd = 0.0; // When the static action concludes
+		double BufferOpen = 0.0; // When the buffered move or dodge starts
+		uint16_t Move = HLtC::InvalidMove;
+		uint16_t PendingMove = HLtC::InvalidMove; // Buffered attack
+		uint8_t Weapon = 0;
+		EHLtC_DodgeDirection PendingDodge = EHLtC_DodgeDirection::Forward;
+		bool bStatic = false;
+		bool bPendingDodge = false;
+		bool bBlocking = false;
+	};
+
+	void AdvanceTo(FTimeline& Timeline, double Time) const; // Passes the deadlines before Time: buffered moves start, static actions conclude
+	uint16_t ApplyAttack(FTimeline& Timeline, EHLtC_AttackType Type, double Time) const; // Returns the move the attack enters or buffers
+	bool ApplyBlock(FTimeline& Timeline, bool bBlock, double Time) const; // Returns true if blocking changed
+	void StartMove(FTimeline& Timeline, uint16_t MoveIndex, double Time) const;
+	EHLtC_InputVerdict Check(FTimeline& Timeline, const FHLtC_InputClaim& Claim) const;
+	void UpdateLinks(); // Marks the moves each link type leads to, for the moves added to the table since the last batch
+
+	const FHLtC_MoveTable* MoveTable = nullptr;
+	std::vector<FHLtC_InputClaim> Claims;
+	std::vector<EHLtC_InputVerdict> Verdicts;
+	std::vector<int32_t> GroupStarts; // First claim of each group, and one past the last claim at the end
+	std::vector<FTimeline> Timelines; // One per group
+	std::vector<uint8_t> LinkedBy; // Per move: bit 0 if a light press can lead to it, bit 1 for a heavy press
+	std::vector<uint8_t> MoveWeapons; // Per move: the weapon whose entries lead to it, 0xFF for none
+	int32_t NumLinkedWeapons = 0;
+};
@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_DodgeRootMotionSource.h"
+#include "HLtC_CombatCore.h"
+
+FHLtC_RootMotionSource_Dodge::FHLtC_RootMotionSource_Dodge()
+{
+	InstanceName = TEXT("HLtC_Dodge");
+	AccumulateMode = ERootMotionAccumulateMode::Override; // The dodge alone moves the character, static actions take no movement input
+	FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::SetVelocity; // Stops dead at the end rather than sliding on
+	FinishVelocityParams.SetVelocity = FVector::ZeroVector;
+}
+
+void FHLtC_RootMotionSource_Dodge::SetDodge(const FHLtC_MoveTable& MoveTable, const FHLtC_CompiledDodge& Dodge)
+{
+	Duration = Dodge.Duration;
+	Samples.SetNum(static_cast<int32>(Dodge.NumSamples));
+	for (int32 Index = 0; Index < Samples.Num(); Index++) // Sampling at the sample times gives the samples back exactly
+	{
+		const FHLtC_RootMotionSample RootMotion = MoveTable.SampleRootMotion(Dodge, Dodge.Duration * static_cast<float>(Index) / static_cast<float>(Samples.Num() - 1));
+		Samples[Index] = FVector2f(RootMotion.Forward, RootMotion.Right);
+	}
+}
+
+FVector2f FHLtC_RootMotionSource_Dodge::Sample(float Time) const
+{
+	// Same interpolation as FHLtC_MoveTable::SampleRootMotion
+	const float Position = FMath::Clamp(Time / Duration, 0.0f, 1.0f) * static_cast<float>(Samples.Num() - 1);
+	const int32 From = FMath::Min(static_cast<int32>(Position), Samples.Num() - 2);
+	return FMath::Lerp(Samples[From], Samples[From + 1], Position - static_cast<float>(From));
+}
+
+FRootMotionSource* FHLtC_RootMotionSource_Dodge::Clone() const
+{
+	return new FHLtC_RootMotionSource_Dodge(*this);
+}
+
+bool FHLtC_RootMotionSource_Dodge::Matches(const FRootMotionSource* Other) const
+{
+	if (!FRootMotionSource::Matches(Other)) // Checks the type as well
+	{
+		return false;
+	}
+
+	const FHLtC_RootMotionSource_Dodge* OtherDodge = static_cast<const FHLtC_RootMotionSource_Dodge*>(Other);
+	return Samples.Num() == OtherDodge->Samples.Num() && FMath::IsNearlyEqual(Yaw, OtherDodge->Yaw, 0.1f);
+}
+
+bool FHLtC_RootMotionSource_Dodge::MatchesAndHasSameState(const FRootMotionSource* Other) const
+{
+	return FRootMotionSource::MatchesAndHasSameState(Other) && Matches(Other);
+}
+
+bool FHLtC_RootMotionSource_Dodge::UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup)
+{
+	return FRootMotionSource::UpdateStateFrom(SourceToTakeStateFrom, bMarkForSimulatedCatchup);
+}
+
+void FHLtC_RootMotionSource_Dodge::PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent)
+{
+	RootMotionParams.Clear();
+
+	if (Duration > UE_SMALL_NUMBER && MovementTickTime > UE_SMALL_NUMBER && Samples.Num() >= 2)
+	{
+		// The displacement the samples cover over the simulated time, as the velocity that moves it within the movement tick
+		const FVector2f Delta = Sample(FMath::Min(GetTime() + SimulationTime, Duration)) - Sample(GetTime());
+		const FVector Force = FRotator(0.0f, Yaw, 0.0f).RotateVector(FVector(Delta.X, Delta.Y, 0.0f)) / MovementTickTime;
+		RootMotionParams.Set(FTransform(Force));
+	}
+
+	SetTime(GetTime() + SimulationTime);
+}
+
+bool FHLtC_RootMotionSource_Dodge::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	if (!FRootMotionSource::NetSerialize(Ar, Map, bOutSuccess))
+	{
+		return false;
+	}
+
+	int32 NumSamples = Samples.Num();
+	Ar << NumSamples;
+	if (NumSamples < 2 || NumSamples > MaxSamples)
+	{
+		Ar.SetError();
+		bOutSuccess = false;
+		return true;
+	}
+
+	Samples.SetNum(NumSamples);
+	for (FVector2f& RootMotionSample : Samples)
+	{
+		Ar << RootMotionSample.X;
+		Ar << RootMotionSample.Y;
+	}
+	Ar << Yaw;
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+UScriptStruct* FHLtC_RootMotionSource_Dodge::GetScriptStruct() const
+{
+	return FHLtC_RootMotionSource_Dodge::StaticStruct();
+}
+
+FString FHLtC_RootMotionSource_Dodge::ToSimpleString() const
+{
+	return FString::Printf(TEXT("[ID:%u]FHLtC_RootMotionSource_Dodge %s"), LocalID, *InstanceName.GetPlainNameString());
+}
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/RootMotionSource.h"
+#include "HLtC_DodgeRootMotionSource.generated.h"
+
+struct FHLtC_CompiledDodge;
+class FHLtC_MoveTable;
+
+/**
+ * Moves a character along the baked root motion of a dodge through its CharacterMovementComponent.
+ * The samples are copied from the move table when the dodge starts, so the source predicts, replays and replicates like any other root motion source.
+ * Movement is driven by the time the movement component simulates, whatever rate the character ticks at.
+ */
+USTRUCT()
+struct FHLtC_RootMotionSource_Dodge : public FRootMotionSource
+{
+	GENERATED_BODY()
+
+	FHLtC_RootMotionSource_Dodge();
+
+	/** Forward and right displacement from the start of the dodge, evenly spaced over Duration. At least 2 */
+	UPROPERTY()
+	TArray<FVector2f> Samples;
+
+	/** Facing when the dodge started, the samples move the character in this frame */
+	UPROPERTY()
+	float Yaw = 0.0f;
+
+	/** Copies the samples of a compiled dodge */
+	void SetDodge(const FHLtC_MoveTable& MoveTable, const FHLtC_CompiledDodge& Dodge);
+
+	FVector2f Sample(float Time) const; // Displacement Time seconds into the dodge
+
+	virtual FRootMotionSource* Clone() const override;
+	virtual bool Matches(const FRootMotionSource* Other) const override;
+	virtual bool MatchesAndHasSameState(const FRootMotionSource* Other) const override;
+	virtual bool UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup = false) override;
+	virtual void PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent) override;
+	virtual bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToSimpleString() const override;
+
+	static constexpr int32 MaxSamples = 256; // Received sample counts past this are rejected
+};
+
+template<>
+struct TStructOpsTypeTraits<FHLtC_RootMotionSource_Dodge> : public TStructOpsTypeTraitsBase2<FHLtC_RootMotionSource_Dodge>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true,
+	};
+};
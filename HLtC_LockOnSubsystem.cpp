@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_LockOnSubsystem.h"
+#include "HLtC_CombatTrace.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+static float GHLtCLockOnMaxDistance = 1500.0f;
+static FAutoConsoleVariableRef CVarHLtCLockOnMaxDistance(
+	TEXT("hltc.LockOn.MaxDistance"),
+	GHLtCLockOnMaxDistance,
+	TEXT("Furthest a lock-on target can be picked or switched to from."));
+
+static float GHLtCLockOnBreakDistance = 2000.0f;
+static FAutoConsoleVariableRef CVarHLtCLockOnBreakDistance(
+	TEXT("hltc.LockOn.BreakDistance"),
+	GHLtCLockOnBreakDistance,
+	TEXT("Distance at which an existing lock-on is dropped. Above MaxDistance so targets at the edge don't flicker in and out."));
+
+static float GHLtCLockOnConeDegrees = 90.0f;
+static FAutoConsoleVariableRef CVarHLtCLockOnConeDegrees(
+	TEXT("hltc.LockOn.ConeDegrees"),
+	GHLtCLockOnConeDegrees,
+	TEXT("Width of the view cone new lock-on targets are picked from."));
+
+//////////////////////////////////////////////////////////////////////////
+// UHLtC_LockOnSubsystem
+
+void UHLtC_LockOnSubsystem::Deinitialize()
+{
+	for (const TPair<TObjectKey<AActor>, int32>& Handle : Handles)
+	{
+		UnbindTarget(Handle.Value);
+	}
+	Handles.Reset();
+	Targets.Reset();
+	Index = FHLtC_TargetIndex();
+
+	Super::Deinitialize();
+}
+
+bool UHLtC_LockOnSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHLtC_LockOnSubsystem::RegisterTarget(AActor* Target)
+{
+	if (Target == nullptr || Handles.Contains(Target))
+	{
+		return;
+	}
+
+	const FVector Location = Target->GetActorLocation();
+	const int32 Handle = Index.Add(Location.X, Location.Y, Location.Z);
+	if (!Targets.IsValidIndex(Handle))
+	{
+		Targets.SetNum(Handle + 1);
+	}
+	Handles.Add(Target, Handle);
+
+	FTarget& Entry = Targets[Handle];
+	Entry.Actor = Target;
+	Entry.Root = Target->GetRootComponent();
+	if (USceneComponent* Root = Target->GetRootComponent())
+	{
+		Entry.MovedHandle = Root->TransformUpdated.AddUObject(this, &UHLtC_LockOnSubsystem::OnTargetMoved, Handle);
+	}
+	Target->OnEndPlay.AddUniqueDynamic(this, &UHLtC_LockOnSubsystem::OnTargetEndPlay);
+}
+
+void UHLtC_LockOnSubsystem::UnregisterTarget(AActor* Target)
+{
+	int32 Handle;
+	if (Handles.RemoveAndCopyValue(Target, Handle))
+	{
+		UnbindTarget(Handle);
+		Index.Remove(Handle);
+		Targets[Handle] = FTarget();
+	}
+}
+
+void UHLtC_LockOnSubsystem::UnbindTarget(int32 Handle)
+{
+	FTarget& Entry = Targets[Handle];
+	if (USceneComponent* Root = Entry.Root.Get())
+	{
+		Root->TransformUpdated.Remove(Entry.MovedHandle);
+	}
+	if (AActor* Actor = Entry.Actor.Get())
+	{
+		Actor->OnEndPlay.RemoveDynamic(this, &UHLtC_LockOnSubsystem::OnTargetEndPlay);
+	}
+	Entry.MovedHandle.Reset();
+}
+
+void UHLtC_LockOnSubsystem::OnTargetMoved(USceneComponent* Root, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport, int32 Handle)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_LockOnUpdate);
+
+	const FVector Location = Root->GetComponentLocation(); // The actor location is its root components
+	Index.Update(Handle, Location.X, Location.Y, Location.Z);
+}
+
+void UHLtC_LockOnSubsystem::OnTargetEndPlay(AActor* Target, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterTarget(Target); // Destroyed or streamed out without unregistering itself
+}
+
+int32 UHLtC_LockOnSubsystem::GetHandle(const AActor* Actor) const
+{
+	const int32* Handle = Actor ? Handles.Find(Actor) : nullptr;
+	return Handle ? *Handle : INDEX_NONE;
+}
+
+FHLtC_TargetQuery UHLtC_LockOnSubsystem::MakeQuery(const AActor* Seeker, const FVector& ViewDirection) const
+{
+	const FVector Location = Seeker->GetActorLocation();
+	FVector View = ViewDirection.GetSafeNormal2D();
+	if (View.IsNearlyZero())
+	{
+		View = Seeker->GetActorForwardVector().GetSafeNormal2D();
+	}
+
+	FHLtC_TargetQuery Query;
+	Query.X = Location.X;
+	Query.Y = Location.Y;
+	Query.Z = Location.Z;
+	Query.ViewX = View.X;
+	Query.ViewY = View.Y;
+	Query.MaxDistance = GHLtCLockOnMaxDistance;
+	Query.CosHalfCone = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(GHLtCLockOnConeDegrees, 0.0f, 360.0f) * 0.5f));
+	Query.Ignore = GetHandle(Seeker);
+	return Query;
+}
+
+AActor* UHLtC_LockOnSubsystem::FindTarget(const AActor* Seeker, const FVector& ViewDirection)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_LockOnQuery);
+	return Seeker ? GetTargetActor(Index.FindBest(MakeQuery(Seeker, ViewDirection))) : nullptr;
+}
+
+AActor* UHLtC_LockOnSubsystem::SwitchTarget(const AActor* Seeker, const FVector& ViewDirection, const AActor* Current, bool bRight)
+{
+	HLTC_COMBAT_SCOPE(STAT_HLtCCombat_LockOnQuery);
+	return Seeker ? GetTargetActor(Index.FindNext(MakeQuery(Seeker, ViewDirection), GetHandle(Current), bRight)) : nullptr;
+}
+
+bool UHLtC_LockOnSubsystem::IsTargetValid(const AActor* Seeker, const AActor* Target) const
+{
+	if (Seeker == nullptr || !IsValid(Target))
+	{
+		return false;
+	}
+
+	const FVector Location = Seeker->GetActorLocation();
+	FHLtC_TargetQuery Query;
+	Query.X = Location.X;
+	Query.Y = Location.Y;
+	Query.Z = Location.Z;
+	Query.Ignore = GetHandle(Seeker);
+	return Index.IsInRange(Query, GetHandle(Target), GHLtCLockOnBreakDistance);
+}
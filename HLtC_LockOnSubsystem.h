@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "HLtC_CombatTargeting.h"
+#include "HLtC_LockOnSubsystem.generated.h"
+
+/**
+ * Keeps every targetable actor of a world in an FHLtC_TargetIndex and answers lock-on queries against it.
+ * Target positions are refreshed when their root components move, and only targets that cross into another grid cell touch the index.
+ * Targets are dropped when they're unregistered or end play, so nothing is polled per frame.
+ */
+UCLASS()
+class UHLtC_LockOnSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem interface
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void RegisterTarget(AActor* Target); // Makes an actor targetable
+	void UnregisterTarget(AActor* Target);
+
+	/** Returns the best target in front of the seeker along its view direction, or null if there's none */
+	AActor* FindTarget(const AActor* Seeker, const FVector& ViewDirection);
+
+	/** Returns the next target to the right (or left) of Current as seen from the seeker, or null if there's none on that side */
+	AActor* SwitchTarget(const AActor* Seeker, const FVector& ViewDirection, const AActor* Current, bool bRight);
+
+	/** Whether the seeker can stay locked on to Target. Cheap enough to call every frame */
+	bool IsTargetValid(const AActor* Seeker, const AActor* Target) const;
+
+private:
+	/** A registered actor and the delegate that follows it */
+	struct FTarget
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TWeakObjectPtr<USceneComponent> Root; // Component whose transform updates move the target
+		FDelegateHandle MovedHandle;
+	};
+
+	void OnTargetMoved(USceneComponent* Root, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport, int32 Handle);
+
+	UFUNCTION()
+	void OnTargetEndPlay(AActor* Target, EEndPlayReason::Type EndPlayReason);
+
+	void UnbindTarget(int32 Handle); // Removes the delegates of a target, leaving the index alone
+
+	FHLtC_TargetQuery MakeQuery(const AActor* Seeker, const FVector& ViewDirection) const;
+	AActor* GetTargetActor(int32 Handle) const { return Handle != INDEX_NONE ? Targets[Handle].Actor.Get() : nullptr; }
+	int32 GetHandle(const AActor* Actor) const;
+
+	FHLtC_TargetIndex Index;
+	TArray<FTarget> Targets; // One per handle of the index
+	TMap<TObjectKey<AActor>, int32> Handles;
+};
@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HLtC_TimingWheel.h"
+
+#include "HLtC_CombatStats.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace
+{
+	inline int32_t CountTrailingZeros(uint64_t Value)
+	{
+#if defined(_MSC_VER)
+		unsigned long Index;
+		_BitScanForward64(&Index, Value);
+		return static_cast<int32_t>(Index);
+#else
+		return __builtin_ctzll(Value);
+#endif
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FHLtC_TimingWheel
+
+FHLtC_TimingWheel::FHLtC_TimingWheel()
+{
+	Reset(0);
+}
+
+void FHLtC_TimingWheel::Reset(int64_t Now)
+{
+	Entries.clear();
+	FreeEntries.clear();
+	std::fill(std::begin(Heads), std::end(Heads), -1);
+	std::fill(std::begin(Occupied), std::end(Occupied), 0);
+	Current = Now;
+	NumPending = 0;
+}
+
+int32_t FHLtC_TimingWheel::Schedule(int64_t Deadline, uint32_t Payload)
+{
+	int32_t Handle;
+	if (!FreeEntries.empty())
+	{
+		Handle = FreeEntries.back();
+		FreeEntries.pop_back();
+	}
+
+	else
+	{
+		Handle = static_cast<int32_t>(Entries.size());
+		const size_t Capacity = Entries.capacity();
+		Entries.emplace_back();
+		HLtC::CountGrowth(Entries, Capacity);
+	}
+
+	Entries[Handle].Deadline = Deadline;
+	Entries[Handle].Payload = Payload;
+	Place(Handle);
+	NumPending++;
+	return Handle;
+}
+
+void FHLtC_TimingWheel::Cancel(int32_t Handle)
+{
+	if (Handle < 0 || Handle >= static_cast<int32_t>(Entries.size()) || Entries[Handle].Slot < 0)
+	{
+		return;
+	}
+
+	Unlink(Handle);
+	FreeEntries.push_back(Handle);
+	NumPending--;
+}
+
+void FHLtC_TimingWheel::Place(int32_t Handle)
+{
+	const int64_t Deadline = std::max(Entries[Handle].Deadline, Current); // Overdue timers go in the current slot, which the next Advance fires first
+
+	// The lowest level whose current rotation also holds the deadline. Anything further out than the top level laps it, and is re-placed each time it comes round
+	int32_t Level = 0;
+	while (Level < NumLevels - 1 && (Deadline >> (SlotBits * (Level + 1))) != (Current >> (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+
+	Link(Handle, Level * NumSlots + static_cast<int32_t>((Deadline >> (SlotBits * Level)) & (NumSlots - 1)));
+}
+
+void FHLtC_TimingWheel::Link(int32_t Handle, int32_t Slot)
+{
+	FEntry& Entry = Entries[Handle];
+	Entry.Slot = Slot;
+	Entry.Prev = -1;
+	Entry.Next = Heads[Slot];
+	if (Entry.Next >= 0)
+	{
+		Entries[Entry.Next].Prev = Handle;
+	}
+	Heads[Slot] = Handle;
+	Occupied[Slot / NumSlots] |= 1ull << (Slot % NumSlots);
+}
+
+void FHLtC_TimingWheel::Unlink(int32_t Handle)
+{
+	FEntry& Entry = Entries[Handle];
+	const int32_t Slot = Entry.Slot;
+
+	(Entry.Prev >= 0 ? Entries[Entry.Prev].Next : Heads[Slot]) = Entry.Next;
+	if (Entry.Next >= 0)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+
+	if (Heads[Slot] < 0)
+	{
+		Occupied[Slot / NumSlots] &= ~(1ull << (Slot % NumSlots));
+	}
+
+	Entry.Slot = -1;
+}
+
+void FHLtC_TimingWheel::Fire(int32_t Slot, std::vector<uint32_t>& OutFired)
+{
+	// Level 0 slots are one tick wide, so everything in one is due at once
+	while (Heads[Slot] >= 0)
+	{
+		const int32_t Handle = Heads[Slot];
+		OutFired.push_back(Entries[Handle].Payload);
+		Unlink(Handle);
+		FreeEntries.push_back(Handle);
+		NumPending--;
+	}
+}
+
+void FHLtC_TimingWheel::Cascade(int32_t Slot)
+{
+	int32_t Handle = Heads[Slot];
+	while (Handle >= 0)
+	{
+		const int32_t Next = Entries[Handle].Next;
+		Unlink(Handle);
+		Place(Handle);
+		Handle = Next;
+	}
+}
+
+void FHLtC_TimingWheel::Advance(int64_t Now, std::vector<uint32_t>& OutFired)
+{
+	const int32_t CurrentSlot = static_cast<int32_t>(Current & (NumSlots - 1));
+	if (Occupied[0] & (1ull << CurrentSlot)) // Timers scheduled at or before the current time
+	{
+		Fire(CurrentSlot, OutFired);
+	}
+
+	while (true)
+	{
+		// Start of the next occupied slot of each level, and the earliest of them
+		int64_t SlotStarts[NumLevels];
+		int64_t Next = std::numeric_limits<int64_t>::max();
+		for (int32_t Level = 0; Level < NumLevels; Level++)
+		{
+			SlotStarts[Level] = std::numeric_limits<int64_t>::max();
+
+			const int32_t Shift = SlotBits * Level;
+			const int32_t Index = static_cast<int32_t>((Current >> Shift) & (NumSlots - 1));
+			const int64_t RotationStart = Current & ~((int64_t(1) << (Shift + SlotBits)) - 1);
+
+			const uint64_t Later = Index < NumSlots - 1 ? Occupied[Level] & (~0ull << (Index + 1)) : 0;
+			if (Later != 0)
+			{
+				SlotStarts[Level] = RotationStart + (int64_t(CountTrailingZeros(Later)) << Shift);
+			}
+
+			else if (Level == NumLevels - 1 && Occupied[Level] != 0) // The top level wraps round into its next rotation
+			{
+				SlotStarts[Level] = RotationStart + (int64_t(NumSlots + CountTrailingZeros(Occupied[Level])) << Shift);
+			}
+
+			Next = std::min(Next, SlotStarts[Level]);
+		}
+
+		if (Next > Now)
+		{
+			break;
+		}
+
+		Current = Next;
+		for (int32_t Level = NumLevels - 1; Level > 0; Level--) // Higher levels first, as they can refill the lower ones
+		{
+			if (SlotStarts[Level] == Next)
+			{
+				Cascade(Level * NumSlots + static_cast<int32_t>((Next >> (SlotBits * Level)) & (NumSlots - 1)));
+			}
+		}
+
+		const int32_t Slot = static_cast<int32_t>(Next & (NumSlots - 1));
+		if (Occupied[0] & (1ull << Slot))
+		{
+			Fire(Slot, OutFired);
+		}
+	}
+
+	Current = std::max(Current, Now);
+}
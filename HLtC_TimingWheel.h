@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Deadline scheduler for the combat core. Engine independent, like the rest of the core.
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hierarchical timing wheel of integer deadlines, each carrying a 32 bit payload.
+ * Level L has 64 slots of 64^L ticks. A timer sits in the lowest level whose current rotation contains its deadline, and drops a level each time the wheel reaches its slot.
+ * Advancing skips straight to the next occupied slot, so the cost follows the number of timers that fire rather than the time that passes.
+ * Timers are addressed by handle, stored in a pool with intrusive slot lists, so scheduling and cancelling are O(1). Nothing allocates once the pool has grown.
+ */
+class FHLtC_TimingWheel
+{
+public:
+	static constexpr int32_t SlotBits = 6;
+	static constexpr int32_t NumSlots = 1 << SlotBits;
+	static constexpr int32_t NumLevels = 6; // 64^6 ticks ahead before a timer has to take another lap of the top level
+
+	FHLtC_TimingWheel();
+
+	/** Drops every timer and sets the current time */
+	void Reset(int64_t Now);
+
+	/** Adds a timer and returns its handle. Deadlines at or before the current time fire on the next Advance */
+	int32_t Schedule(int64_t Deadline, uint32_t Payload);
+
+	/** Removes a timer that hasn't fired. Its handle may be reused afterwards */
+	void Cancel(int32_t Handle);
+
+	/** Changes what a pending timer carries, e.g. when the thing it refers to moves */
+	void SetPayload(int32_t Handle, uint32_t Payload) { Entries[Handle].Payload = Payload; }
+
+	/** Moves the current time to Now, appending the payload of every timer due by then to OutFired in deadline order. Timers sharing a deadline come out in an order that only depends on the calls made. Fired handles are freed */
+	void Advance(int64_t Now, std::vector<uint32_t>& OutFired);
+
+	int64_t GetTime() const { return Current; }
+	int32_t Num() const { return NumPending; }
+
+private:
+	struct FEntry
+	{
+		int64_t Deadline = 0;
+		uint32_t Payload = 0;
+		int32_t Prev = -1;
+		int32_t Next = -1;
+		int32_t Slot = -1; // Level * NumSlots + slot, -1 while the entry is free
+	};
+
+	void Place(int32_t Handle); // Links an entry into the slot its deadline belongs to, relative to the current time
+	void Link(int32_t Handle, int32_t Slot);
+	void Unlink(int32_t Handle);
+	void Fire(int32_t Slot, std::vector<uint32_t>& OutFired);
+	void Cascade(int32_t Slot); // Re-places every entry of a higher level slot now that the wheel has reached it
+
+	std::vector<FEntry> Entries;
+	std::vector<int32_t> FreeEntries;
+	int32_t Heads[NumLevels * NumSlots];
+	uint64_t Occupied[NumLevels] = {}; // Bit per non-empty slot, so empty time is skipped without visiting it
+	int64_t Current = 0;
+	int32_t NumPending = 0;
+};
@@ -0,0 +1,403 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Steps the combat core with seeded random input, outside of the engine, and reports its throughput.
+// Only timed here, HLtC_CombatCoreTests checks the results. Only built by the standalone CMake project, which defines HLTC_COMBAT_STANDALONE.
+
+#if defined(HLTC_COMBAT_STANDALONE)
+
+#include "HLtC_CombatAI.h"
+#include "HLtC_CombatCore.h"
+#include "HLtC_CombatHits.h"
+#include "HLtC_CombatNet.h"
+#include "HLtC_CombatReplay.h"
+#include "HLtC_CombatValidation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/** Small deterministic generator, so every run is fed the same input */
+static uint32_t NextRandom(uint32_t& State)
+{
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return State;
+}
+
+// Usage: HLtC_CombatCoreBenchmark [Combatants=2048] [Steps=10000] [Seed=1] [HitCombatants=256] [Bots=1000] [Clients=1024]
+int main(int argc, char** argv)
+{
+	const int32_t NumCombatants = argc > 1 ? std::atoi(argv[1]) : 2048;
+	const int32_t NumSteps = argc > 2 ? std::atoi(argv[2]) : 10000;
+	uint32_t Seed = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 1u;
+	Seed = Seed == 0 ? 1u : Seed;
+	const int32_t NumHitCombatants = std::max(argc > 4 ? std::atoi(argv[4]) : 256, 1);
+	const int32_t NumBots = std::max(argc > 5 ? std::atoi(argv[5]) : 1000, 2);
+	const int32_t NumClients = std::max(argc > 6 ? std::atoi(argv[6]) : 1024, 8);
+
+	const float FixedTimestep = 1.0f / 60.0f;
+
+	FHLtC_MoveTable MoveTable;
+	FHLtC_CombatWorld World(MoveTable);
+	World.Reserve(NumCombatants);
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		World.Add(0);
+	}
+
+	// Generated up front so only the simulation is timed
+	std::vector<FHLtC_CombatInput> Inputs(static_cast<size_t>(NumCombatants) * NumSteps);
+	uint8_t Held = 0;
+	for (FHLtC_CombatInput& Input : Inputs)
+	{
+		const uint32_t Roll = NextRandom(Seed) % 24; // Most steps have no input
+		if (Roll < 4) { Input.AddPress(static_cast<uint8_t>(1u << Roll), static_cast<uint8_t>(NextRandom(Seed) & 0xFF)); }
+		if (Roll == 6) { Input.AddPress(HLtC::MakeDodgePress(static_cast<EHLtC_DodgeDirection>(NextRandom(Seed) % HLtC::NumDodgeDirections)), static_cast<uint8_t>(NextRandom(Seed) & 0xFF)); }
+		Held ^= Roll == 4 ? HLtC::Input_Sprinting : Roll == 5 ? HLtC::Input_Moving : 0;
+		Input.Held = Held;
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (int32_t Step = 0; Step < NumSteps; Step++)
+	{
+		World.Step(Inputs.data() + static_cast<size_t>(Step) * NumCombatants, FixedTimestep);
+	}
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	// Rollback: resimulate the last RollbackFrames steps, as a late remote input would
+	const int32_t RollbackFrames = std::min(8, NumSteps);
+	FHLtC_RollbackBuffer Rollback;
+	Rollback.Init(RollbackFrames, NumCombatants);
+	for (int32_t Step = NumSteps - RollbackFrames; Step < NumSteps; Step++)
+	{
+		const FHLtC_CombatInput* StepInputs = Inputs.data() + static_cast<size_t>(Step) * NumCombatants;
+		Rollback.SaveFrame(static_cast<uint32_t>(Step), World, StepInputs, FixedTimestep);
+		World.Step(StepInputs, FixedTimestep);
+	}
+
+	const int32_t NumRollbacks = 100;
+	const auto RollbackStart = std::chrono::steady_clock::now();
+	for (int32_t Rollbacks = 0; Rollbacks < NumRollbacks; Rollbacks++)
+	{
+		Rollback.Resimulate(static_cast<uint32_t>(NumSteps - RollbackFrames), World);
+	}
+	const double RollbackSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - RollbackStart).count();
+
+	// Replay: record the same run into a replay stream with a checkpoint every second, then decode all of it
+	const int32_t CheckpointInterval = 60;
+	FHLtC_CombatWorld ReplayWorld(MoveTable);
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		ReplayWorld.Add(0);
+	}
+
+	FHLtC_ReplayEncoder Encoder;
+	FHLtC_ReplayCheckpoint Checkpoint;
+	std::vector<FHLtC_CombatantSnapshot> Snapshots(NumCombatants);
+	std::vector<uint8_t> ReplayBytes;
+	Encoder.WriteHeader();
+	for (int32_t Step = 0; Step < NumSteps; Step++)
+	{
+		const FHLtC_CombatInput* StepInputs = Inputs.data() + static_cast<size_t>(Step) * NumCombatants;
+		const int64_t StepClock = static_cast<int64_t>(Step) * HLtC::ToTimeUnits(FixedTimestep);
+		Encoder.WriteFrame(static_cast<uint32_t>(Step), FixedTimestep, StepClock);
+		for (int32_t Index = 0; Index < NumCombatants; Index++)
+		{
+			for (int32_t Press = 0; Press < StepInputs[Index].NumPresses; Press++)
+			{
+				FHLtC_ReplayInput Input;
+				Input.ActorId = static_cast<uint16_t>(Index);
+				Input.Action = StepInputs[Index].Presses[Press];
+				Input.Axes[0] = 1.0f;
+				Input.Time = StepClock + StepInputs[Index].PressTimes[Press] * 65;
+				Encoder.WriteInput(Input);
+			}
+		}
+
+		ReplayWorld.Step(StepInputs, FixedTimestep);
+
+		if ((Step + 1) % CheckpointInterval == 0)
+		{
+			std::memset(Snapshots.data(), 0, Snapshots.size() * sizeof(FHLtC_CombatantSnapshot)); // Padding is diffed too
+			ReplayWorld.SaveSnapshot(Snapshots.data());
+
+			Checkpoint.Frame = static_cast<uint32_t>(Step + 1);
+			Checkpoint.Clock = ReplayWorld.Clock;
+			Checkpoint.Combatants.assign(NumCombatants, FHLtC_ReplayCombatant{});
+			for (int32_t Index = 0; Index < NumCombatants; Index++)
+			{
+				Checkpoint.Combatants[Index].ActorId = static_cast<uint16_t>(Index);
+				Checkpoint.Combatants[Index].State = Snapshots[Index];
+			}
+			Encoder.WriteCheckpoint(Checkpoint);
+		}
+
+		std::vector<uint8_t> Flushed;
+		Encoder.TakeBytes(Flushed); // As the background writer would
+		ReplayBytes.insert(ReplayBytes.end(), Flushed.begin(), Flushed.end());
+	}
+	Encoder.WriteEnd();
+	{
+		std::vector<uint8_t> Flushed;
+		Encoder.TakeBytes(Flushed);
+		ReplayBytes.insert(ReplayBytes.end(), Flushed.begin(), Flushed.end());
+	}
+
+	FHLtC_ReplayDecoder Decoder;
+	const auto DecodeStart = std::chrono::steady_clock::now();
+	Decoder.Open(ReplayBytes.data(), ReplayBytes.size());
+	FHLtC_ReplayRecord Record;
+	while (Decoder.Next(Record))
+	{
+	}
+	const double DecodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - DecodeStart).count();
+	// Replication: a server sends the net state of every combatant that changed after each step
+	const int32_t NumNetCombatants = std::min(NumCombatants, 64);
+	FHLtC_CombatWorld ServerWorld(MoveTable);
+	for (int32_t Index = 0; Index < NumNetCombatants; Index++)
+	{
+		ServerWorld.Add(0);
+	}
+
+	std::vector<FHLtC_NetCombatState> SentStates(NumNetCombatants);
+	std::vector<FHLtC_CombatInput> NetInputs(NumNetCombatants);
+	std::vector<uint8_t> Packet;
+	uint64_t NumNetUpdates = 0;
+	uint64_t NumNetBits = 0;
+	for (int32_t Step = 0; Step < NumSteps; Step++)
+	{
+		std::copy_n(Inputs.data() + static_cast<size_t>(Step) * NumCombatants, NumNetCombatants, NetInputs.data());
+		ServerWorld.Step(NetInputs.data(), FixedTimestep);
+
+		for (int32_t Index = 0; Index < NumNetCombatants; Index++)
+		{
+			FHLtC_CombatantSnapshot Snapshot;
+			ServerWorld.SaveCombatant(Index, Snapshot);
+			FHLtC_NetCombatState State = FHLtC_NetCombatState::FromSnapshot(Snapshot, static_cast<uint8_t>(Step));
+			if (State.HasSameStates(SentStates[Index])) // The timer and acknowledgement alone don't make an update
+			{
+				continue;
+			}
+
+			Packet.assign(8, 0);
+			uint32_t WriteBit = 0;
+			State.Serialize([&Packet, &WriteBit](uint32_t& Value, uint32_t NumBits)
+			{
+				for (uint32_t Bit = 0; Bit < NumBits; Bit++, WriteBit++)
+				{
+					Packet[WriteBit >> 3] |= static_cast<uint8_t>(((Value >> Bit) & 1u) << (WriteBit & 7));
+				}
+			});
+
+			SentStates[Index] = State;
+			NumNetUpdates++;
+			NumNetBits += WriteBit;
+		}
+	}
+
+	// Hits: a frame where every combatant attacks, spread over an arena as densely as a crowded fight
+	FHLtC_CombatantBounds Bounds;
+	Bounds.SetNum(NumHitCombatants);
+	const float ArenaSize = std::sqrt(static_cast<float>(NumHitCombatants)) * 250.0f;
+	std::vector<FHLtC_Attack> Attacks;
+	for (int32_t Index = 0; Index < NumHitCombatants; Index++)
+	{
+		const float Angle = static_cast<float>(NextRandom(Seed) % 3600) * (3.14159265f / 1800.0f);
+		Bounds.X[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (ArenaSize / 10000.0f);
+		Bounds.Y[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (ArenaSize / 10000.0f);
+		Bounds.Z[Index] = 96.0f;
+		Bounds.ForwardX[Index] = std::cos(Angle);
+		Bounds.ForwardY[Index] = std::sin(Angle);
+		Bounds.Radius[Index] = 42.0f;
+		Bounds.HalfHeight[Index] = 96.0f;
+		Bounds.Blocking[Index] = NextRandom(Seed) % 4 == 0;
+		Bounds.Invulnerable[Index] = NextRandom(Seed) % 8 == 0;
+		Attacks.push_back({ Index, static_cast<uint16_t>(NextRandom(Seed) % MoveTable.NumMoves()) });
+	}
+
+	const int32_t NumHitFrames = 1000;
+	FHLtC_HitResolver HitResolver;
+	std::vector<FHLtC_HitEvent> Hits;
+	std::vector<FHLtC_HitEvent> BruteForceHits;
+	const auto HitStart = std::chrono::steady_clock::now();
+	for (int32_t Frame = 0; Frame < NumHitFrames; Frame++)
+	{
+		Hits.clear();
+		HitResolver.Resolve(Bounds, MoveTable, Attacks.data(), NumHitCombatants, Hits);
+	}
+	const double HitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - HitStart).count();
+
+	const auto BruteForceStart = std::chrono::steady_clock::now();
+	for (int32_t Frame = 0; Frame < NumHitFrames; Frame++)
+	{
+		BruteForceHits.clear();
+		FHLtC_HitResolver::ResolveBruteForce(Bounds, MoveTable, Attacks.data(), NumHitCombatants, BruteForceHits);
+	}
+	const double BruteForceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - BruteForceStart).count();
+
+	// AI: bots paired off against each other across an arena, walking on their decisions, with each slice decided in one go
+	const int32_t NumBotSteps = 600;
+	const int32_t DecisionInterval = 4;
+	FHLtC_CombatWorld BotWorld(MoveTable);
+	FHLtC_BotBrain Brain;
+	FHLtC_CombatantBounds BotBounds;
+	std::vector<FHLtC_CombatInput> BotInputs(NumBots);
+	const float BotArenaSize = std::sqrt(static_cast<float>(NumBots)) * 400.0f;
+	BotWorld.Reserve(NumBots);
+	BotBounds.SetNum(NumBots);
+	for (int32_t Index = 0; Index < NumBots; Index++)
+	{
+		BotWorld.Add(0);
+		BotWorld.SetControlState(Index, EHLtC_ControlState::Action);
+		BotBounds.X[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (BotArenaSize / 10000.0f);
+		BotBounds.Y[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (BotArenaSize / 10000.0f);
+		BotBounds.Z[Index] = 96.0f;
+		BotBounds.ForwardX[Index] = 1.0f;
+		BotBounds.Radius[Index] = 42.0f;
+		BotBounds.HalfHeight[Index] = 96.0f;
+		Brain.Add(Index, (Index ^ 1) < NumBots ? Index ^ 1 : -1, NextRandom(Seed));
+	}
+
+	double BotDecideSeconds = 0.0;
+	double MaxBotDecideSeconds = 0.0;
+	uint32_t NumBotAttacks = 0;
+	uint32_t NumBotBlocks = 0;
+	for (int32_t Step = 0; Step < NumBotSteps; Step++)
+	{
+		int32_t Begin, End;
+		Brain.GetDueRange(static_cast<uint32_t>(Step), DecisionInterval, Begin, End);
+
+		const auto DecideStart = std::chrono::steady_clock::now();
+		Brain.DecideRange(Begin, End, BotWorld, BotBounds);
+		const double DecideSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - DecideStart).count();
+		BotDecideSeconds += DecideSeconds;
+		MaxBotDecideSeconds = std::max(MaxBotDecideSeconds, DecideSeconds);
+
+		for (int32_t Index = 0; Index < NumBots; Index++)
+		{
+			const FHLtC_BotCommand Command = Brain.TakeCommand(Index, FixedTimestep);
+			BotInputs[Index] = FHLtC_CombatInput();
+			Command.AppendTo(BotInputs[Index]);
+			NumBotAttacks += (Command.Presses & (HLtC::Input_LightAttack | HLtC::Input_HeavyAttack)) != 0 ? 1 : 0;
+			NumBotBlocks += (Command.Presses & HLtC::Input_BlockStarted) != 0 ? 1 : 0;
+
+			if (!BotWorld.HasFlag(Index, HLtC::Flag_StaticAction)) // Stand-in for the movement component, at the "Action" state speeds
+			{
+				const float Speed = (Command.Held & HLtC::Input_Sprinting) != 0 ? 600.0f : 400.0f;
+				BotBounds.X[Index] += Command.MoveX * Speed * FixedTimestep;
+				BotBounds.Y[Index] += Command.MoveY * Speed * FixedTimestep;
+			}
+		}
+		BotWorld.Step(BotInputs.data(), FixedTimestep);
+	}
+
+	// Validation: clients claim what each of their attack and block presses did, as their prediction saw it, and every eighth one cheats.
+	// Claims go through the queue, are drained once a step and checked in one go against the world before it steps the presses
+	const int32_t NumValidationSteps = 600;
+	FHLtC_CombatWorld ValidationWorld(MoveTable);
+	ValidationWorld.Reserve(NumClients);
+	for (int32_t Index = 0; Index < NumClients; Index++)
+	{
+		ValidationWorld.Add(0);
+	}
+
+	FHLtC_InputClaimQueue ClaimQueue(static_cast<uint32_t>(NumClients));
+	FHLtC_InputValidator Validator;
+	std::vector<FHLtC_CombatInput> ValidationInputs(NumClients);
+	std::vector<FHLtC_InputClaim> DrainedClaims;
+	uint32_t NumClaims = 0;
+	uint32_t NumRejected = 0;
+	double ValidateSeconds = 0.0;
+	for (int32_t Step = 0; Step < NumValidationSteps; Step++)
+	{
+		const double StepTime = static_cast<double>(ValidationWorld.Clock) / HLtC::TimeUnitsPerSecond;
+		for (int32_t Index = 0; Index < NumClients; Index++)
+		{
+			FHLtC_CombatInput& Input = ValidationInputs[Index];
+			Input = FHLtC_CombatInput();
+
+			const uint32_t Roll = NextRandom(Seed) % 16;
+			if (Roll >= 4) // Most steps have no press. Presses land at the start of the step, as the claims see the world
+			{
+				continue;
+			}
+
+			const EHLtC_InputEvent Type = Roll < 2 ? (Roll == 0 ? EHLtC_InputEvent::LightAttack : EHLtC_InputEvent::HeavyAttack)
+				: ValidationWorld.HasFlag(Index, HLtC::Flag_Blocking) ? EHLtC_InputEvent::BlockCompleted : EHLtC_InputEvent::BlockStarted;
+			HLtC::ApplyInputEvent(Input, Type, 0);
+
+			FHLtC_InputClaim Claim = HLtC::MakeInputClaim(ValidationWorld, Index, Type);
+			Claim.Combatant = Index;
+			Claim.Time = StepTime;
+			if (Index % 8 == 7) // Cheats claim a move that doesn't exist, or a block change during an attack
+			{
+				Claim.Move = Claim.Move != HLtC::InvalidMove ? static_cast<uint16_t>(MoveTable.NumMoves() + 5) : Claim.Move;
+				Claim.bChanged = 1;
+			}
+			ClaimQueue.Push(Claim);
+		}
+
+		DrainedClaims.clear();
+		FHLtC_InputClaim Claim;
+		while (ClaimQueue.Pop(Claim))
+		{
+			DrainedClaims.push_back(Claim);
+		}
+
+		Validator.BeginBatch(ValidationWorld, StepTime, DrainedClaims.data(), static_cast<int32_t>(DrainedClaims.size()));
+		const auto ValidateStart = std::chrono::steady_clock::now();
+		Validator.Validate();
+		ValidateSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - ValidateStart).count();
+
+		for (const EHLtC_InputVerdict Verdict : Validator.GetVerdicts())
+		{
+			NumClaims++;
+			NumRejected += Verdict != EHLtC_InputVerdict::Valid ? 1 : 0;
+		}
+
+		ValidationWorld.Step(ValidationInputs.data(), FixedTimestep);
+	}
+
+	// Fold the final state into a checksum, which also keeps the work from being optimized away
+	uint32_t Checksum = 0;
+	for (int32_t Index = 0; Index < NumCombatants; Index++)
+	{
+		Checksum = Checksum * 31u + World.AttackMove[Index] + (static_cast<uint32_t>(World.Flags[Index]) << 16);
+	}
+
+	const double CombatantSteps = static_cast<double>(NumCombatants) * NumSteps;
+	std::printf("%d combatants x %d steps in %.3f ms\n", NumCombatants, NumSteps, Seconds * 1000.0);
+	std::printf("%.1f M combatant-steps/s, %.2f ns per combatant-step\n", CombatantSteps / Seconds / 1.0e6, Seconds * 1.0e9 / CombatantSteps);
+	std::printf("Rollback of %d steps in %.3f ms\n", RollbackFrames, RollbackSeconds * 1000.0 / NumRollbacks);
+	std::printf("Replay of %d steps: %.1f KB, %.1f bytes per step, decoded in %.3f ms\n", NumSteps, ReplayBytes.size() / 1024.0,
+		static_cast<double>(ReplayBytes.size()) / NumSteps, DecodeSeconds * 1000.0);
+	std::printf("Replication of %d combatants: updates in %.1f%% of combatant-steps, %.1f bits per update, %.2f bytes per combatant per step\n", NumNetCombatants,
+		100.0 * NumNetUpdates / (static_cast<double>(NumNetCombatants) * NumSteps), NumNetUpdates ? static_cast<double>(NumNetBits) / NumNetUpdates : 0.0,
+		NumNetBits / 8.0 / (static_cast<double>(NumNetCombatants) * NumSteps));
+	std::printf("%d attacks against %d combatants: grid %.3f ms, brute force %.3f ms, %zu hits\n", NumHitCombatants, NumHitCombatants,
+		HitSeconds * 1000.0 / NumHitFrames, BruteForceSeconds * 1000.0 / NumHitFrames, Hits.size());
+
+	std::printf("AI: %d bots deciding every %d steps in %.3f ms per step (max %.3f ms), %.1f ns per decision, %u attacks, %u blocks\n", NumBots, DecisionInterval,
+		BotDecideSeconds * 1000.0 / NumBotSteps, MaxBotDecideSeconds * 1000.0, BotDecideSeconds * 1.0e9 * DecisionInterval / (static_cast<double>(NumBots) * NumBotSteps),
+		NumBotAttacks, NumBotBlocks);
+
+	std::printf("Validation: %u claims of %d clients in %.3f us per step, %u rejected\n", NumClaims, NumClients, ValidateSeconds * 1.0e6 / NumValidationSteps, NumRejected);
+
+	uint32_t Counters[HLtC::Counter_Num];
+	HLtC::GetCombatCounters().TakeFrame(Counters);
+	for (int32_t Counter = 0; Counter < HLtC::Counter_Num; Counter++)
+	{
+		std::printf("%s%s %u", Counter == 0 ? "Counters: " : ", ", HLtC::GetCounterName(static_cast<HLtC::ECombatCounter>(Counter)), Counters[Counter]);
+	}
+	std::printf("\n");
+
+	std::printf("Checksum %08x\n", Checksum);
+	return 0;
+}
+
+#endif // HLTC_COMBAT_STANDALONE
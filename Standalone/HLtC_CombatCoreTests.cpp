@@ -0,0 +1,888 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Checks the combat core against itself outside of the engine: parallel steps, rollbacks, replays, replication, dodges, buffered attacks, hits, lock-on targeting, bots, input validation and appending to the move table.
+// Only built by the standalone CMake project, which defines HLTC_COMBAT_STANDALONE, and registered with CTest one test per name.
+
+#if defined(HLTC_COMBAT_STANDALONE)
+
+#include "HLtC_CombatAI.h"
+#include "HLtC_CombatCore.h"
+#include "HLtC_CombatHits.h"
+#include "HLtC_CombatNet.h"
+#include "HLtC_CombatReplay.h"
+#include "HLtC_CombatTargeting.h"
+#include "HLtC_CombatValidation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const float FixedTimestep = 1.0f / 60.0f;
+
+	/** Small deterministic generator, so every run is fed the same input */
+	uint32_t NextRandom(uint32_t& State)
+	{
+		State ^= State << 13;
+		State ^= State >> 17;
+		State ^= State << 5;
+		return State;
+	}
+
+	/** Seeded random presses and held buttons for NumCombatants over NumSteps, laid out step by step */
+	std::vector<FHLtC_CombatInput> MakeRandomInputs(int32_t NumCombatants, int32_t NumSteps, uint32_t Seed)
+	{
+		std::vector<FHLtC_CombatInput> Inputs(static_cast<size_t>(NumCombatants) * NumSteps);
+		uint8_t Held = 0;
+		for (FHLtC_CombatInput& Input : Inputs)
+		{
+			const uint32_t Roll = NextRandom(Seed) % 24; // Most steps have no input
+			if (Roll < 4) { Input.AddPress(static_cast<uint8_t>(1u << Roll), static_cast<uint8_t>(NextRandom(Seed) & 0xFF)); }
+			if (Roll == 6) { Input.AddPress(HLtC::MakeDodgePress(static_cast<EHLtC_DodgeDirection>(NextRandom(Seed) % HLtC::NumDodgeDirections)), static_cast<uint8_t>(NextRandom(Seed) & 0xFF)); }
+			Held ^= Roll == 4 ? HLtC::Input_Sprinting : Roll == 5 ? HLtC::Input_Moving : 0;
+			Input.Held = Held;
+		}
+		return Inputs;
+	}
+
+	void AddCombatants(FHLtC_CombatWorld& World, int32_t NumCombatants)
+	{
+		World.Reserve(NumCombatants);
+		for (int32_t Index = 0; Index < NumCombatants; Index++)
+		{
+			World.Add(0);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Parallel step
+
+	/** Two copies of a world fed the same random input with uneven step lengths, one stepped whole and one with its StepRange split across threads, must agree after every step */
+	bool TestParallelStep()
+	{
+		const int32_t NumCombatants = 1000;
+		const int32_t NumSteps = 1000;
+		const int32_t NumThreads = 4;
+		const int32_t BatchSize = 64; // Uneven batches, and more of them than threads
+		const FHLtC_MoveTable MoveTable;
+		const std::vector<FHLtC_CombatInput> Inputs = MakeRandomInputs(NumCombatants, NumSteps, 1u);
+		FHLtC_CombatWorld Serial(MoveTable);
+		FHLtC_CombatWorld Parallel(MoveTable);
+		AddCombatants(Serial, NumCombatants);
+		AddCombatants(Parallel, NumCombatants);
+
+		uint32_t Seed = 7u;
+		const int32_t NumBatches = (NumCombatants + BatchSize - 1) / BatchSize;
+		for (int32_t Step = 0; Step < NumSteps; Step++)
+		{
+			const FHLtC_CombatInput* StepInputs = Inputs.data() + static_cast<size_t>(Step) * NumCombatants;
+			const float DeltaTime = 1.0f / 240.0f + static_cast<float>(NextRandom(Seed) % 1000) * ((1.0f / 15.0f - 1.0f / 240.0f) / 1000.0f); // Anything from a fast step to a hitch
+
+			Serial.Step(StepInputs, DeltaTime);
+
+			Parallel.BeginStep(DeltaTime);
+			std::vector<std::thread> Threads;
+			for (int32_t Thread = 0; Thread < NumThreads; Thread++)
+			{
+				Threads.emplace_back([&Parallel, StepInputs, NumBatches, NumCombatants, Thread, NumThreads, BatchSize]()
+				{
+					for (int32_t Batch = Thread; Batch < NumBatches; Batch += NumThreads)
+					{
+						Parallel.StepRange(Batch * BatchSize, std::min((Batch + 1) * BatchSize, NumCombatants), StepInputs);
+					}
+				});
+			}
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+			Parallel.EndStep(StepInputs);
+
+			if (!Serial.HasSameState(Parallel))
+			{
+				std::printf("Parallel step diverged from the serial step on step %d\n", Step);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Rollback
+
+	/**
+	 * One combatant's input arrives a few steps late. Till then the world steps on a prediction with no presses, then rolls back to the late step and resimulates with the real input.
+	 * The state each resimulation re-saves after the corrected step must match a world that only ever had the real input, and once the timer pool has grown no resimulation may allocate
+	 */
+	bool TestRollback()
+	{
+		const int32_t NumCombatants = 256;
+		const int32_t NumSteps = 600;
+		const int32_t NumRollbackFrames = 8;
+		const int32_t InputDelay = 5;
+		const FHLtC_MoveTable MoveTable;
+		const std::vector<FHLtC_CombatInput> Inputs = MakeRandomInputs(NumCombatants, NumSteps, 1u);
+		FHLtC_CombatWorld World(MoveTable);
+		FHLtC_CombatWorld Expected(MoveTable); // Steps a frame once its input has arrived, so runs InputDelay frames behind
+		FHLtC_CombatWorld Resaved(MoveTable);
+		AddCombatants(World, NumCombatants);
+		AddCombatants(Expected, NumCombatants);
+		AddCombatants(Resaved, NumCombatants);
+
+		// Restoring marks every combatant changed, which isn't part of the state being compared
+		auto MatchesExpected = [&Expected](FHLtC_CombatWorld& Other)
+		{
+			std::fill(Other.Changed.begin(), Other.Changed.end(), uint8_t(0));
+			std::fill(Expected.Changed.begin(), Expected.Changed.end(), uint8_t(0));
+			return Other.HasSameState(Expected);
+		};
+
+		FHLtC_RollbackBuffer Rollback;
+		Rollback.Init(NumRollbackFrames, NumCombatants);
+		std::vector<FHLtC_CombatInput> Predicted(NumCombatants);
+		uint32_t NumAllocations = 0;
+		for (int32_t Step = 0; Step < NumSteps; Step++)
+		{
+			const FHLtC_CombatInput* StepInputs = Inputs.data() + static_cast<size_t>(Step) * NumCombatants;
+			std::copy_n(StepInputs, NumCombatants, Predicted.data());
+			Predicted[0] = FHLtC_CombatInput();
+			Predicted[0].Held = StepInputs[0].Held;
+			Rollback.SaveFrame(static_cast<uint32_t>(Step), World, Predicted.data(), FixedTimestep);
+			World.Step(Predicted.data(), FixedTimestep);
+
+			if (Step < InputDelay)
+			{
+				continue;
+			}
+
+			const uint32_t LateFrame = static_cast<uint32_t>(Step - InputDelay);
+			const FHLtC_CombatInput* LateInputs = Inputs.data() + static_cast<size_t>(LateFrame) * NumCombatants;
+			Rollback.GetInputs(LateFrame)[0] = LateInputs[0];
+
+			const uint32_t AllocationsBefore = HLtC::GetCombatCounters().Values[HLtC::Counter_Allocations].load();
+			const int32_t NumReplayed = Rollback.Resimulate(LateFrame, World);
+			const uint32_t Allocations = HLtC::GetCombatCounters().Values[HLtC::Counter_Allocations].load() - AllocationsBefore;
+			NumAllocations += Step > InputDelay ? Allocations : 0; // The first resimulation may still grow the timer pool
+
+			Expected.Step(LateInputs, FixedTimestep);
+			if (NumReplayed != InputDelay + 1 || !Rollback.RestoreFrame(LateFrame + 1, Resaved) || !MatchesExpected(Resaved) || NumAllocations != 0)
+			{
+				std::printf("Rollback diverged on step %d, %d steps replayed, %u allocations\n", Step, NumReplayed, NumAllocations);
+				return false;
+			}
+		}
+
+		// The last inputs arrive together, after which the world is where the real input leads
+		const uint32_t FirstLateFrame = static_cast<uint32_t>(NumSteps - InputDelay);
+		for (uint32_t Frame = FirstLateFrame; Frame < static_cast<uint32_t>(NumSteps); Frame++)
+		{
+			Rollback.GetInputs(Frame)[0] = Inputs[static_cast<size_t>(Frame) * NumCombatants];
+			Expected.Step(Inputs.data() + static_cast<size_t>(Frame) * NumCombatants, FixedTimestep);
+		}
+		return Rollback.Resimulate(FirstLateFrame, World) == InputDelay && MatchesExpected(World);
+	}
+
+	/**
+	 * A late light attack press corrected into the middle of the rollback window must be reported as started by the resimulation, exactly once.
+	 * An attack the recorded timeline already started on a replayed step must not be reported again
+	 */
+	bool TestRollbackAttacks()
+	{
+		const int32_t NumSteps = 6;
+		const uint32_t LateFrame = 2;
+		const FHLtC_MoveTable MoveTable;
+		FHLtC_CombatWorld World(MoveTable);
+		AddCombatants(World, 2);
+
+		FHLtC_RollbackBuffer Rollback;
+		Rollback.Init(8, 2);
+		for (int32_t Step = 0; Step < NumSteps; Step++)
+		{
+			FHLtC_CombatInput Predicted[2];
+			if (Step == 3) { Predicted[1].AddPress(HLtC::Input_LightAttack); } // Known in time, started by the recorded timeline
+			Rollback.SaveFrame(static_cast<uint32_t>(Step), World, Predicted, FixedTimestep);
+			World.Step(Predicted, FixedTimestep);
+		}
+
+		Rollback.GetInputs(LateFrame)[0].AddPress(HLtC::Input_LightAttack);
+		std::vector<FHLtC_Attack> Started;
+		const int32_t NumReplayed = Rollback.Resimulate(LateFrame, World, &Started);
+
+		const uint16_t EntryMove = MoveTable.GetNextMove(FHLtC_AttackCursor(), EHLtC_AttackType::Light);
+		return NumReplayed == NumSteps - static_cast<int32_t>(LateFrame) && Started.size() == 1 && Started[0].Attacker == 0 && Started[0].Move == EntryMove
+			&& World.AttackMove[0] == EntryMove && !World.HasFlag(0, HLtC::Flag_AttackStarted);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Replay
+
+	/** Records a run into a replay stream with a checkpoint every second, then decodes it and checks every checkpoint comes back as it was saved */
+	bool TestReplay()
+	{
+		const int32_t NumCombatants = 256;
+		const int32_t NumSteps = 1200;
+		const int32_t CheckpointInterval = 60;
+		const FHLtC_MoveTable MoveTable;
+		const std::vector<FHLtC_CombatInput> Inputs = MakeRandomInputs(NumCombatants, NumSteps, 1u);
+		FHLtC_CombatWorld ReplayWorld(MoveTable);
+		AddCombatants(ReplayWorld, NumCombatants);
+
+		FHLtC_ReplayEncoder Encoder;
+		FHLtC_ReplayCheckpoint Checkpoint;
+		std::vector<FHLtC_ReplayCheckpoint> SavedCheckpoints;
+		std::vector<FHLtC_CombatantSnapshot> Snapshots(NumCombatants);
+		std::vector<uint8_t> ReplayBytes;
+		Encoder.WriteHeader();
+		for (int32_t Step = 0; Step < NumSteps; Step++)
+		{
+			const FHLtC_CombatInput* StepInputs = Inputs.data() + static_cast<size_t>(Step) * NumCombatants;
+			const int64_t StepClock = static_cast<int64_t>(Step) * HLtC::ToTimeUnits(FixedTimestep);
+			Encoder.WriteFrame(static_cast<uint32_t>(Step), FixedTimestep, StepClock);
+			for (int32_t Index = 0; Index < NumCombatants; Index++)
+			{
+				for (int32_t Press = 0; Press < StepInputs[Index].NumPresses; Press++)
+				{
+					FHLtC_ReplayInput Input;
+					Input.ActorId = static_cast<uint16_t>(Index);
+					Input.Action = StepInputs[Index].Presses[Press];
+					Input.Axes[0] = 1.0f;
+					Input.Time = StepClock + StepInputs[Index].PressTimes[Press] * 65;
+					Encoder.WriteInput(Input);
+				}
+			}
+
+			ReplayWorld.Step(StepInputs, FixedTimestep);
+
+			if ((Step + 1) % CheckpointInterval == 0)
+			{
+				std::memset(Snapshots.data(), 0, Snapshots.size() * sizeof(FHLtC_CombatantSnapshot)); // Padding is diffed too
+				ReplayWorld.SaveSnapshot(Snapshots.data());
+
+				Checkpoint.Frame = static_cast<uint32_t>(Step + 1);
+				Checkpoint.Clock = ReplayWorld.Clock;
+				Checkpoint.Combatants.assign(NumCombatants, FHLtC_ReplayCombatant{});
+				for (int32_t Index = 0; Index < NumCombatants; Index++)
+				{
+					Checkpoint.Combatants[Index].ActorId = static_cast<uint16_t>(Index);
+					Checkpoint.Combatants[Index].State = Snapshots[Index];
+				}
+				Encoder.WriteCheckpoint(Checkpoint);
+				SavedCheckpoints.push_back(Checkpoint);
+			}
+
+			std::vector<uint8_t> Flushed;
+			Encoder.TakeBytes(Flushed); // As the background writer would
+			ReplayBytes.insert(ReplayBytes.end(), Flushed.begin(), Flushed.end());
+		}
+		Encoder.WriteEnd();
+		{
+			std::vector<uint8_t> Flushed;
+			Encoder.TakeBytes(Flushed);
+			ReplayBytes.insert(ReplayBytes.end(), Flushed.begin(), Flushed.end());
+		}
+
+		FHLtC_ReplayDecoder Decoder;
+		bool bReplayMatches = Decoder.Open(ReplayBytes.data(), ReplayBytes.size());
+		size_t NumDecodedCheckpoints = 0;
+		FHLtC_ReplayRecord Record;
+		while (bReplayMatches && Decoder.Next(Record))
+		{
+			if (Record.Type == HLtC::Record_Checkpoint)
+			{
+				const FHLtC_ReplayCheckpoint& Saved = SavedCheckpoints[NumDecodedCheckpoints++];
+				bReplayMatches = Record.Checkpoint->Frame == Saved.Frame && Record.Checkpoint->Clock == Saved.Clock
+					&& std::memcmp(Record.Checkpoint->Combatants.data(), Saved.Combatants.data(), Saved.Combatants.size() * sizeof(FHLtC_ReplayCombatant)) == 0;
+			}
+		}
+		bReplayMatches = bReplayMatches && !Decoder.IsCorrupt() && NumDecodedCheckpoints == SavedCheckpoints.size() && Decoder.GetNumFrames() == static_cast<uint32_t>(NumSteps);
+
+		if (bReplayMatches) // Seeking into the middle lands on a keyframe that decodes on its own
+		{
+			const int64_t Keyframe = Decoder.Seek(static_cast<uint32_t>(NumSteps / 2));
+			bReplayMatches = Keyframe >= 0 && Decoder.Next(Record) && Record.Type == HLtC::Record_Checkpoint && Record.bKeyframe
+				&& Record.Checkpoint->Frame == static_cast<uint32_t>(Keyframe)
+				&& std::memcmp(Record.Checkpoint->Combatants.data(), SavedCheckpoints[Keyframe / CheckpointInterval - 1].Combatants.data(), NumCombatants * sizeof(FHLtC_ReplayCombatant)) == 0;
+		}
+		return bReplayMatches;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Replication
+
+	/** A server sends the net state of every combatant that changed after each step, a client decodes and applies it, and must end up agreeing with what was sent. The camera state is local to each end and must survive the updates */
+	bool TestReplication()
+	{
+		const int32_t NumNetCombatants = 64;
+		const int32_t NumSteps = 2000;
+		const FHLtC_MoveTable MoveTable;
+		const std::vector<FHLtC_CombatInput> Inputs = MakeRandomInputs(NumNetCombatants, NumSteps, 1u);
+		FHLtC_CombatWorld ServerWorld(MoveTable);
+		FHLtC_CombatWorld ClientWorld(MoveTable);
+		AddCombatants(ServerWorld, NumNetCombatants);
+		AddCombatants(ClientWorld, NumNetCombatants);
+		ClientWorld.SetCameraState(0, EHLtC_CameraState::Focus); // Locked on here only
+
+		std::vector<FHLtC_NetCombatState> SentStates(NumNetCombatants);
+		std::vector<uint8_t> Packet;
+		uint64_t NumNetUpdates = 0;
+		bool bNetMatches = true;
+		for (int32_t Step = 0; Step < NumSteps; Step++)
+		{
+			ServerWorld.Step(Inputs.data() + static_cast<size_t>(Step) * NumNetCombatants, FixedTimestep);
+
+			for (int32_t Index = 0; Index < NumNetCombatants; Index++)
+			{
+				FHLtC_CombatantSnapshot Snapshot;
+				ServerWorld.SaveCombatant(Index, Snapshot);
+				FHLtC_NetCombatState State = FHLtC_NetCombatState::FromSnapshot(Snapshot, static_cast<uint8_t>(Step));
+				if (State.HasSameStates(SentStates[Index])) // The timer and acknowledgement alone don't make an update
+				{
+					continue;
+				}
+
+				Packet.assign(8, 0);
+				uint32_t WriteBit = 0;
+				State.Serialize([&Packet, &WriteBit](uint32_t& Value, uint32_t NumBits)
+				{
+					for (uint32_t Bit = 0; Bit < NumBits; Bit++, WriteBit++)
+					{
+						Packet[WriteBit >> 3] |= static_cast<uint8_t>(((Value >> Bit) & 1u) << (WriteBit & 7));
+					}
+				});
+
+				FHLtC_NetCombatState Received;
+				uint32_t ReadBit = 0;
+				bNetMatches = bNetMatches && Received.Serialize([&Packet, &ReadBit](uint32_t& Value, uint32_t NumBits)
+				{
+					Value = 0;
+					for (uint32_t Bit = 0; Bit < NumBits; Bit++, ReadBit++)
+					{
+						Value |= static_cast<uint32_t>((Packet[ReadBit >> 3] >> (ReadBit & 7)) & 1u) << Bit;
+					}
+				});
+				bNetMatches = bNetMatches && Received == State && ReadBit == WriteBit;
+
+				FHLtC_CombatantSnapshot ClientSnapshot;
+				ClientWorld.SaveCombatant(Index, ClientSnapshot);
+				Received.ToSnapshot(ClientSnapshot, MoveTable);
+				ClientWorld.RestoreCombatant(Index, ClientSnapshot);
+				ClientWorld.SaveCombatant(Index, ClientSnapshot);
+				bNetMatches = bNetMatches && FHLtC_NetCombatState::FromSnapshot(ClientSnapshot, Received.InputAck) == State;
+
+				SentStates[Index] = State;
+				NumNetUpdates++;
+			}
+		}
+		return bNetMatches && NumNetUpdates > 0 && ClientWorld.CameraState[0] == EHLtC_CameraState::Focus && ServerWorld.CameraState[0] == EHLtC_CameraState::Free;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Dodge
+
+	/** A left dodge with a light attack buffered into it, checked against the compiled dodge as it plays out */
+	bool TestDodge()
+	{
+		const FHLtC_MoveTable MoveTable;
+		FHLtC_CombatWorld DodgeWorld(MoveTable);
+		DodgeWorld.Add(0);
+
+		const FHLtC_CompiledDodge& Dodge = MoveTable.GetDodge(0, EHLtC_DodgeDirection::Left);
+		const int64_t WindowOpens = HLtC::ToTimeUnits(Dodge.Duration - Dodge.BufferTime);
+
+		bool bDodgeMatches = true;
+		int32_t NumInvulnerableSteps = 0;
+		for (int32_t Step = 0; DodgeWorld.Clock < HLtC::ToTimeUnits(Dodge.Duration); Step++)
+		{
+			FHLtC_CombatInput DodgeInput;
+			DodgeInput.Held = HLtC::Input_Moving;
+			if (Step < 2) { DodgeInput.AddPress(Step == 0 ? HLtC::MakeDodgePress(EHLtC_DodgeDirection::Left) : static_cast<uint8_t>(HLtC::Input_LightAttack)); }
+			DodgeWorld.Step(&DodgeInput, FixedTimestep);
+
+			const float Elapsed = static_cast<float>(static_cast<double>(DodgeWorld.Clock) / HLtC::TimeUnitsPerSecond);
+			const bool bInvulnerable = DodgeWorld.Clock >= Dodge.InvulnerableStart && DodgeWorld.Clock < Dodge.InvulnerableEnd;
+			NumInvulnerableSteps += DodgeWorld.IsInvulnerable(0) ? 1 : 0;
+
+			if (DodgeWorld.Clock < WindowOpens) // Still dodging, with the attack waiting for the window
+			{
+				FHLtC_RootMotionSample RootMotion = {};
+				const FHLtC_RootMotionSample Expected = MoveTable.SampleRootMotion(Dodge, Elapsed);
+				bDodgeMatches = bDodgeMatches && DodgeWorld.Action[0] == EHLtC_PlayerAction::Dodge && DodgeWorld.IsInvulnerable(0) == bInvulnerable
+					&& DodgeWorld.GetDodgeRootMotion(0, 0.0f, RootMotion) && std::fabs(RootMotion.Right - Expected.Right) < 1.e-3f && RootMotion.Right <= 0.0f
+					&& (Step == 0 || DodgeWorld.HasFlag(0, HLtC::Flag_AttackBuffered));
+			}
+
+			else // Cancelled into the attack
+			{
+				bDodgeMatches = bDodgeMatches && DodgeWorld.Action[0] == EHLtC_PlayerAction::LightAttack && !DodgeWorld.IsInvulnerable(0);
+			}
+		}
+
+		const FHLtC_RootMotionSample End = MoveTable.SampleRootMotion(Dodge, Dodge.Duration);
+		return bDodgeMatches && NumInvulnerableSteps > 0 && std::fabs(End.Right + FHLtC_DodgeDefinition().Distance) < 1.e-3f && End.Forward == 0.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Buffered attack deadline
+
+	/** A light attack buffered into the first light attack, then one long step that both opens the window and runs past the end of the first attack. The followup must start from the moment the window opened */
+	bool TestBufferedAttackDeadline()
+	{
+		const FHLtC_MoveTable MoveTable;
+		FHLtC_CombatWorld DeadlineWorld(MoveTable);
+		DeadlineWorld.Add(0);
+
+		FHLtC_CombatInput AttackInput;
+		AttackInput.AddPress(HLtC::Input_LightAttack, 0);
+		DeadlineWorld.Step(&AttackInput, FixedTimestep); // Starts the first attack
+		DeadlineWorld.Step(&AttackInput, FixedTimestep); // Too soon, so it's buffered
+
+		const uint16_t FirstMove = DeadlineWorld.AttackMove[0];
+		const uint16_t NextMove = MoveTable.GetNextMove({ FirstMove, 0 }, EHLtC_AttackType::Light);
+		const int64_t WindowOpens = DeadlineWorld.StaticActionEnd[0] - HLtC::ToTimeUnits(DeadlineWorld.AdditionalAttackBufferTiming[0]);
+		const bool bBuffered = DeadlineWorld.HasFlag(0, HLtC::Flag_AttackBuffered) && NextMove != HLtC::InvalidMove;
+
+		const FHLtC_CombatInput NoInput;
+		DeadlineWorld.Step(&NoInput, MoveTable.GetMove(FirstMove).Duration); // Past both the window and the end of the first attack
+
+		return bBuffered && DeadlineWorld.Clock > WindowOpens && DeadlineWorld.HasFlag(0, HLtC::Flag_StaticAction)
+			&& DeadlineWorld.AttackMove[0] == NextMove && DeadlineWorld.Action[0] == EHLtC_PlayerAction::LightAttack
+			&& DeadlineWorld.StaticActionEnd[0] == WindowOpens + HLtC::ToTimeUnits(MoveTable.GetMove(NextMove).Duration);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Hits
+
+	/** A frame where every combatant attacks, spread over an arena as densely as a crowded fight. The grid must find exactly the hits brute force does, in the same order */
+	bool TestHits()
+	{
+		const int32_t NumHitCombatants = 512;
+		const FHLtC_MoveTable MoveTable;
+		uint32_t Seed = 1u;
+
+		FHLtC_CombatantBounds Bounds;
+		Bounds.SetNum(NumHitCombatants);
+		const float ArenaSize = std::sqrt(static_cast<float>(NumHitCombatants)) * 250.0f;
+		std::vector<FHLtC_Attack> Attacks;
+		for (int32_t Index = 0; Index < NumHitCombatants; Index++)
+		{
+			const float Angle = static_cast<float>(NextRandom(Seed) % 3600) * (3.14159265f / 1800.0f);
+			Bounds.X[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (ArenaSize / 10000.0f);
+			Bounds.Y[Index] = static_cast<float>(NextRandom(Seed) % 10000) * (ArenaSize / 10000.0f);
+			Bounds.Z[Index] = 96.0f + static_cast<float>(NextRandom(Seed) % 200); // Some stand on ledges out of reach
+			Bounds.ForwardX[Index] = std::cos(Angle);
+			Bounds.ForwardY[Index] = std::sin(Angle);
+			Bounds.Radius[Index] = 42.0f;
+			Bounds.HalfHeight[Index] = 96.0f;
+			Bounds.Blocking[Index] = NextRandom(Seed) % 4 == 0;
+			Bounds.Invulnerable[Index] = NextRandom(Seed) % 8 == 0;
+			Attacks.push_back({ Index, static_cast<uint16_t>(NextRandom(Seed) % MoveTable.NumMoves()) });
+		}
+
+		FHLtC_HitResolver HitResolver;
+		std::vector<FHLtC_HitEvent> Hits;
+		std::vector<FHLtC_HitEvent> BruteForceHits;
+		HitResolver.Resolve(Bounds, MoveTable, Attacks.data(), NumHitCombatants, Hits);
+		FHLtC_HitResolver::ResolveBruteForce(Bounds, MoveTable, Attacks.data(), NumHitCombatants, BruteForceHits);
+
+		bool bHitsMatch = !Hits.empty() && Hits.size() == BruteForceHits.size();
+		for (size_t Hit = 0; bHitsMatch && Hit < Hits.size(); Hit++)
+		{
+			bHitsMatch = Hits[Hit].Attacker == BruteForceHits[Hit].Attacker && Hits[Hit].Target == BruteForceHits[Hit].Target && Hits[Hit].bBlocked == BruteForceHits[Hit].bBlocked;
+		}
+		return bHitsMatch;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Targeting
+
+	/** Seekers looking around a crowd of targets, some moved, removed and stacked on the same spot. The grid queries, four at a time with SSE where it's available, must pick what scoring every target one at a time picks */
+	bool TestTargeting()
+	{
+		const int32_t NumTargets = 1024;
+		const int32_t NumQueries = 512;
+		const float ArenaSize = 8000.0f;
+		uint32_t Seed = 1u;
+
+		const auto RandomPosition = [&Seed, ArenaSize]()
+		{
+			return static_cast<float>(NextRandom(Seed) % 10000) * (ArenaSize / 10000.0f) - ArenaSize * 0.5f;
+		};
+
+		FHLtC_TargetIndex Index;
+		std::vector<int32_t> Targets;
+		float LastX = 0.0f;
+		float LastY = 0.0f;
+		for (int32_t Target = 0; Target < NumTargets; Target++)
+		{
+			if (Target == 0 || NextRandom(Seed) % 16 != 0) // The rest share the previous targets spot, so their scores tie
+			{
+				LastX = RandomPosition();
+				LastY = RandomPosition();
+			}
+			Targets.push_back(Index.Add(LastX, LastY, static_cast<float>(NextRandom(Seed) % 400)));
+		}
+
+		for (int32_t Target = 0; Target < NumTargets; Target++)
+		{
+			if (NextRandom(Seed) % 8 == 0)
+			{
+				Index.Remove(Targets[Target]);
+			}
+
+			else if (NextRandom(Seed) % 4 == 0)
+			{
+				Index.Update(Targets[Target], RandomPosition(), RandomPosition(), static_cast<float>(NextRandom(Seed) % 400));
+			}
+		}
+
+		int32_t NumFound = 0;
+		for (int32_t Query = 0; Query < NumQueries; Query++)
+		{
+			const float ViewAngle = static_cast<float>(NextRandom(Seed) % 3600) * (3.14159265f / 1800.0f);
+			const int32_t Seeker = Targets[NextRandom(Seed) % NumTargets];
+			FHLtC_TargetQuery TargetQuery;
+			TargetQuery.X = RandomPosition();
+			TargetQuery.Y = RandomPosition();
+			TargetQuery.Z = 100.0f;
+			TargetQuery.ViewX = std::cos(ViewAngle);
+			TargetQuery.ViewY = std::sin(ViewAngle);
+			TargetQuery.Ignore = Index.IsValid(Seeker) ? Seeker : -1;
+
+			const int32_t Best = Index.FindBest(TargetQuery);
+			if (Best != Index.FindBestBruteForce(TargetQuery))
+			{
+				return false;
+			}
+
+			// Turn from the picked target, or from the view when there's none
+			for (const bool bRight : { true, false })
+			{
+				const int32_t Next = Index.FindNext(TargetQuery, Best, bRight);
+				if (Next != Index.FindNextBruteForce(TargetQuery, Best, bRight))
+				{
+					return false;
+				}
+				NumFound += Next >= 0 ? 1 : 0;
+			}
+			NumFound += Best >= 0 ? 1 : 0;
+		}
+		return NumFound > NumQueries; // Most queries must find something, or the comparisons prove little
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Bots
+
+	/** Bots paired off against each other across an arena, walking on their decisions. One run decides each slice in one go, the other splits every slice across threads, and both must end up in the same place */
+	bool TestBots()
+	{
+		const int32_t NumBots = 256;
+		const int32_t NumBotSteps = 600;
+		const int32_t DecisionInterval = 4;
+		const int32_t NumBotThreads = 4;
+		const uint32_t Seed = 1u;
+		const FHLtC_MoveTable MoveTable;
+		struct FBotRun
+		{
+			FHLtC_CombatWorld World;
+			FHLtC_BotBrain Brain;
+			FHLtC_CombatantBounds Bounds;
+			std::vector<FHLtC_CombatInput> Inputs;
+		};
+		FBotRun BotRuns[2] = { { FHLtC_CombatWorld(MoveTable), FHLtC_BotBrain(), FHLtC_CombatantBounds(), {} }, { FHLtC_CombatWorld(MoveTable), FHLtC_BotBrain(), FHLtC_CombatantBounds(), {} } };
+		const float BotArenaSize = std::sqrt(static_cast<float>(NumBots)) * 400.0f;
+		for (FBotRun& Run : BotRuns)
+		{
+			uint32_t BotSeed = Seed;
+			Run.World.Reserve(NumBots);
+			Run.Bounds.SetNum(NumBots);
+			Run.Inputs.resize(NumBots);
+			for (int32_t Index = 0; Index < NumBots; Index++)
+			{
+				Run.World.Add(0);
+				Run.World.SetControlState(Index, EHLtC_ControlState::Action);
+				Run.Bounds.X[Index] = static_cast<float>(NextRandom(BotSeed) % 10000) * (BotArenaSize / 10000.0f);
+				Run.Bounds.Y[Index] = static_cast<float>(NextRandom(BotSeed) % 10000) * (BotArenaSize / 10000.0f);
+				Run.Bounds.Z[Index] = 96.0f;
+				Run.Bounds.ForwardX[Index] = 1.0f;
+				Run.Bounds.Radius[Index] = 42.0f;
+				Run.Bounds.HalfHeight[Index] = 96.0f;
+				Run.Brain.Add(Index, (Index ^ 1) < NumBots ? Index ^ 1 : -1, NextRandom(BotSeed));
+			}
+		}
+
+		uint32_t NumBotAttacks = 0;
+		for (int32_t Step = 0; Step < NumBotSteps; Step++)
+		{
+			for (int32_t RunIndex = 0; RunIndex < 2; RunIndex++)
+			{
+				FBotRun& Run = BotRuns[RunIndex];
+				int32_t Begin, End;
+				Run.Brain.GetDueRange(static_cast<uint32_t>(Step), DecisionInterval, Begin, End);
+
+				if (RunIndex == 0)
+				{
+					Run.Brain.DecideRange(Begin, End, Run.World, Run.Bounds);
+				}
+
+				else
+				{
+					std::vector<std::thread> Threads;
+					for (int32_t Thread = 0; Thread < NumBotThreads; Thread++)
+					{
+						const int32_t ThreadBegin = Begin + (End - Begin) * Thread / NumBotThreads;
+						const int32_t ThreadEnd = Begin + (End - Begin) * (Thread + 1) / NumBotThreads;
+						Threads.emplace_back([&Run, ThreadBegin, ThreadEnd]() { Run.Brain.DecideRange(ThreadBegin, ThreadEnd, Run.World, Run.Bounds); });
+					}
+					for (std::thread& Thread : Threads)
+					{
+						Thread.join();
+					}
+				}
+
+				for (int32_t Index = 0; Index < NumBots; Index++)
+				{
+					const FHLtC_BotCommand Command = Run.Brain.TakeCommand(Index, FixedTimestep);
+					Run.Inputs[Index] = FHLtC_CombatInput();
+					Command.AppendTo(Run.Inputs[Index]);
+					NumBotAttacks += RunIndex == 0 && (Command.Presses & (HLtC::Input_LightAttack | HLtC::Input_HeavyAttack)) != 0 ? 1 : 0;
+
+					if (!Run.World.HasFlag(Index, HLtC::Flag_StaticAction)) // Stand-in for the movement component, at the "Action" state speeds
+					{
+						const float Speed = (Command.Held & HLtC::Input_Sprinting) != 0 ? 600.0f : 400.0f;
+						Run.Bounds.X[Index] += Command.MoveX * Speed * FixedTimestep;
+						Run.Bounds.Y[Index] += Command.MoveY * Speed * FixedTimestep;
+					}
+				}
+				Run.World.Step(Run.Inputs.data(), FixedTimestep);
+			}
+		}
+
+		const bool bBotsMatch = BotRuns[0].World.HasSameState(BotRuns[1].World) && BotRuns[0].Brain.Action == BotRuns[1].Brain.Action
+			&& BotRuns[0].Brain.Stamina == BotRuns[1].Brain.Stamina && BotRuns[0].Bounds.X == BotRuns[1].Bounds.X && BotRuns[0].Bounds.Y == BotRuns[1].Bounds.Y;
+		return bBotsMatch && NumBotAttacks > 0; // Bots that never fight aren't being tested
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Validation
+
+	/**
+	 * Clients claim what each of their attack and block presses did, as their prediction saw it, and every eighth one cheats.
+	 * Claims are pushed from several threads into one queue, drained once a step and checked against the world before it steps the presses.
+	 * Even steps are checked in one go, odd steps split across threads. Honest claims must never look like cheats, and every altered claim must be caught
+	 */
+	bool TestValidation()
+	{
+		const int32_t NumClients = 256;
+		const int32_t NumValidationSteps = 600;
+		const int32_t NumThreads = 4;
+		const FHLtC_MoveTable MoveTable;
+		FHLtC_CombatWorld ValidationWorld(MoveTable);
+		AddCombatants(ValidationWorld, NumClients);
+
+		FHLtC_InputClaimQueue ClaimQueue(static_cast<uint32_t>(NumClients));
+		FHLtC_InputValidator Validator;
+		std::vector<FHLtC_CombatInput> ValidationInputs(NumClients);
+		std::vector<FHLtC_InputClaim> StepClaims(NumClients);
+		std::vector<uint8_t> bStepAltered(NumClients); // The claim differs from what an honest client would have sent
+		std::vector<FHLtC_InputClaim> DrainedClaims;
+		uint32_t ValidationSeed = 1u;
+		uint32_t NumClaims = 0;
+		uint32_t NumAltered = 0;
+		uint32_t NumCaught = 0; // Altered claims that weren't found valid
+		uint32_t NumHonestCheats = 0; // Honest claims found to be cheats, which must never happen
+		for (int32_t Step = 0; Step < NumValidationSteps; Step++)
+		{
+			const double StepTime = static_cast<double>(ValidationWorld.Clock) / HLtC::TimeUnitsPerSecond;
+			for (int32_t Index = 0; Index < NumClients; Index++)
+			{
+				FHLtC_CombatInput& Input = ValidationInputs[Index];
+				Input = FHLtC_CombatInput();
+				StepClaims[Index].Combatant = -1;
+
+				const uint32_t Roll = NextRandom(ValidationSeed) % 16;
+				if (Roll >= 4) // Most steps have no press. Presses land at the start of the step, as the claims see the world
+				{
+					continue;
+				}
+
+				const EHLtC_InputEvent Type = Roll < 2 ? (Roll == 0 ? EHLtC_InputEvent::LightAttack : EHLtC_InputEvent::HeavyAttack)
+					: ValidationWorld.HasFlag(Index, HLtC::Flag_Blocking) ? EHLtC_InputEvent::BlockCompleted : EHLtC_InputEvent::BlockStarted;
+				HLtC::ApplyInputEvent(Input, Type, 0);
+
+				FHLtC_InputClaim Claim = HLtC::MakeInputClaim(ValidationWorld, Index, Type);
+				Claim.Combatant = Index;
+				Claim.Time = StepTime;
+				bStepAltered[Index] = 0;
+				if (Index % 8 == 7) // Cheats: attacks claim the move after the one they get, or one that doesn't exist past the end of a chain, blocks claim to change during attacks
+				{
+					const FHLtC_InputClaim Honest = Claim;
+					if (Claim.Type == EHLtC_InputEvent::LightAttack || Claim.Type == EHLtC_InputEvent::HeavyAttack)
+					{
+						const uint16_t Ahead = Claim.Move != HLtC::InvalidMove ? MoveTable.GetMove(Claim.Move).Next[Claim.Type == EHLtC_InputEvent::HeavyAttack ? 1 : 0] : HLtC::InvalidMove;
+						Claim.Move = Ahead != HLtC::InvalidMove ? Ahead : static_cast<uint16_t>(MoveTable.NumMoves() + 5);
+					}
+
+					else
+					{
+						Claim.bChanged = 1;
+					}
+					bStepAltered[Index] = Claim.Move != Honest.Move || Claim.bChanged != Honest.bChanged;
+				}
+				StepClaims[Index] = Claim;
+			}
+
+			// Several producers at once, each with its own clients, so every client's claims still queue in order
+			std::vector<std::thread> Producers;
+			for (int32_t Thread = 0; Thread < NumThreads; Thread++)
+			{
+				Producers.emplace_back([&ClaimQueue, &StepClaims, NumClients, Thread, NumThreads]()
+				{
+					for (int32_t Index = Thread; Index < NumClients; Index += NumThreads)
+					{
+						if (StepClaims[Index].Combatant >= 0)
+						{
+							ClaimQueue.Push(StepClaims[Index]);
+						}
+					}
+				});
+			}
+			for (std::thread& Thread : Producers)
+			{
+				Thread.join();
+			}
+
+			DrainedClaims.clear();
+			FHLtC_InputClaim Claim;
+			while (ClaimQueue.Pop(Claim))
+			{
+				DrainedClaims.push_back(Claim);
+			}
+
+			Validator.BeginBatch(ValidationWorld, StepTime, DrainedClaims.data(), static_cast<int32_t>(DrainedClaims.size()));
+			if (Step % 2 == 0)
+			{
+				Validator.Validate();
+			}
+
+			else
+			{
+				std::vector<std::thread> Threads;
+				const int32_t NumGroups = Validator.NumGroups();
+				for (int32_t Thread = 0; Thread < NumThreads; Thread++)
+				{
+					Threads.emplace_back([&Validator, NumGroups, Thread, NumThreads]() { Validator.ValidateRange(NumGroups * Thread / NumThreads, NumGroups * (Thread + 1) / NumThreads); });
+				}
+				for (std::thread& Thread : Threads)
+				{
+					Thread.join();
+				}
+			}
+
+			for (size_t Verified = 0; Verified < Validator.GetClaims().size(); Verified++)
+			{
+				const int32_t Index = Validator.GetClaims()[Verified].Combatant;
+				const EHLtC_InputVerdict Verdict = Validator.GetVerdicts()[Verified];
+				NumClaims++;
+				NumAltered += bStepAltered[Index];
+				NumCaught += bStepAltered[Index] && Verdict != EHLtC_InputVerdict::Valid;
+				NumHonestCheats += !bStepAltered[Index] && HLtC::IsCheatVerdict(Verdict);
+			}
+
+			ValidationWorld.Step(ValidationInputs.data(), FixedTimestep);
+		}
+		return NumClaims > 0 && NumAltered > 0 && NumCaught == NumAltered && NumHonestCheats == 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Move table
+
+	/** One thread steps a world while another appends weapons to its move table till it's full. Nothing the world reads may move, and appending past the limits must fail */
+	bool TestMoveTableAppend()
+	{
+		const int32_t NumCombatants = 256;
+		const int32_t NumSteps = 500;
+		FHLtC_MoveTable MoveTable;
+		const std::vector<FHLtC_CombatInput> Inputs = MakeRandomInputs(NumCombatants, NumSteps, 5u);
+		FHLtC_CombatWorld AppendWorld(MoveTable);
+		AddCombatants(AppendWorld, NumCombatants);
+
+		const FHLtC_CompiledMove* FirstMove = &MoveTable.GetMove(0);
+		std::thread Stepper([&AppendWorld, &Inputs]()
+		{
+			for (int32_t Step = 0; Step < NumSteps; Step++)
+			{
+				AppendWorld.Step(Inputs.data() + static_cast<size_t>(Step) * NumCombatants, FixedTimestep);
+			}
+		});
+
+		FHLtC_MoveDefinition Definitions[8];
+		for (uint16_t Index = 0; Index < 7; Index++)
+		{
+			Definitions[Index].NextOnLight = static_cast<uint16_t>(Index + 1);
+		}
+
+		int32_t NumAdded = 0;
+		while (MoveTable.AddWeapon(Definitions, 8, 0, 0) != -1)
+		{
+			NumAdded++;
+		}
+		Stepper.join();
+
+		return NumAdded == FHLtC_MoveTable::MaxWeapons - 1 && MoveTable.NumWeapons() == FHLtC_MoveTable::MaxWeapons && &MoveTable.GetMove(0) == FirstMove
+			&& MoveTable.GetMove(static_cast<uint16_t>(MoveTable.NumMoves() - 1)).ChainIndex == 7 && AppendWorld.Clock > 0;
+	}
+
+	struct FCombatTest
+	{
+		const char* Name;
+		bool (*Run)();
+	};
+
+	const FCombatTest Tests[] =
+	{
+		{ "ParallelStep", &TestParallelStep },
+		{ "Rollback", &TestRollback },
+		{ "RollbackAttacks", &TestRollbackAttacks },
+		{ "Replay", &TestReplay },
+		{ "Replication", &TestReplication },
+		{ "Dodge", &TestDodge },
+		{ "BufferedAttackDeadline", &TestBufferedAttackDeadline },
+		{ "Hits", &TestHits },
+		{ "Targeting", &TestTargeting },
+		{ "Bots", &TestBots },
+		{ "Validation", &TestValidation },
+		{ "MoveTableAppend", &TestMoveTableAppend },
+	};
+}
+
+// Usage: HLtC_CombatCoreTests [TestName]. Runs every test without a name. Returns non-zero if any test that ran failed
+int main(int argc, char** argv)
+{
+	bool bFoundTest = false;
+	bool bPassed = true;
+	for (const FCombatTest& Test : Tests)
+	{
+		if (argc > 1 && std::strcmp(argv[1], Test.Name) != 0)
+		{
+			continue;
+		}
+
+		bFoundTest = true;
+		const bool bTestPassed = Test.Run();
+		std::printf("%s: %s\n", Test.Name, bTestPassed ? "passed" : "FAILED");
+		bPassed = bPassed && bTestPassed;
+	}
+
+	if (!bFoundTest)
+	{
+		std::printf("Unknown test '%s'\n", argv[1]);
+		return 1;
+	}
+	return bPassed ? 0 : 1;
+}
+
+#endif // HLTC_COMBAT_STANDALONE